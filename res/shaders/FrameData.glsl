@@ -0,0 +1,9 @@
+// FrameUniforms in UniformBuffer.hpp, bound at FrameBlockBinding
+layout(std140) uniform FrameData
+{
+    mat4 u_View;
+    mat4 u_Proj;
+    mat4 u_ViewProj;
+    float u_Time;
+    float u_Brightness;
+};
@@ -0,0 +1,101 @@
+// Variants (ShaderVariants, defined only when set):
+//   INSTANCED   model and color per instance, attributes 2..6
+//   TEXTURED    u_Texture * color, otherwise color alone
+//   ALPHA_TEST  discards fragments with alpha below 0.5
+//   ATLAS       with INSTANCED and TEXTURED: u_Texture is a TextureAtlas
+//               array, each instance picks its image (attributes 7, 8)
+//   BINDLESS    with ATLAS: the layer indexes TextureHandles instead, a
+//               TextureTable of ARB_bindless_texture handles
+
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec3 a_Pos;
+layout(location = 1) in vec2 a_TexCoord;
+#ifdef INSTANCED
+// per instance (divisor 1), a mat4 takes locations 2..5
+layout(location = 2) in mat4 a_Model;
+layout(location = 6) in vec4 a_Color;
+#ifdef ATLAS
+// AtlasRegion: uv offset xy, scale zw, then the page
+layout(location = 7) in vec4 a_AtlasRect;
+layout(location = 8) in float a_AtlasLayer;
+#endif
+#else
+uniform mat4 u_Model;
+uniform vec4 u_Color;
+#endif
+
+#include "FrameData.glsl"
+
+out vec2 v_TexCoord;
+out vec4 v_Color;
+#ifdef ATLAS
+flat out float v_Layer;
+#endif
+
+void main()
+{
+#ifdef INSTANCED
+    gl_Position = u_ViewProj * a_Model * vec4(a_Pos, 1.0);
+    v_Color = a_Color;
+#else
+    gl_Position = u_ViewProj * u_Model * vec4(a_Pos, 1.0);
+    v_Color = u_Color;
+#endif
+#ifdef ATLAS
+    // clamped: past its edge an image would run into its neighbours
+    v_TexCoord = a_AtlasRect.xy + clamp(a_TexCoord, 0.0, 1.0) * a_AtlasRect.zw;
+    v_Layer = a_AtlasLayer;
+#else
+    v_TexCoord = a_TexCoord;
+#endif
+}
+
+#shader fragment
+#version 330 core
+#ifdef BINDLESS
+#extension GL_ARB_bindless_texture : require
+#endif
+
+out vec4 color;
+in vec2 v_TexCoord;
+in vec4 v_Color;
+#ifdef ATLAS
+flat in float v_Layer;
+#endif
+
+#if defined(BINDLESS)
+// TextureTable::MaxTextures handles, two per uvec4 (low word first)
+layout(std140) uniform TextureHandles
+{
+    uvec4 u_TextureHandles[256];
+};
+#elif defined(ATLAS)
+uniform sampler2DArray u_Texture;
+#elif defined(TEXTURED)
+uniform sampler2D u_Texture;
+#endif
+
+#include "FrameData.glsl"
+
+void main()
+{
+#if defined(BINDLESS)
+    int slot = int(v_Layer);
+    uvec4 pair = u_TextureHandles[slot >> 1];
+    sampler2D image = sampler2D((slot & 1) == 0 ? pair.xy : pair.zw);
+    color = texture(image, v_TexCoord) * v_Color;
+#elif defined(ATLAS)
+    color = texture(u_Texture, vec3(v_TexCoord, v_Layer)) * v_Color;
+#elif defined(TEXTURED)
+    color = texture(u_Texture, v_TexCoord) * v_Color;
+#else
+    color = v_Color;
+#endif
+#ifdef ALPHA_TEST
+    if (color.a < 0.5)
+        discard;
+#endif
+    color.rgb *= u_Brightness;
+}
@@ -8,6 +8,7 @@
 #include <algorithm>
 #include <string>
 #include <memory>
+#include <cmath>
 #include "vendor/glm/gtc/matrix_transform.hpp"
 #include "vendor/imgui/imgui.h"
 #include "vendor/imgui/imgui_impl_glfw.h"
@@ -15,9 +16,26 @@
 #include "Console.hpp"
 #include "ImGuiUI.hpp"
 #include "App.hpp"
+#include "GLExtensions.hpp"
+#include "GLDebug.hpp"
+#include "ShaderCompiler.hpp"
+#include "TextureLoader.hpp"
 
-App::App()
+// bounding sphere of the unit cube mesh (half extent 0.3)
+static const float CubeRadius = 0.3f * 1.7320508f;
+
+App::App(Renderer* headlessBackend)
+    : headless(headlessBackend != nullptr), headlessBackend(headlessBackend),
+      startTime(std::chrono::steady_clock::now())
 {
+    if (headless)
+    {
+        // every GL object becomes CPU-only bookkeeping from here on
+        GLState::setHeadless(true);
+        loadResources();
+        return;
+    }
+
     initWindow();
     initGL();
     initAudio();
@@ -28,21 +46,95 @@ App::App()
 
 App::~App()
 {
-    shutdownAudio();
+    if (!headless)
+        shutdownAudio();
     shutdown();
 }
 
 void App::run()
 {
+    double lastFrame = glfwGetTime();
     while (!glfwWindowShouldClose(window))
     {
 
         glfwPollEvents();
+        // the frame boundary: nothing is queued that could still
+        // reference a shader or texture being replaced
+        if (assets)
+            assets->update();
+        TextureLoader::update();
+        TextureResidency::update();
+        ResourceCache::update();
         update();
+
+        double renderStart = glfwGetTime();
         render();
+        double renderEnd = glfwGetTime();
+
         renderImGuiWindow();
         glfwSwapBuffers(window);
+        GLDebug::flush();
+
+        // exponential moving average so the numbers are readable in the UI
+        double now = glfwGetTime();
+        stats.renderCpuMs += ((float)((renderEnd - renderStart) * 1000.0) - stats.renderCpuMs) * 0.1f;
+        stats.frameMs += ((float)((now - lastFrame) * 1000.0) - stats.frameMs) * 0.1f;
+        lastFrame = now;
+    }
+}
+
+void App::runHeadless(int frames, int stressInstances)
+{
+    stats.stressInstances = stressInstances;
+    addObject(gfx->cubeMesh);
+    addObject(gfx->pyramidMesh);
+    for (size_t i = 0; i < controls.size(); ++i)
+    {
+        controls[i].moveX = -0.5f + (float)i;
+        controls[i].rotatespeed = 0.02f;
+    }
+
+    double updateTotal = 0.0, renderTotal = 0.0;
+    double lastFrame = clockSeconds();
+    double runStart = lastFrame;
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        double updateStart = clockSeconds();
+        update();
+        double renderStart = clockSeconds();
+        render();
+        double renderEnd = clockSeconds();
+
+        updateTotal += renderStart - updateStart;
+        renderTotal += renderEnd - renderStart;
+        stats.renderCpuMs += ((float)((renderEnd - renderStart) * 1000.0) - stats.renderCpuMs) * 0.1f;
+        stats.frameMs += ((float)((renderEnd - lastFrame) * 1000.0) - stats.frameMs) * 0.1f;
+        lastFrame = renderEnd;
     }
+
+    double n = frames > 0 ? (double)frames : 1.0;
+    Console::LOGN("[Headless] " + std::to_string(frames) + " frames, " +
+                      std::to_string(stressInstances) + " stress instances, " +
+                      std::to_string((lastFrame - runStart) * 1000.0) + " ms total",
+                  Color::GREEN);
+    Console::LOGN("  update " + std::to_string(updateTotal * 1000.0 / n) + " ms/frame, render " +
+                  std::to_string(renderTotal * 1000.0 / n) + " ms/frame");
+    Console::LOGN("  drawn " + std::to_string(stats.drawnInstances) + ", culled " +
+                  std::to_string(stats.culledInstances) + ", packets " +
+                  std::to_string(stats.queue.packets) + ", draw calls " +
+                  std::to_string(stats.queue.drawCalls));
+    Console::LOGN("  binds " + std::to_string(stats.glState.bindsIssued) + " issued / " +
+                  std::to_string(stats.glState.bindsSkipped) + " skipped, uniforms " +
+                  std::to_string(stats.glState.uniformsIssued) + " issued / " +
+                  std::to_string(stats.glState.uniformsSkipped) + " skipped (last frame)");
+}
+
+// glfwGetTime needs glfwInit, which needs a display
+double App::clockSeconds() const
+{
+    if (!headless)
+        return glfwGetTime();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
 }
 
 void App::initWindow()
@@ -61,6 +153,11 @@ void App::initWindow()
         glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     #endif
 
+    #if !GL_ERROR_CHECKS
+        // GLCall is compiled out, errors come from the KHR_debug callback
+        glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+    #endif
+
     App::window = glfwCreateWindow(940, 680, "OpenGL Window", NULL, NULL);
     if (!window)
     {
@@ -84,6 +181,15 @@ void App::initGL()
         return;
     }
 
+    GLExtensions::load();
+#if !GL_ERROR_CHECKS
+    GLDebug::install();
+#endif
+    // before any Shader exists, so they all compile in the background
+    ShaderCompiler::init(window);
+    // likewise for textures, decoded off the main thread
+    TextureLoader::init();
+
     glEnable(GL_DEPTH_TEST);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glEnable(GL_BLEND);
@@ -105,21 +211,8 @@ void App::initImGui()
     auto objPanel = std::make_shared<UIObjectListPanel>(
         &objects, &controls, &triangles, &clearColor, &objectBrightness, &backgroundBrightness);
 
-    objPanel->onAddObject = [this]()
-    {
-        TriangleInstance t;
-        t.position = {0.0f, 0.0f, 0.0f};
-        t.rotation = {0.0f, 0.0f, 0.0f};
-        t.scale = {1.0f, 1.0f, 1.0f};
-        t.color = {1.0f, 1.0f, 1.0f, 1.0f};
-
-        triangles.push_back(t);
-        controls.push_back(ObjectControl{
-        0.0f,  // moveX
-        0.0f,  // moveY
-        0.0f   // rotate speed
-    });
-    };
+    objPanel->onAddObject = [this]() { addObject(gfx->cubeMesh); };
+    objPanel->onAddPyramid = [this]() { addObject(gfx->pyramidMesh); };
 
     objPanel->onRemoveLast = [this]()
     {
@@ -146,6 +239,7 @@ void App::initImGui()
     };
 
     uiRoot->add(objPanel);
+    uiRoot->add(std::make_shared<UIStatsPanel>(&stats));
 }
 
 void App::initImGuiWindow()
@@ -194,9 +288,33 @@ void App::renderImGuiWindow()
     ImGui::SetCurrentContext(mainImGuiContext);
 }
 
+void App::addObject(Graphicsengine::ObjectId mesh)
+{
+    TriangleInstance t;
+    t.mesh = mesh;
+    t.position = {0.0f, 0.0f, 0.0f};
+    t.rotation = {0.0f, 0.0f, 0.0f};
+    t.scale = {1.0f, 1.0f, 1.0f};
+    t.color = {1.0f, 1.0f, 1.0f, 1.0f};
+
+    triangles.push_back(t);
+    controls.push_back(ObjectControl{
+        0.0f, // moveX
+        0.0f, // moveY
+        0.0f  // rotate speed
+    });
+}
+
 void App::loadResources()
 {
-    gfx = new Graphicsengine(window);
+    gfx = new Graphicsengine(window, headlessBackend);
+    // loading is the one place allowed to wait on the compiler
+    gfx->warmUp();
+    if (!headless)
+    {
+        assets = new AssetWatcher("res");
+        gfx->watchAssets(*assets);
+    }
 
     objects.clear();
     controls.clear();   // ← NOTHING ELSE
@@ -215,7 +333,14 @@ void App::render()
         adjustedClear.z,
         adjustedClear.w));
 
-    float time = (float)glfwGetTime();
+    gfx->beginFrame((float)clockSeconds(), objectBrightness);
+    buildStressInstances();
+
+    // the first stressInstances entries are static, the user's cubes follow
+    size_t stressCount = (size_t)stats.stressInstances;
+    instanceModels.resize(stressCount + triangles.size());
+    instanceColors.resize(stressCount + triangles.size());
+    culler.resize(stressCount + triangles.size());
 
     for (size_t i = 0; i < triangles.size(); ++i)
     {
@@ -226,9 +351,79 @@ void App::render()
         model = glm::rotate(model, controls[i].angle, {0, 1, 0});
         model = glm::scale(model, t.scale);
 
-        gfx->drawTriangle(model, t.color);
+        instanceModels[stressCount + i] = model;
+        instanceColors[stressCount + i] = t.color;
+        culler.setSphere(stressCount + i, t.position,
+                         CubeRadius * std::max(t.scale.x, std::max(t.scale.y, t.scale.z)));
+    }
+
+    // only what survives the frustum test is streamed to the GPU
+    culler.setViewProj(gfx->proj * gfx->view);
+    const std::vector<uint32_t> &visible = culler.cull();
+
+    // stress cubes go out as one instanced run, the user's objects
+    // (mixed meshes) through the batched multi-draw
+    visibleModels.clear();
+    visibleColors.clear();
+    for (uint32_t index : visible)
+    {
+        if (index < stressCount)
+        {
+            visibleModels.push_back(instanceModels[index]);
+            visibleColors.push_back(instanceColors[index]);
+        }
+        else
+        {
+            gfx->draw(triangles[index - stressCount].mesh, instanceModels[index], instanceColors[index]);
+        }
+    }
+
+    gfx->drawInstances(visibleModels.data(), visibleColors.data(), visibleModels.size());
+    gfx->endFrame();
+
+    stats.drawnInstances = culler.visibleCount();
+    stats.culledInstances = culler.culledCount();
+    stats.queue = gfx->getQueueStats();
+    stats.glState = GLState::counters();
+    stats.streamStalls = gfx->getStreamStalls();
+    if (assets)
+        stats.assets = assets->getStats();
+    stats.textures = TextureLoader::getStats();
+    stats.residency = TextureResidency::getStats();
+    stats.resources = ResourceCache::getStats();
+}
+
+// ------------------------------------------------------------
+// Stress grid: N small cubes filling a box in front of the camera
+// ------------------------------------------------------------
+void App::buildStressInstances()
+{
+    if (builtStressInstances == stats.stressInstances)
+        return;
+
+    int count = stats.stressInstances;
+    instanceModels.resize(count);
+    instanceColors.resize(count);
+    culler.resize(count);
+
+    int side = (int)std::ceil(std::cbrt((double)count));
+    float spacing = side > 1 ? 2.4f / (float)(side - 1) : 0.0f;
+    float scale = side > 1 ? 1.5f / (float)side : 0.2f;
+
+    for (int i = 0; i < count; ++i)
+    {
+        int x = i % side;
+        int y = (i / side) % side;
+        int z = i / (side * side);
+
+        glm::vec3 pos(-1.2f + x * spacing, -1.2f + y * spacing, -z * spacing);
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), pos);
+        instanceModels[i] = glm::scale(model, glm::vec3(scale));
+        culler.setSphere(i, pos, CubeRadius * scale);
+        instanceColors[i] = glm::vec4((float)x / side, (float)y / side, 1.0f - (float)z / side, 1.0f);
     }
 
+    builtStressInstances = count;
 }
 
 glm::vec2 App::screenToWorld(double mx, double my)
@@ -252,6 +447,19 @@ void App::update()
     {
         t.color = {0.744f, 0.907f, 0.702f, 1.0f};
     }
+
+    if (headless)
+    {
+        // no mouse or UI; the controls still drive the objects
+        for (size_t i = 0; i < triangles.size(); ++i)
+        {
+            triangles[i].position.x = controls[i].moveX;
+            triangles[i].position.y = controls[i].moveY;
+            controls[i].angle += controls[i].rotatespeed;
+        }
+        return;
+    }
+
     ImGui::SetCurrentContext(mainImGuiContext);
     ImGuiIO io = ImGui::GetIO();
     if (io.WantCaptureMouse)
@@ -351,7 +559,12 @@ void App::shutdownImGuiWindow()
 
 void App::shutdown()
 {
+    delete assets;
+    assets = nullptr;
     delete gfx;
+    ResourceCache::clear();
+    TextureLoader::shutdown();
+    ShaderCompiler::shutdown();
 
     shutdownImGuiWindow();
     if (mainImGuiContext)
@@ -367,5 +580,6 @@ void App::shutdown()
         window = nullptr;
     }
 
-    glfwTerminate();
+    if (!headless)
+        glfwTerminate();
 }
\ No newline at end of file
@@ -2,7 +2,13 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include<vector>
+#include <chrono>
 #include "Graphicsengine.hpp"
+#include "GLState.hpp"
+#include "FrustumCuller.hpp"
+#include "TextureLoader.hpp"
+#include "TextureResidency.hpp"
+#include "ResourceCache.hpp"
 #include "vendor/imgui/imgui.h"
 
 #include <SDL2/SDL.h>
@@ -11,6 +17,7 @@
 
 
 struct TriangleInstance {
+    Graphicsengine::ObjectId mesh = 0;
     glm::vec3 position;
     glm::vec3 rotation;
     glm::vec3 scale;
@@ -34,13 +41,36 @@ struct ObjectControl
     float angle = 0.0f;
     
 };
+// Per-frame numbers shown in the stats panel.
+struct FrameStats
+{
+    int stressInstances = 0;     // extra cubes laid out on a grid, for scaling tests
+    size_t drawnInstances = 0;
+    size_t culledInstances = 0;
+    float renderCpuMs = 0.0f;    // App::render, smoothed
+    float frameMs = 0.0f;        // whole frame, smoothed
+    RenderQueueStats queue;      // last Renderer::Flush
+    GLStateCounters glState;     // binds / uniforms issued vs skipped
+    unsigned int streamStalls = 0; // instance stream fence waits, total
+    AssetReloadStats assets;     // hot reloads so far
+    TextureLoadStats textures;   // TextureLoader, uploads in the last frame
+    TextureResidencyStats residency; // texture memory against its budget
+    ResourceCacheStats resources; // shared textures and shaders
+};
+
 class UIWindow; 
 
 class App {
 public:
-    App();
+    // headlessBackend: run without window, GL context, audio or UI, drawing
+    // through this renderer (NullRenderer / RecordingRenderer), which the
+    // engine takes ownership of
+    App(Renderer* headlessBackend = nullptr);
     ~App();
     void run();
+    // fixed number of update() + render() frames with `stressInstances`
+    // grid cubes plus one cube and one pyramid; prints CPU timings
+    void runHeadless(int frames, int stressInstances);
 
     std::vector<ScreenObjeect> objects;
     std::vector<ObjectControl> controls;
@@ -57,7 +87,19 @@ private:
 
     std::shared_ptr<UIWindow> uiRoot;
     Graphicsengine* gfx = nullptr;
+    // windowed only; swaps edited res/ files in between frames
+    AssetWatcher* assets = nullptr;
     std::vector<TriangleInstance> triangles;
+    std::vector<glm::mat4> instanceModels;
+    std::vector<glm::vec4> instanceColors;
+    std::vector<glm::mat4> visibleModels;
+    std::vector<glm::vec4> visibleColors;
+    FrustumCuller culler;
+    FrameStats stats;
+    int builtStressInstances = -1;
+    bool headless = false;
+    Renderer* headlessBackend = nullptr;
+    std::chrono::steady_clock::time_point startTime;
 
     void initWindow();
     void initGL();
@@ -67,6 +109,9 @@ private:
 
     void update();
     void render();
+    void addObject(Graphicsengine::ObjectId mesh);
+    double clockSeconds() const;
+    void buildStressInstances();
     void renderImGuiWindow();  
 
     void shutdownImGuiWindow(); 
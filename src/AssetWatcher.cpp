@@ -0,0 +1,345 @@
+#include "AssetWatcher.hpp"
+#include "Shader.hpp"
+#include "ShaderCache.hpp"
+#include "Console.hpp"
+#include "TextureLoader.hpp"
+#include "vendor/stb_image/stb_image.h"
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <chrono>
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    std::string normalPath(const std::filesystem::path &path)
+    {
+        return path.lexically_normal().generic_string();
+    }
+
+    bool readFile(const std::string &path, std::vector<unsigned char> &data)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    // textures: the file; shaders: the text with its includes pasted in
+    bool readAsset(const std::string &path, bool isTexture, std::vector<unsigned char> &data,
+                   std::vector<std::string> &files)
+    {
+        if (isTexture)
+            return readFile(path, data);
+        std::string text;
+        if (!Shader::expandIncludes(path, text, files))
+            return false;
+        data.assign(text.begin(), text.end());
+        return true;
+    }
+}
+
+AssetWatcher::AssetWatcher(const std::string &root) : m_Root(normalPath(root))
+{
+    m_Thread = std::thread(&AssetWatcher::watchLoop, this);
+}
+
+AssetWatcher::~AssetWatcher()
+{
+    m_Quit = true;
+    m_Thread.join();
+
+    for (Compiling &compiling : m_Compiling)
+        delete compiling.shader;
+    for (Loading &loading : m_Loading)
+        delete loading.texture;
+}
+
+void AssetWatcher::watchShader(const std::string &path, Shader **slot, const std::string &defines)
+{
+    watch(path, slot, nullptr, defines);
+}
+
+void AssetWatcher::watchTexture(const std::string &path, Texture **slot)
+{
+    watch(path, nullptr, slot, "");
+}
+
+void AssetWatcher::watch(const std::string &path, Shader **shader, Texture **texture, const std::string &defines)
+{
+    Asset asset;
+    asset.path = normalPath(path);
+    asset.shader = shader;
+    asset.texture = texture;
+    asset.defines = defines;
+    // what is loaded now, so saving it unchanged is a no-op
+    std::vector<unsigned char> data;
+    if (readAsset(asset.path, texture != nullptr, data, asset.files))
+        asset.hash = ShaderCache::hash(data.data(), data.size());
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Assets.push_back(asset);
+}
+
+void AssetWatcher::fileChanged(const std::string &path)
+{
+    std::vector<size_t> affected;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (size_t i = 0; i < m_Assets.size(); ++i)
+        {
+            const Asset &asset = m_Assets[i];
+            if (asset.path == path || std::find(asset.files.begin(), asset.files.end(), path) != asset.files.end())
+                affected.push_back(i);
+        }
+    }
+    for (size_t index : affected)
+        reload(index);
+}
+
+void AssetWatcher::reload(size_t index)
+{
+    std::string path;
+    bool isTexture;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        path = m_Assets[index].path;
+        isTexture = m_Assets[index].texture != nullptr;
+    }
+
+    // gone mid-save (rename-over editors); its next event brings it back
+    std::vector<unsigned char> data;
+    std::vector<std::string> files;
+    if (!readAsset(path, isTexture, data, files) || data.empty())
+        return;
+
+    uint64_t hash = ShaderCache::hash(data.data(), data.size());
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Assets[index].hash == hash)
+        {
+            m_Unchanged++;
+            return;
+        }
+        m_Assets[index].hash = hash;
+        // an edit can add or drop includes
+        m_Assets[index].files = files;
+    }
+
+    Change change;
+    change.asset = index;
+    // just the header; TextureLoader decodes it again anyway
+    change.decodes = isTexture && stbi_info_from_memory(data.data(), (int)data.size(), nullptr, nullptr, nullptr);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Changes.push_back(change);
+}
+
+void AssetWatcher::watchLoop()
+{
+#ifdef __linux__
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+    {
+        Console::LOGN("AssetWatcher: inotify unavailable, hot reload is off", Color::YELLOW);
+        return;
+    }
+
+    // inotify isn't recursive: one watch per directory, new ones included
+    std::unordered_map<int, std::string> directories;
+    auto addDirectory = [&](const std::string &directory)
+    {
+        int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (wd >= 0)
+            directories[wd] = directory;
+    };
+    addDirectory(m_Root);
+    std::error_code error;
+    for (std::filesystem::recursive_directory_iterator it(m_Root, error), end; !error && it != end;
+         it.increment(error))
+    {
+        if (it->is_directory(error))
+            addDirectory(normalPath(it->path()));
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    while (!m_Quit)
+    {
+        // wakes up now and then to see m_Quit
+        pollfd pending = {fd, POLLIN, 0};
+        if (poll(&pending, 1, 100) <= 0)
+            continue;
+
+        ssize_t length;
+        while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char *at = buffer; at < buffer + length;)
+            {
+                const inotify_event *event = reinterpret_cast<const inotify_event *>(at);
+                at += sizeof(inotify_event) + event->len;
+
+                auto directory = directories.find(event->wd);
+                if (directory == directories.end() || event->len == 0)
+                    continue;
+                std::string path = normalPath(directory->second + "/" + event->name);
+
+                if (event->mask & IN_ISDIR)
+                    addDirectory(path);
+                else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                    fileChanged(path);
+            }
+        }
+    }
+    close(fd);
+#else
+    // no inotify: compare modification times of the watched files
+    std::unordered_map<std::string, std::filesystem::file_time_type> times;
+    while (!m_Quit)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+        std::vector<std::string> paths;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            for (const Asset &asset : m_Assets)
+                paths.push_back(asset.path);
+        }
+        for (const std::string &path : paths)
+        {
+            std::error_code error;
+            auto time = std::filesystem::last_write_time(path, error);
+            if (error)
+                continue;
+            auto known = times.find(path);
+            if (known == times.end())
+                times[path] = time;
+            else if (known->second != time)
+            {
+                known->second = time;
+                fileChanged(path);
+            }
+        }
+    }
+#endif
+}
+
+void AssetWatcher::update()
+{
+    std::vector<Change> changes;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        changes.swap(m_Changes);
+    }
+    m_Stats.unchanged = m_Unchanged;
+
+    for (Change &change : changes)
+    {
+        Asset &asset = m_Assets[change.asset];
+        if (asset.texture)
+        {
+            // released and destroyed (ResourceCache::getSlot); nothing to reload
+            if (!*asset.texture)
+                continue;
+            if (!change.decodes)
+            {
+                m_Stats.failed++;
+                Console::LOGN("AssetWatcher: can't decode " + asset.path + ", keeping the last good one",
+                              Color::YELLOW);
+                continue;
+            }
+            // a newer save supersedes one still loading
+            for (size_t i = 0; i < m_Loading.size(); ++i)
+            {
+                if (m_Loading[i].asset == change.asset)
+                {
+                    delete m_Loading[i].texture;
+                    m_Loading.erase(m_Loading.begin() + i);
+                    break;
+                }
+            }
+            m_Loading.push_back({change.asset, TextureLoader::load(asset.path, (*asset.texture)->getSampling())});
+            continue;
+        }
+
+        // a newer save supersedes one still compiling
+        for (size_t i = 0; i < m_Compiling.size(); ++i)
+        {
+            if (m_Compiling[i].asset == change.asset)
+            {
+                delete m_Compiling[i].shader;
+                m_Compiling.erase(m_Compiling.begin() + i);
+                break;
+            }
+        }
+        // a separable stage program comes back as the same stage
+        const Shader *current = *asset.shader;
+        m_Compiling.push_back({change.asset, new Shader(asset.path, asset.defines,
+                                                        current ? current->getStages() : StageAll,
+                                                        current && current->isSeparable())});
+    }
+
+    // never waits: whatever is still compiling is looked at next frame
+    for (size_t i = 0; i < m_Compiling.size();)
+    {
+        Compiling &compiling = m_Compiling[i];
+        Asset &asset = m_Assets[compiling.asset];
+        if (compiling.shader->isReady())
+        {
+            delete *asset.shader;
+            *asset.shader = compiling.shader;
+            m_Stats.reloads++;
+            Console::LOGN("AssetWatcher: reloaded " + asset.path, Color::GREEN);
+        }
+        else if (compiling.shader->hasFailed())
+        {
+            delete compiling.shader;
+            m_Stats.failed++;
+            Console::LOGN("AssetWatcher: " + asset.path + " failed to build, keeping the last good one",
+                          Color::YELLOW);
+        }
+        else
+        {
+            ++i;
+            continue;
+        }
+        m_Compiling.erase(m_Compiling.begin() + i);
+    }
+
+    // the placeholder is never swapped in, only the uploaded texture
+    for (size_t i = 0; i < m_Loading.size();)
+    {
+        Loading &loading = m_Loading[i];
+        Asset &asset = m_Assets[loading.asset];
+        if (!*asset.texture)
+        {
+            delete loading.texture;
+        }
+        else if (loading.texture->isResident())
+        {
+            delete *asset.texture;
+            *asset.texture = loading.texture;
+            m_Stats.reloads++;
+            Console::LOGN("AssetWatcher: reloaded " + asset.path, Color::GREEN);
+        }
+        else if (loading.texture->hasFailed())
+        {
+            delete loading.texture;
+            m_Stats.failed++;
+            Console::LOGN("AssetWatcher: " + asset.path + " failed to load, keeping the last good one",
+                          Color::YELLOW);
+        }
+        else
+        {
+            ++i;
+            continue;
+        }
+        m_Loading.erase(m_Loading.begin() + i);
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include "Texture.hpp"
+
+class Shader;
+
+struct AssetReloadStats
+{
+    unsigned int reloads = 0;   // swapped in
+    unsigned int unchanged = 0; // saved with the same contents, dropped
+    unsigned int failed = 0;    // didn't build, the last good one stays
+};
+
+// Hot reload for the files under a resource root. A thread watches it
+// (inotify on Linux, file times elsewhere) and, for each watched file
+// that changed, reads and hashes it; the same contents as last time are
+// dropped.
+//
+// update(), on the main thread between frames, starts the rebuild:
+// textures go to TextureLoader (decode, mips and upload off the frame),
+// shaders are created and left to ShaderCompiler, so a reload never
+// blocks a frame and is swapped in once ready. The slot the engine draws
+// with (Shader** / Texture**) then points at the new object and the old
+// one is deleted; if it fails to build, the old one stays.
+class AssetWatcher
+{
+public:
+    explicit AssetWatcher(const std::string &root = "res");
+    ~AssetWatcher();
+
+    AssetWatcher(const AssetWatcher&) = delete;
+    AssetWatcher& operator=(const AssetWatcher&) = delete;
+
+    // paths as the engine opened them ("res/shaders/Mesh.shader"); the
+    // slot must stay valid until the watcher is destroyed. A shader is
+    // rebuilt with the same defines and stages, and also when a file it
+    // #includes changes. A texture slot that went null (destroyed, see
+    // ResourceCache::getSlot) is no longer reloaded.
+    void watchShader(const std::string &path, Shader **slot, const std::string &defines = "");
+    void watchTexture(const std::string &path, Texture **slot);
+
+    void update();
+
+    const AssetReloadStats& getStats() const { return m_Stats; }
+
+private:
+    struct Asset
+    {
+        std::string path; // lexically normal, for matching events
+        Shader **shader = nullptr;
+        Texture **texture = nullptr;
+        std::string defines;
+        // shaders: path and its #includes, as of the last read
+        std::vector<std::string> files;
+        // contents last handed to update(); shaders hash the text with
+        // includes pasted in
+        uint64_t hash = 0;
+    };
+    struct Change
+    {
+        size_t asset;
+        bool decodes; // textures: stb_image takes the file
+    };
+    // a replacement still compiling, or still coming from TextureLoader
+    struct Compiling
+    {
+        size_t asset;
+        Shader *shader;
+    };
+    struct Loading
+    {
+        size_t asset;
+        Texture *texture;
+    };
+
+    std::string m_Root;
+    std::vector<Asset> m_Assets;   // under m_Mutex
+    std::vector<Change> m_Changes; // under m_Mutex, drained by update()
+    std::vector<Compiling> m_Compiling;
+    std::vector<Loading> m_Loading;
+    AssetReloadStats m_Stats;
+    std::atomic<unsigned int> m_Unchanged{0};
+
+    std::thread m_Thread;
+    std::mutex m_Mutex;
+    std::atomic<bool> m_Quit{false};
+
+    void watch(const std::string &path, Shader **shader, Texture **texture, const std::string &defines);
+    void watchLoop();
+    // watcher thread: every asset that reads `path` is reloaded
+    void fileChanged(const std::string &path);
+    // read, hash, queue
+    void reload(size_t index);
+};
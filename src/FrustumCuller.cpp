@@ -0,0 +1,95 @@
+#include "FrustumCuller.hpp"
+#include "Simd.hpp"
+#include <cmath>
+
+void FrustumCuller::resize(size_t count)
+{
+    size_t padded = (count + 7) & ~size_t(7);
+    m_X.resize(padded, 0.0f);
+    m_Y.resize(padded, 0.0f);
+    m_Z.resize(padded, 0.0f);
+    m_Radius.resize(padded, -1e30f);
+
+    for (size_t i = count; i < padded; ++i)
+        m_Radius[i] = -1e30f;
+    m_Count = count;
+}
+
+void FrustumCuller::setSphere(size_t index, const glm::vec3 &center, float radius)
+{
+    m_X[index] = center.x;
+    m_Y[index] = center.y;
+    m_Z[index] = center.z;
+    m_Radius[index] = radius;
+}
+
+void FrustumCuller::setViewProj(const glm::mat4 &m)
+{
+    // row r of the matrix is (m[0][r], m[1][r], m[2][r], m[3][r])
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            m_Planes[i * 2 + 0][c] = m[c][3] + m[c][i]; // left, bottom, near
+            m_Planes[i * 2 + 1][c] = m[c][3] - m[c][i]; // right, top, far
+        }
+    }
+
+    for (auto &plane : m_Planes)
+    {
+        float len = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if (len > 0.0f)
+            for (float &v : plane)
+                v /= len;
+    }
+}
+
+const std::vector<uint32_t> &FrustumCuller::cull()
+{
+    m_Visible.clear();
+    m_Visible.reserve(m_Count);
+
+    simd::f32 nx[6], ny[6], nz[6], d[6];
+    for (int p = 0; p < 6; ++p)
+    {
+        nx[p] = simd::set1(m_Planes[p][0]);
+        ny[p] = simd::set1(m_Planes[p][1]);
+        nz[p] = simd::set1(m_Planes[p][2]);
+        d[p] = simd::set1(m_Planes[p][3]);
+    }
+
+    const int allLanes = (1 << simd::Width) - 1;
+    size_t padded = m_X.size();
+
+    for (size_t i = 0; i < padded; i += simd::Width)
+    {
+        simd::f32 x = simd::load(&m_X[i]);
+        simd::f32 y = simd::load(&m_Y[i]);
+        simd::f32 z = simd::load(&m_Z[i]);
+        simd::f32 negR = simd::sub(simd::set1(0.0f), simd::load(&m_Radius[i]));
+
+        // inside all six planes: dot(n, c) + d >= -r
+        simd::f32 inside = simd::cmpge(simd::madd(nx[0], x, simd::madd(ny[0], y, simd::madd(nz[0], z, d[0]))), negR);
+        for (int p = 1; p < 6; ++p)
+        {
+            simd::f32 dist = simd::madd(nx[p], x, simd::madd(ny[p], y, simd::madd(nz[p], z, d[p])));
+            inside = simd::andMask(inside, simd::cmpge(dist, negR));
+        }
+
+        int mask = simd::movemask(inside);
+        if (mask == allLanes)
+        {
+            for (int lane = 0; lane < simd::Width; ++lane)
+                m_Visible.push_back((uint32_t)(i + lane));
+            continue;
+        }
+        while (mask)
+        {
+            int lane = __builtin_ctz(mask);
+            m_Visible.push_back((uint32_t)(i + lane));
+            mask &= mask - 1;
+        }
+    }
+
+    return m_Visible;
+}
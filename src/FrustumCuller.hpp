@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "vendor/glm/glm.hpp"
+
+// Bounding-sphere frustum culling over SoA arrays, simd::Width spheres
+// per step (8 with AVX, 4 with SSE/NEON). Slots are indexed like the
+// caller's instance arrays, cull() returns the visible slot indices.
+class FrustumCuller
+{
+public:
+    void resize(size_t count);
+    size_t size() const { return m_Count; }
+
+    void setSphere(size_t index, const glm::vec3 &center, float radius);
+
+    // Gribb-Hartmann plane extraction from a (column-major) view-projection
+    void setViewProj(const glm::mat4 &viewProj);
+
+    // fills and returns the compact list of visible indices
+    const std::vector<uint32_t> &cull();
+
+    size_t visibleCount() const { return m_Visible.size(); }
+    size_t culledCount() const { return m_Count - m_Visible.size(); }
+
+private:
+    size_t m_Count = 0;
+    // padded to a multiple of 8; pad slots have a negative radius and
+    // are always culled
+    std::vector<float> m_X, m_Y, m_Z, m_Radius;
+
+    // plane i: dot(n, p) + d >= 0 is inside
+    float m_Planes[6][4] = {};
+
+    std::vector<uint32_t> m_Visible;
+};
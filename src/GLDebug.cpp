@@ -0,0 +1,153 @@
+#include "GLDebug.hpp"
+#include "GLExtensions.hpp"
+#include "Console.hpp"
+#include <GLFW/glfw3.h>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+namespace
+{
+    // per key, this many are printed before it goes quiet
+    const unsigned int ReportsPerKey = 3;
+    // and never more than this many lines per second overall
+    const unsigned int ReportsPerSecond = 20;
+
+    struct MessageKey
+    {
+        GLenum source;
+        GLenum type;
+        GLuint id;
+
+        bool operator<(const MessageKey &o) const
+        {
+            return std::tie(source, type, id) < std::tie(o.source, o.type, o.id);
+        }
+    };
+
+    struct MessageEntry
+    {
+        std::string text;
+        GLenum severity = 0;
+        unsigned int count = 0;
+        unsigned int reported = 0;
+        unsigned int pending = 0; // hits since the last summary
+    };
+
+    std::mutex s_Lock;
+    std::map<MessageKey, MessageEntry> s_Messages;
+    unsigned int s_Total = 0;
+    unsigned int s_ReportsThisWindow = 0;
+    double s_WindowStart = 0.0;
+    double s_LastFlush = 0.0;
+
+    const char *severityName(GLenum severity)
+    {
+        switch (severity)
+        {
+        case GL_DEBUG_SEVERITY_HIGH:   return "high";
+        case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+        case GL_DEBUG_SEVERITY_LOW:    return "low";
+        default:                       return "info";
+        }
+    }
+
+    Color severityColor(GLenum severity)
+    {
+        return severity == GL_DEBUG_SEVERITY_HIGH || severity == GL_DEBUG_SEVERITY_MEDIUM
+                   ? Color::RED
+                   : Color::YELLOW;
+    }
+
+    void APIENTRY onDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                 GLsizei length, const GLchar *message, const void *)
+    {
+        if (severity == GL_DEBUG_SEVERITY_NOTIFICATION)
+            return;
+
+        std::lock_guard<std::mutex> lock(s_Lock);
+        s_Total++;
+
+        MessageEntry &entry = s_Messages[{source, type, id}];
+        if (entry.count == 0)
+        {
+            entry.text.assign(message, length > 0 ? (size_t)length : std::char_traits<char>::length(message));
+            entry.severity = severity;
+        }
+        entry.count++;
+
+        // glfwGetTime is thread safe once GLFW is initialized
+        double now = glfwGetTime();
+        if (now - s_WindowStart >= 1.0)
+        {
+            s_WindowStart = now;
+            s_ReportsThisWindow = 0;
+        }
+
+        if (entry.reported < ReportsPerKey && s_ReportsThisWindow < ReportsPerSecond)
+        {
+            entry.reported++;
+            s_ReportsThisWindow++;
+            Console::LOGN("[OpenGL " + std::string(severityName(severity)) + "] (id " +
+                              std::to_string(id) + ") " + entry.text,
+                          severityColor(severity));
+        }
+        else
+        {
+            entry.pending++;
+        }
+    }
+}
+
+bool GLDebug::install()
+{
+    if (!GLExtensions::KHR_debug)
+    {
+        Console::LOGN("[GLDebug] KHR_debug not available, GL errors will go unreported", Color::YELLOW);
+        return false;
+    }
+
+    GLint flags = 0;
+    glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+    if (!(flags & GL_CONTEXT_FLAG_DEBUG_BIT))
+    {
+        Console::LOGN("[GLDebug] not a debug context, GL errors will go unreported", Color::YELLOW);
+        return false;
+    }
+
+    // asynchronous on purpose: no GL_DEBUG_OUTPUT_SYNCHRONOUS, the driver
+    // keeps its pipelining and we lose only the exact callsite
+    glEnable(GL_DEBUG_OUTPUT);
+    GLExtensions::DebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION,
+                                      0, nullptr, GL_FALSE);
+    GLExtensions::DebugMessageCallback(onDebugMessage, nullptr);
+    return true;
+}
+
+void GLDebug::flush()
+{
+    double now = glfwGetTime();
+    if (now - s_LastFlush < 1.0)
+        return;
+    s_LastFlush = now;
+
+    std::lock_guard<std::mutex> lock(s_Lock);
+    for (auto &it : s_Messages)
+    {
+        MessageEntry &entry = it.second;
+        if (entry.pending == 0)
+            continue;
+
+        Console::LOGN("[OpenGL " + std::string(severityName(entry.severity)) + "] (id " +
+                          std::to_string(it.first.id) + ") repeated " + std::to_string(entry.pending) +
+                          "x, " + std::to_string(entry.count) + " total",
+                      severityColor(entry.severity));
+        entry.pending = 0;
+    }
+}
+
+unsigned int GLDebug::totalMessages()
+{
+    std::lock_guard<std::mutex> lock(s_Lock);
+    return s_Total;
+}
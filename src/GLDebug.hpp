@@ -0,0 +1,24 @@
+#pragma once
+
+// KHR_debug error reporting for builds where GLCall is compiled out.
+// The driver may call back from its own thread, so messages are
+// aggregated under a lock, keyed by (source, type, id) - the id is the
+// driver's own callsite identifier, async messages carry no file/line.
+// The first few hits of each key are printed right away, the rest are
+// counted and summarized by flush().
+
+class GLDebug
+{
+public:
+    GLDebug() = delete;
+    ~GLDebug() = delete;
+
+    // needs GLExtensions::load(); returns false without KHR_debug or
+    // without a debug context
+    static bool install();
+
+    // prints suppressed counts; cheap, call once per frame
+    static void flush();
+
+    static unsigned int totalMessages();
+};
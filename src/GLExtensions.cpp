@@ -0,0 +1,181 @@
+#include "GLExtensions.hpp"
+#include <GLFW/glfw3.h>
+#include "Console.hpp"
+
+bool GLExtensions::KHR_debug = false;
+PFN_glDebugMessageCallback GLExtensions::DebugMessageCallback = nullptr;
+PFN_glDebugMessageControl GLExtensions::DebugMessageControl = nullptr;
+bool GLExtensions::ARB_buffer_storage = false;
+PFN_glBufferStorage GLExtensions::BufferStorage = nullptr;
+bool GLExtensions::ARB_multi_draw_indirect = false;
+PFN_glMultiDrawElementsIndirect GLExtensions::MultiDrawElementsIndirect = nullptr;
+bool GLExtensions::ARB_get_program_binary = false;
+PFN_glGetProgramBinary GLExtensions::GetProgramBinary = nullptr;
+PFN_glProgramBinary GLExtensions::ProgramBinary = nullptr;
+PFN_glProgramParameteri GLExtensions::ProgramParameteri = nullptr;
+bool GLExtensions::ARB_separate_shader_objects = false;
+PFN_glGenProgramPipelines GLExtensions::GenProgramPipelines = nullptr;
+PFN_glDeleteProgramPipelines GLExtensions::DeleteProgramPipelines = nullptr;
+PFN_glBindProgramPipeline GLExtensions::BindProgramPipeline = nullptr;
+PFN_glUseProgramStages GLExtensions::UseProgramStages = nullptr;
+PFN_glValidateProgramPipeline GLExtensions::ValidateProgramPipeline = nullptr;
+PFN_glGetProgramPipelineiv GLExtensions::GetProgramPipelineiv = nullptr;
+PFN_glGetProgramPipelineInfoLog GLExtensions::GetProgramPipelineInfoLog = nullptr;
+PFN_glProgramUniform1i GLExtensions::ProgramUniform1i = nullptr;
+PFN_glProgramUniform1f GLExtensions::ProgramUniform1f = nullptr;
+PFN_glProgramUniform4f GLExtensions::ProgramUniform4f = nullptr;
+PFN_glProgramUniformMatrix4fv GLExtensions::ProgramUniformMatrix4fv = nullptr;
+bool GLExtensions::ARB_compute_shader = false;
+PFN_glDispatchCompute GLExtensions::DispatchCompute = nullptr;
+PFN_glMemoryBarrier GLExtensions::MemoryBarrier = nullptr;
+bool GLExtensions::ARB_texture_storage = false;
+PFN_glTexStorage2D GLExtensions::TexStorage2D = nullptr;
+PFN_glTexStorage3D GLExtensions::TexStorage3D = nullptr;
+bool GLExtensions::ARB_texture_filter_anisotropic = false;
+float GLExtensions::MaxAnisotropy = 1.0f;
+bool GLExtensions::EXT_texture_compression_s3tc = false;
+bool GLExtensions::ARB_texture_compression_bptc = false;
+bool GLExtensions::ARB_bindless_texture = false;
+PFN_glGetTextureHandleARB GLExtensions::GetTextureHandle = nullptr;
+PFN_glMakeTextureHandleResidentARB GLExtensions::MakeTextureHandleResident = nullptr;
+PFN_glMakeTextureHandleNonResidentARB GLExtensions::MakeTextureHandleNonResident = nullptr;
+bool GLExtensions::KHR_parallel_shader_compile = false;
+PFN_glMaxShaderCompilerThreads GLExtensions::MaxShaderCompilerThreads = nullptr;
+
+namespace
+{
+    // core name first, then the extension suffixes
+    template <typename T>
+    T loadProc(const char *core, const char *ext = nullptr, const char *ext2 = nullptr)
+    {
+        GLFWglproc proc = glfwGetProcAddress(core);
+        if (!proc && ext)
+            proc = glfwGetProcAddress(ext);
+        if (!proc && ext2)
+            proc = glfwGetProcAddress(ext2);
+        return reinterpret_cast<T>(proc);
+    }
+}
+
+bool GLExtensions::hasVersion(int major, int minor)
+{
+    return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+void GLExtensions::load()
+{
+    if (hasVersion(4, 3) || glfwExtensionSupported("GL_KHR_debug") || glfwExtensionSupported("GL_ARB_debug_output"))
+    {
+        DebugMessageCallback = loadProc<PFN_glDebugMessageCallback>(
+            "glDebugMessageCallback", "glDebugMessageCallbackKHR", "glDebugMessageCallbackARB");
+        DebugMessageControl = loadProc<PFN_glDebugMessageControl>(
+            "glDebugMessageControl", "glDebugMessageControlKHR", "glDebugMessageControlARB");
+        KHR_debug = DebugMessageCallback && DebugMessageControl;
+    }
+
+    if (hasVersion(4, 4) || glfwExtensionSupported("GL_ARB_buffer_storage"))
+    {
+        BufferStorage = loadProc<PFN_glBufferStorage>("glBufferStorage", "glBufferStorageARB", "glBufferStorageEXT");
+        ARB_buffer_storage = BufferStorage != nullptr;
+    }
+
+    if (hasVersion(4, 3) ||
+        (glfwExtensionSupported("GL_ARB_multi_draw_indirect") && glfwExtensionSupported("GL_ARB_base_instance")))
+    {
+        MultiDrawElementsIndirect = loadProc<PFN_glMultiDrawElementsIndirect>(
+            "glMultiDrawElementsIndirect", "glMultiDrawElementsIndirectARB");
+        ARB_multi_draw_indirect = MultiDrawElementsIndirect != nullptr;
+    }
+
+    if (hasVersion(4, 1) || glfwExtensionSupported("GL_ARB_get_program_binary"))
+    {
+        GetProgramBinary = loadProc<PFN_glGetProgramBinary>("glGetProgramBinary");
+        ProgramBinary = loadProc<PFN_glProgramBinary>("glProgramBinary");
+        ProgramParameteri = loadProc<PFN_glProgramParameteri>("glProgramParameteri", "glProgramParameteriARB");
+
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        ARB_get_program_binary = GetProgramBinary && ProgramBinary && ProgramParameteri && formats > 0;
+    }
+
+    if (hasVersion(4, 1) || glfwExtensionSupported("GL_ARB_separate_shader_objects"))
+    {
+        GenProgramPipelines = loadProc<PFN_glGenProgramPipelines>("glGenProgramPipelines");
+        DeleteProgramPipelines = loadProc<PFN_glDeleteProgramPipelines>("glDeleteProgramPipelines");
+        BindProgramPipeline = loadProc<PFN_glBindProgramPipeline>("glBindProgramPipeline");
+        UseProgramStages = loadProc<PFN_glUseProgramStages>("glUseProgramStages");
+        ValidateProgramPipeline = loadProc<PFN_glValidateProgramPipeline>("glValidateProgramPipeline");
+        GetProgramPipelineiv = loadProc<PFN_glGetProgramPipelineiv>("glGetProgramPipelineiv");
+        GetProgramPipelineInfoLog = loadProc<PFN_glGetProgramPipelineInfoLog>("glGetProgramPipelineInfoLog");
+        ProgramUniform1i = loadProc<PFN_glProgramUniform1i>("glProgramUniform1i", "glProgramUniform1iEXT");
+        ProgramUniform1f = loadProc<PFN_glProgramUniform1f>("glProgramUniform1f", "glProgramUniform1fEXT");
+        ProgramUniform4f = loadProc<PFN_glProgramUniform4f>("glProgramUniform4f", "glProgramUniform4fEXT");
+        ProgramUniformMatrix4fv = loadProc<PFN_glProgramUniformMatrix4fv>(
+            "glProgramUniformMatrix4fv", "glProgramUniformMatrix4fvEXT");
+        // separable programs are linked with ProgramParameteri
+        if (!ProgramParameteri)
+            ProgramParameteri = loadProc<PFN_glProgramParameteri>("glProgramParameteri", "glProgramParameteriARB");
+        ARB_separate_shader_objects = GenProgramPipelines && DeleteProgramPipelines && BindProgramPipeline &&
+                                      UseProgramStages && ValidateProgramPipeline && GetProgramPipelineiv &&
+                                      GetProgramPipelineInfoLog && ProgramUniform1i && ProgramUniform1f &&
+                                      ProgramUniform4f && ProgramUniformMatrix4fv && ProgramParameteri;
+    }
+
+    if (hasVersion(4, 3) || glfwExtensionSupported("GL_ARB_compute_shader"))
+    {
+        DispatchCompute = loadProc<PFN_glDispatchCompute>("glDispatchCompute");
+        MemoryBarrier = loadProc<PFN_glMemoryBarrier>("glMemoryBarrier", "glMemoryBarrierEXT");
+        ARB_compute_shader = DispatchCompute && MemoryBarrier;
+    }
+
+    if (hasVersion(4, 2) || glfwExtensionSupported("GL_ARB_texture_storage"))
+    {
+        TexStorage2D = loadProc<PFN_glTexStorage2D>("glTexStorage2D", "glTexStorage2DEXT");
+        TexStorage3D = loadProc<PFN_glTexStorage3D>("glTexStorage3D", "glTexStorage3DEXT");
+        ARB_texture_storage = TexStorage2D != nullptr;
+    }
+
+    if (hasVersion(4, 6) || glfwExtensionSupported("GL_ARB_texture_filter_anisotropic") ||
+        glfwExtensionSupported("GL_EXT_texture_filter_anisotropic"))
+    {
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &MaxAnisotropy);
+        ARB_texture_filter_anisotropic = MaxAnisotropy > 1.0f;
+        if (!ARB_texture_filter_anisotropic)
+            MaxAnisotropy = 1.0f;
+    }
+
+    EXT_texture_compression_s3tc = glfwExtensionSupported("GL_EXT_texture_compression_s3tc") != 0;
+    ARB_texture_compression_bptc = hasVersion(4, 2) || glfwExtensionSupported("GL_ARB_texture_compression_bptc");
+
+    if (glfwExtensionSupported("GL_ARB_bindless_texture"))
+    {
+        GetTextureHandle = loadProc<PFN_glGetTextureHandleARB>("glGetTextureHandleARB");
+        MakeTextureHandleResident = loadProc<PFN_glMakeTextureHandleResidentARB>("glMakeTextureHandleResidentARB");
+        MakeTextureHandleNonResident =
+            loadProc<PFN_glMakeTextureHandleNonResidentARB>("glMakeTextureHandleNonResidentARB");
+        ARB_bindless_texture = GetTextureHandle && MakeTextureHandleResident && MakeTextureHandleNonResident;
+    }
+
+    if (glfwExtensionSupported("GL_KHR_parallel_shader_compile") ||
+        glfwExtensionSupported("GL_ARB_parallel_shader_compile"))
+    {
+        MaxShaderCompilerThreads = loadProc<PFN_glMaxShaderCompilerThreads>(
+            "glMaxShaderCompilerThreadsKHR", "glMaxShaderCompilerThreadsARB");
+        KHR_parallel_shader_compile = MaxShaderCompilerThreads != nullptr;
+    }
+
+    Console::LOGN(std::string("GL ") + std::to_string(GLVersion.major) + "." + std::to_string(GLVersion.minor) +
+                      (KHR_debug ? " +KHR_debug" : "") +
+                      (ARB_buffer_storage ? " +ARB_buffer_storage" : "") +
+                      (ARB_multi_draw_indirect ? " +ARB_multi_draw_indirect" : "") +
+                      (ARB_get_program_binary ? " +ARB_get_program_binary" : "") +
+                      (ARB_separate_shader_objects ? " +ARB_separate_shader_objects" : "") +
+                      (ARB_compute_shader ? " +ARB_compute_shader" : "") +
+                      (ARB_texture_storage ? " +ARB_texture_storage" : "") +
+                      (ARB_texture_filter_anisotropic ? " +anisotropic x" + std::to_string((int)MaxAnisotropy) : "") +
+                      (EXT_texture_compression_s3tc ? " +s3tc" : "") +
+                      (ARB_texture_compression_bptc ? " +bptc" : "") +
+                      (ARB_bindless_texture ? " +ARB_bindless_texture" : "") +
+                      (KHR_parallel_shader_compile ? " +KHR_parallel_shader_compile" : ""),
+                  Color::GREEN);
+}
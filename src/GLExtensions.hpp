@@ -0,0 +1,205 @@
+#pragma once
+#include <glad/glad.h>
+
+// glad here is generated for plain GL 3.3 core with no extensions, so
+// anything newer is declared and loaded by hand. Every entry point may
+// be null; check the matching flag before calling it.
+
+// ---- KHR_debug / GL 4.3 ----
+#ifndef GL_DEBUG_OUTPUT
+#define GL_DEBUG_OUTPUT                   0x92E0
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS       0x8242
+#define GL_CONTEXT_FLAG_DEBUG_BIT         0x00000002
+#define GL_DEBUG_SOURCE_API               0x8246
+#define GL_DEBUG_SOURCE_SHADER_COMPILER   0x8248
+#define GL_DEBUG_TYPE_ERROR               0x824C
+#define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+#define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR  0x824E
+#define GL_DEBUG_TYPE_PERFORMANCE         0x8250
+#define GL_DEBUG_SEVERITY_HIGH            0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM          0x9147
+#define GL_DEBUG_SEVERITY_LOW             0x9148
+#define GL_DEBUG_SEVERITY_NOTIFICATION    0x826B
+#endif
+
+typedef void (APIENTRYP PFN_glDebugMessageCallback)(GLDEBUGPROC callback, const void *userParam);
+typedef void (APIENTRYP PFN_glDebugMessageControl)(GLenum source, GLenum type, GLenum severity,
+                                                   GLsizei count, const GLuint *ids, GLboolean enabled);
+
+// ---- ARB_buffer_storage / GL 4.4 ----
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT  0x0040
+#define GL_MAP_COHERENT_BIT    0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT  0x0200
+#endif
+
+typedef void (APIENTRYP PFN_glBufferStorage)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+
+// ---- ARB_multi_draw_indirect + ARB_base_instance / GL 4.3 ----
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+typedef void (APIENTRYP PFN_glMultiDrawElementsIndirect)(GLenum mode, GLenum type, const void *indirect,
+                                                        GLsizei drawcount, GLsizei stride);
+
+// ---- ARB_get_program_binary / GL 4.1 ----
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH           0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS      0x87FE
+#define GL_PROGRAM_BINARY_FORMATS          0x87FF
+#endif
+
+typedef void (APIENTRYP PFN_glGetProgramBinary)(GLuint program, GLsizei bufSize, GLsizei *length,
+                                                GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP PFN_glProgramBinary)(GLuint program, GLenum binaryFormat, const void *binary,
+                                             GLsizei length);
+typedef void (APIENTRYP PFN_glProgramParameteri)(GLuint program, GLenum pname, GLint value);
+
+// ---- ARB_separate_shader_objects / GL 4.1 ----
+#ifndef GL_PROGRAM_SEPARABLE
+#define GL_PROGRAM_SEPARABLE        0x8258
+#define GL_PROGRAM_PIPELINE_BINDING 0x825A
+#define GL_VERTEX_SHADER_BIT        0x00000001
+#define GL_FRAGMENT_SHADER_BIT      0x00000002
+#define GL_GEOMETRY_SHADER_BIT      0x00000004
+#endif
+#ifndef GL_COMPUTE_SHADER_BIT
+#define GL_COMPUTE_SHADER_BIT       0x00000020
+#endif
+
+typedef void (APIENTRYP PFN_glGenProgramPipelines)(GLsizei n, GLuint *pipelines);
+typedef void (APIENTRYP PFN_glDeleteProgramPipelines)(GLsizei n, const GLuint *pipelines);
+typedef void (APIENTRYP PFN_glBindProgramPipeline)(GLuint pipeline);
+typedef void (APIENTRYP PFN_glUseProgramStages)(GLuint pipeline, GLbitfield stages, GLuint program);
+typedef void (APIENTRYP PFN_glValidateProgramPipeline)(GLuint pipeline);
+typedef void (APIENTRYP PFN_glGetProgramPipelineiv)(GLuint pipeline, GLenum pname, GLint *params);
+typedef void (APIENTRYP PFN_glGetProgramPipelineInfoLog)(GLuint pipeline, GLsizei bufSize, GLsizei *length,
+                                                         GLchar *infoLog);
+typedef void (APIENTRYP PFN_glProgramUniform1i)(GLuint program, GLint location, GLint v0);
+typedef void (APIENTRYP PFN_glProgramUniform1f)(GLuint program, GLint location, GLfloat v0);
+typedef void (APIENTRYP PFN_glProgramUniform4f)(GLuint program, GLint location, GLfloat v0, GLfloat v1,
+                                                GLfloat v2, GLfloat v3);
+typedef void (APIENTRYP PFN_glProgramUniformMatrix4fv)(GLuint program, GLint location, GLsizei count,
+                                                       GLboolean transpose, const GLfloat *value);
+
+// ---- ARB_compute_shader / GL 4.3 ----
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER                   0x91B9
+#define GL_SHADER_STORAGE_BARRIER_BIT       0x00002000
+#endif
+
+typedef void (APIENTRYP PFN_glDispatchCompute)(GLuint x, GLuint y, GLuint z);
+typedef void (APIENTRYP PFN_glMemoryBarrier)(GLbitfield barriers);
+
+// ---- ARB_texture_storage / GL 4.2 ----
+#ifndef GL_TEXTURE_IMMUTABLE_FORMAT
+#define GL_TEXTURE_IMMUTABLE_FORMAT 0x912F
+#endif
+
+typedef void (APIENTRYP PFN_glTexStorage2D)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width,
+                                            GLsizei height);
+typedef void (APIENTRYP PFN_glTexStorage3D)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width,
+                                            GLsizei height, GLsizei depth);
+
+// ---- ARB / EXT_texture_filter_anisotropic / GL 4.6 ----
+#ifndef GL_TEXTURE_MAX_ANISOTROPY
+#define GL_TEXTURE_MAX_ANISOTROPY     0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY 0x84FF
+#endif
+
+// ---- EXT_texture_compression_s3tc / ARB_texture_compression_bptc (GL 4.2) ----
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT  0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM    0x8E8C
+#endif
+
+// ---- ARB_bindless_texture ----
+typedef GLuint64 (APIENTRYP PFN_glGetTextureHandleARB)(GLuint texture);
+typedef void (APIENTRYP PFN_glMakeTextureHandleResidentARB)(GLuint64 handle);
+typedef void (APIENTRYP PFN_glMakeTextureHandleNonResidentARB)(GLuint64 handle);
+
+// ---- KHR_parallel_shader_compile ----
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR          0x91B1
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+
+typedef void (APIENTRYP PFN_glMaxShaderCompilerThreads)(GLuint count);
+
+class GLExtensions
+{
+public:
+    GLExtensions() = delete;
+    ~GLExtensions() = delete;
+
+    // needs a current context, call once after gladLoadGLLoader
+    static void load();
+    static bool hasVersion(int major, int minor);
+
+    static bool KHR_debug;
+    static PFN_glDebugMessageCallback DebugMessageCallback;
+    static PFN_glDebugMessageControl DebugMessageControl;
+
+    static bool ARB_buffer_storage;
+    static PFN_glBufferStorage BufferStorage;
+
+    // also implies base-instance support, the indirect path relies on it
+    static bool ARB_multi_draw_indirect;
+    static PFN_glMultiDrawElementsIndirect MultiDrawElementsIndirect;
+
+    // false too when the driver reports no binary formats (some do)
+    static bool ARB_get_program_binary;
+    static PFN_glGetProgramBinary GetProgramBinary;
+    static PFN_glProgramBinary ProgramBinary;
+    static PFN_glProgramParameteri ProgramParameteri;
+
+    // program pipelines: stages from different programs mixed at bind
+    // time, uniforms set with ProgramUniform* (no program bound)
+    static bool ARB_separate_shader_objects;
+    static PFN_glGenProgramPipelines GenProgramPipelines;
+    static PFN_glDeleteProgramPipelines DeleteProgramPipelines;
+    static PFN_glBindProgramPipeline BindProgramPipeline;
+    static PFN_glUseProgramStages UseProgramStages;
+    static PFN_glValidateProgramPipeline ValidateProgramPipeline;
+    static PFN_glGetProgramPipelineiv GetProgramPipelineiv;
+    static PFN_glGetProgramPipelineInfoLog GetProgramPipelineInfoLog;
+    static PFN_glProgramUniform1i ProgramUniform1i;
+    static PFN_glProgramUniform1f ProgramUniform1f;
+    static PFN_glProgramUniform4f ProgramUniform4f;
+    static PFN_glProgramUniformMatrix4fv ProgramUniformMatrix4fv;
+
+    static bool ARB_compute_shader;
+    static PFN_glDispatchCompute DispatchCompute;
+    static PFN_glMemoryBarrier MemoryBarrier;
+
+    // immutable texture storage, every mip level allocated up front
+    static bool ARB_texture_storage;
+    static PFN_glTexStorage2D TexStorage2D;
+    static PFN_glTexStorage3D TexStorage3D; // arrays; null if only 2D loaded
+
+    // no entry points, just GL_TEXTURE_MAX_ANISOTROPY; 1 without it
+    static bool ARB_texture_filter_anisotropic;
+    static float MaxAnisotropy;
+
+    // compressed formats, no entry points (glCompressedTex* are core)
+    static bool EXT_texture_compression_s3tc;
+    static bool ARB_texture_compression_bptc;
+
+    // samplers as 64-bit handles in buffers instead of bound units; a
+    // texture's sampling state is frozen once it has a handle
+    static bool ARB_bindless_texture;
+    static PFN_glGetTextureHandleARB GetTextureHandle;
+    static PFN_glMakeTextureHandleResidentARB MakeTextureHandleResident;
+    static PFN_glMakeTextureHandleNonResidentARB MakeTextureHandleNonResident;
+
+    // the ARB variant counts too; with it, compile / link calls return
+    // at once and GL_COMPLETION_STATUS_KHR says when they are done
+    static bool KHR_parallel_shader_compile;
+    static PFN_glMaxShaderCompilerThreads MaxShaderCompilerThreads;
+};
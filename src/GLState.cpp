@@ -0,0 +1,222 @@
+#define GL_SUBSYSTEM GLSubsystemState
+#include "GLState.hpp"
+#include "Renderer.hpp"
+#include "GLExtensions.hpp"
+#include <unordered_map>
+
+namespace
+{
+    const unsigned int Unknown = ~0u;
+    const unsigned int MaxTextureSlots = 32;
+
+    unsigned int s_Program = Unknown;
+    unsigned int s_Pipeline = Unknown;
+    unsigned int s_VertexArray = Unknown;
+    unsigned int s_ArrayBuffer = Unknown;
+    unsigned int s_ElementBuffer = Unknown;
+    unsigned int s_ActiveSlot = Unknown;
+    unsigned int s_Textures[MaxTextureSlots];
+    bool s_TexturesValid = false;
+
+    // the element buffer binding is VAO state, remember it per VAO
+    std::unordered_map<unsigned int, unsigned int> s_VaoElementBuffer;
+
+    GLStateCounters s_Counters;
+    unsigned int s_HeadlessNames = 0;
+
+    void resetTextures()
+    {
+        for (unsigned int &t : s_Textures)
+            t = Unknown;
+        s_TexturesValid = true;
+    }
+}
+
+bool GLState::s_Headless = false;
+
+void GLState::useProgram(unsigned int program)
+{
+    if (program == s_Program)
+    {
+        s_Counters.bindsSkipped++;
+        return;
+    }
+    if (!s_Headless)
+    {
+        GLCall(glUseProgram(program));
+    }
+    s_Program = program;
+    s_Counters.bindsIssued++;
+}
+
+void GLState::bindProgramPipeline(unsigned int pipeline)
+{
+    if (pipeline == s_Pipeline)
+    {
+        s_Counters.bindsSkipped++;
+        return;
+    }
+    if (!s_Headless)
+    {
+        GLCall(GLExtensions::BindProgramPipeline(pipeline));
+    }
+    s_Pipeline = pipeline;
+    s_Counters.bindsIssued++;
+}
+
+void GLState::bindVertexArray(unsigned int vao)
+{
+    if (vao == s_VertexArray)
+    {
+        s_Counters.bindsSkipped++;
+        return;
+    }
+    if (!s_Headless)
+    {
+        GLCall(glBindVertexArray(vao));
+    }
+    s_VertexArray = vao;
+    s_Counters.bindsIssued++;
+
+    auto it = s_VaoElementBuffer.find(vao);
+    s_ElementBuffer = it != s_VaoElementBuffer.end() ? it->second : Unknown;
+}
+
+void GLState::bindBuffer(unsigned int target, unsigned int buffer)
+{
+    if (target != GL_ARRAY_BUFFER && target != GL_ELEMENT_ARRAY_BUFFER)
+    {
+        if (!s_Headless)
+        {
+            GLCall(glBindBuffer(target, buffer));
+        }
+        s_Counters.bindsIssued++;
+        return;
+    }
+
+    unsigned int &shadow = target == GL_ELEMENT_ARRAY_BUFFER ? s_ElementBuffer : s_ArrayBuffer;
+    if (buffer == shadow)
+    {
+        s_Counters.bindsSkipped++;
+        return;
+    }
+    if (!s_Headless)
+    {
+        GLCall(glBindBuffer(target, buffer));
+    }
+    shadow = buffer;
+    s_Counters.bindsIssued++;
+
+    if (target == GL_ELEMENT_ARRAY_BUFFER && s_VertexArray != Unknown)
+        s_VaoElementBuffer[s_VertexArray] = buffer;
+}
+
+void GLState::bindTexture(unsigned int slot, unsigned int texture, unsigned int target)
+{
+    if (!s_TexturesValid)
+        resetTextures();
+
+    if (slot < MaxTextureSlots && s_Textures[slot] == texture)
+    {
+        s_Counters.bindsSkipped++;
+        return;
+    }
+    if (slot != s_ActiveSlot)
+    {
+        if (!s_Headless)
+        {
+            GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+        }
+        s_ActiveSlot = slot;
+    }
+    if (!s_Headless)
+    {
+        GLCall(glBindTexture(target, texture));
+    }
+    if (slot < MaxTextureSlots)
+        s_Textures[slot] = texture;
+    s_Counters.bindsIssued++;
+}
+
+void GLState::forgetProgram(unsigned int program)
+{
+    if (s_Program == program)
+        s_Program = Unknown;
+}
+
+void GLState::forgetProgramPipeline(unsigned int pipeline)
+{
+    if (s_Pipeline == pipeline)
+        s_Pipeline = Unknown;
+}
+
+void GLState::forgetVertexArray(unsigned int vao)
+{
+    if (s_VertexArray == vao)
+    {
+        s_VertexArray = Unknown;
+        s_ElementBuffer = Unknown;
+    }
+    s_VaoElementBuffer.erase(vao);
+}
+
+void GLState::forgetBuffer(unsigned int buffer)
+{
+    if (s_ArrayBuffer == buffer)
+        s_ArrayBuffer = Unknown;
+    if (s_ElementBuffer == buffer)
+        s_ElementBuffer = Unknown;
+    for (auto &entry : s_VaoElementBuffer)
+        if (entry.second == buffer)
+            entry.second = Unknown;
+}
+
+void GLState::forgetTexture(unsigned int texture)
+{
+    if (!s_TexturesValid)
+        return;
+    for (unsigned int &t : s_Textures)
+        if (t == texture)
+            t = Unknown;
+}
+
+void GLState::invalidate()
+{
+    s_Program = Unknown;
+    s_Pipeline = Unknown;
+    s_VertexArray = Unknown;
+    s_ArrayBuffer = Unknown;
+    s_ElementBuffer = Unknown;
+    s_ActiveSlot = Unknown;
+    s_VaoElementBuffer.clear();
+    resetTextures();
+}
+
+void GLState::countUniform(bool issued)
+{
+    if (issued)
+        s_Counters.uniformsIssued++;
+    else
+        s_Counters.uniformsSkipped++;
+}
+
+const GLStateCounters &GLState::counters()
+{
+    return s_Counters;
+}
+
+void GLState::resetCounters()
+{
+    s_Counters = GLStateCounters();
+}
+
+void GLState::setHeadless(bool headless)
+{
+    s_Headless = headless;
+    invalidate();
+}
+
+unsigned int GLState::headlessName()
+{
+    return ++s_HeadlessNames;
+}
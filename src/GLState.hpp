@@ -0,0 +1,62 @@
+#pragma once
+#include <glad/glad.h>
+
+// Shadow copy of the GL bindings this engine touches on the main context.
+// Binds that would not change anything are skipped and counted, so the
+// stats panel can show how much driver work was avoided.
+//
+// Everything that binds programs, VAOs, array/element buffers or
+// textures must go through here, otherwise the shadow goes stale; call
+// invalidate() after handing the context to code that doesn't.
+
+struct GLStateCounters
+{
+    unsigned int bindsIssued = 0;
+    unsigned int bindsSkipped = 0;
+    unsigned int uniformsIssued = 0;
+    unsigned int uniformsSkipped = 0;
+};
+
+class GLState
+{
+public:
+    GLState() = delete;
+    ~GLState() = delete;
+
+    static void useProgram(unsigned int program);
+    // only takes effect while program 0 is in use; Shader::Bind sees to it
+    static void bindProgramPipeline(unsigned int pipeline);
+    static void bindVertexArray(unsigned int vao);
+    // GL_ARRAY_BUFFER and GL_ELEMENT_ARRAY_BUFFER are shadowed,
+    // other targets always go through
+    static void bindBuffer(unsigned int target, unsigned int buffer);
+    // one name per slot is shadowed, whatever its target
+    static void bindTexture(unsigned int slot, unsigned int texture, unsigned int target = GL_TEXTURE_2D);
+
+    // objects being deleted, so a recycled GL name isn't mistaken for bound
+    static void forgetProgram(unsigned int program);
+    static void forgetProgramPipeline(unsigned int pipeline);
+    static void forgetVertexArray(unsigned int vao);
+    static void forgetBuffer(unsigned int buffer);
+    static void forgetTexture(unsigned int texture);
+
+    static void invalidate();
+
+    // uniform uploads are shadowed per Shader; it reports here
+    static void countUniform(bool issued);
+
+    static const GLStateCounters& counters();
+    static void resetCounters();
+
+    // No GL context (NullRenderer / RecordingRenderer runs): the shadow
+    // and counters keep working, but nothing reaches GL, and the GL
+    // wrappers skip their GL calls. Set before any GL object is created.
+    static void setHeadless(bool headless);
+    static bool headless() { return s_Headless; }
+    // stands in for glGen* when headless, so sort keys and the bind
+    // shadow still tell objects apart
+    static unsigned int headlessName();
+
+private:
+    static bool s_Headless;
+};
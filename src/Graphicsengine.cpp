@@ -2,27 +2,71 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "vendor/glm/gtc/matrix_transform.hpp"
+#include <algorithm>
+#include <limits>
+#include "GLState.hpp"
+#include "ShaderCompiler.hpp"
+#include "TextureResidency.hpp"
+
+using AtlasRegionLayout = VertexLayout<AtlasRegion, VERTEX_ATTRIBUTE(AtlasRegion, rect),
+                                       VERTEX_ATTRIBUTE(AtlasRegion, layer)>;
+
+static const char* MeshShaderPath = "res/shaders/Mesh.shader";
+// the Mesh.shader variants the engine draws with
+static const uint32_t ObjectVariant = ShaderTextured;
+static const uint32_t InstanceVariant = ShaderInstanced | ShaderTextured;
+static const uint32_t AtlasVariant = ShaderInstanced | ShaderTextured | ShaderAtlas;
+static const char* TexturePath = "res/textures/codethakur.png";
+// world units one repeat of the texture covers: a cube face
+static const float TexturedFaceSize = 0.6f;
 
 // ------------------------------------------------------------
 // Constructor
 // ------------------------------------------------------------
-Graphicsengine::Graphicsengine(GLFWwindow* window)
+Graphicsengine::Graphicsengine(GLFWwindow* window, Renderer* backend)
 {
-    shader   = new Shader("res/shaders/Basic.shader");
-    texture  = new Texture("res/textures/codethakur.png");
-    renderer = new Renderer();
+    // both variants start compiling now instead of on the first draw
+    meshShader = ResourceCache::loadShader(MeshShaderPath);
+    meshShaders = ResourceCache::get(meshShader);
+    meshShaders->get(ObjectVariant);
+    meshShaders->get(InstanceVariant);
+    // the placeholder draws until the file is decoded and uploaded
+    texture  = ResourceCache::loadTexture(TexturePath);
+    textures = new TextureTable();
+    renderer = backend ? backend : new Renderer();
+    frameUBO = new UniformBuffer(sizeof(FrameUniforms));
 
     // ✅ REQUIRED FOR 3D
-    glEnable(GL_DEPTH_TEST);
+    if (!GLState::headless())
+        glEnable(GL_DEPTH_TEST);
 
-    int width, height;
-    glfwGetFramebufferSize(window, &width, &height);
+    // headless: the size App::initWindow would have asked for
+    int width = 940, height = 680;
+    if (window)
+        glfwGetFramebufferSize(window, &width, &height);
 
+    viewportHeight = (float)height;
     float aspect = (float)width / (float)height;
     proj = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 100.0f);
 
     view = glm::translate(glm::mat4(1.0f),
                           glm::vec3(0.0f, 0.0f, -3.0f));
+
+    // registers the meshes, so cubeMesh / pyramidMesh are valid from here on
+    initTriangle();
+}
+
+void Graphicsengine::warmUp()
+{
+    // FrameData backed, like in a real frame
+    frameUBO->bindBase(FrameBlockBinding);
+    ShaderCompiler::warmUp({meshShaders->get(ObjectVariant), meshShaders->get(InstanceVariant)});
+}
+
+void Graphicsengine::watchAssets(AssetWatcher& watcher)
+{
+    meshShaders->watch(watcher);
+    watcher.watchTexture(TexturePath, ResourceCache::getSlot(texture));
 }
 
 // ------------------------------------------------------------
@@ -30,59 +74,64 @@ Graphicsengine::Graphicsengine(GLFWwindow* window)
 // ------------------------------------------------------------
 Graphicsengine::~Graphicsengine()
 {
-    delete triangleVAO;
-    delete triangleVB;
-    delete triangleIB;
+    delete meshes;
+    delete instanceModels;
+    delete instanceColors;
+    delete instanceRegions;
 
-    delete texture;
-    delete shader;
+    delete textures;
+    ResourceCache::release(texture);
+    ResourceCache::release(meshShader);
     delete renderer;
+    delete frameUBO;
 }
 
 // ------------------------------------------------------------
-// Init cube (24 vertices, ALL faces textured)
+// Init meshes: cube (24 vertices, ALL faces textured) and pyramid
 // ------------------------------------------------------------
 void Graphicsengine::initTriangle()
 {
     if (triangleInitialized)
         return;
 
+    // position, then texcoord with v = 0 at the image's top row (ImageIngest
+    // keeps the file's row order)
     float vertices[] = {
         // ---------- FRONT ----------
-        -0.3f,-0.3f, 0.3f,  -0.2f,-0.2f,
-        0.3f,-0.3f, 0.3f,   1.2f,-0.2f,
-        0.3f, 0.3f, 0.3f,   1.2f, 1.2f,
-        -0.3f, 0.3f, 0.3f,  -0.2f, 1.2f,
+        -0.3f,-0.3f, 0.3f,  -0.2f, 1.2f,
+        0.3f,-0.3f, 0.3f,   1.2f, 1.2f,
+        0.3f, 0.3f, 0.3f,   1.2f,-0.2f,
+        -0.3f, 0.3f, 0.3f,  -0.2f,-0.2f,
 
         // ---------- BACK ----------
-         0.3f,-0.3f,-0.3f,  -0.2f,-0.2f,
-        -0.3f,-0.3f,-0.3f,  1.2f,-0.2f,
-        -0.3f, 0.3f,-0.3f,  1.2f, 1.2f,
-         0.3f, 0.3f,-0.3f,  -0.2f, 1.2f,
+         0.3f,-0.3f,-0.3f,  -0.2f, 1.2f,
+        -0.3f,-0.3f,-0.3f,  1.2f, 1.2f,
+        -0.3f, 0.3f,-0.3f,  1.2f,-0.2f,
+         0.3f, 0.3f,-0.3f,  -0.2f,-0.2f,
 
         // ---------- LEFT ----------
-        -0.3f,-0.3f,-0.3f,  -0.2f,-0.2f,
-        -0.3f,-0.3f, 0.3f,  1.2f,-0.2f,
-        -0.3f, 0.3f, 0.3f,  1.2f, 1.2f,
-        -0.3f, 0.3f,-0.3f,  -0.2f, 1.2f,
+        -0.3f,-0.3f,-0.3f,  -0.2f, 1.2f,
+        -0.3f,-0.3f, 0.3f,  1.2f, 1.2f,
+        -0.3f, 0.3f, 0.3f,  1.2f,-0.2f,
+        -0.3f, 0.3f,-0.3f,  -0.2f,-0.2f,
 
         // ---------- RIGHT ----------
-         0.3f,-0.3f, 0.3f,  -0.2f,-0.2f,
-         0.3f,-0.3f,-0.3f,  1.2f,-0.2f,
-         0.3f, 0.3f,-0.3f,  1.2f, 1.2f,
-         0.3f, 0.3f, 0.3f,  -0.2f, 1.2f,
+         0.3f,-0.3f, 0.3f,  -0.2f, 1.2f,
+         0.3f,-0.3f,-0.3f,  1.2f, 1.2f,
+         0.3f, 0.3f,-0.3f,  1.2f,-0.2f,
+         0.3f, 0.3f, 0.3f,  -0.2f,-0.2f,
 
         // ---------- TOP ----------
-        -0.3f, 0.3f, 0.3f,  -0.2f,-0.2f,
-         0.3f, 0.3f, 0.3f,  1.2f,-0.2f,
-         0.3f, 0.3f,-0.3f,  1.2f, 1.2f,
-        -0.3f, 0.3f,-0.3f,  -0.2f, 1.2f,
+        -0.3f, 0.3f, 0.3f,  -0.2f, 1.2f,
+         0.3f, 0.3f, 0.3f,  1.2f, 1.2f,
+         0.3f, 0.3f,-0.3f,  1.2f,-0.2f,
+        -0.3f, 0.3f,-0.3f,  -0.2f,-0.2f,
 
         // ---------- BOTTOM ----------
-        -0.3f,-0.3f,-0.3f,  -0.2f,-0.2f,
-         0.3f,-0.3f,-0.3f,  1.2f,-0.2f,
-         0.3f,-0.3f, 0.3f,  1.2f, 1.2f,
-        -0.3f,-0.3f, 0.3f,  -0.2f, 1.2f,    }
+        -0.3f,-0.3f,-0.3f,  -0.2f, 1.2f,
+         0.3f,-0.3f,-0.3f,  1.2f, 1.2f,
+         0.3f,-0.3f, 0.3f,  1.2f,-0.2f,
+        -0.3f,-0.3f, 0.3f,  -0.2f,-0.2f,    }
         ;
 
     unsigned int indices[] = {
@@ -94,15 +143,53 @@ void Graphicsengine::initTriangle()
         20, 21, 22, 22, 23, 20
     };
 
-    triangleVAO = new VertexArray();
-    triangleVB  = new VertexBuffer(vertices, sizeof(vertices));
-    triangleIB  = new IndexBuffer(indices, 36);
+    float pyramid[] = {
+        // ---------- SIDES ----------
+        -0.3f,-0.3f, 0.3f,  0.0f, 1.0f,
+         0.3f,-0.3f, 0.3f,  1.0f, 1.0f,
+         0.0f, 0.3f, 0.0f,  0.5f, 0.0f,
+
+         0.3f,-0.3f, 0.3f,  0.0f, 1.0f,
+         0.3f,-0.3f,-0.3f,  1.0f, 1.0f,
+         0.0f, 0.3f, 0.0f,  0.5f, 0.0f,
+
+         0.3f,-0.3f,-0.3f,  0.0f, 1.0f,
+        -0.3f,-0.3f,-0.3f,  1.0f, 1.0f,
+         0.0f, 0.3f, 0.0f,  0.5f, 0.0f,
+
+        -0.3f,-0.3f,-0.3f,  0.0f, 1.0f,
+        -0.3f,-0.3f, 0.3f,  1.0f, 1.0f,
+         0.0f, 0.3f, 0.0f,  0.5f, 0.0f,
+
+        // ---------- BASE ----------
+        -0.3f,-0.3f,-0.3f,  0.0f, 1.0f,
+         0.3f,-0.3f,-0.3f,  1.0f, 1.0f,
+         0.3f,-0.3f, 0.3f,  1.0f, 0.0f,
+        -0.3f,-0.3f, 0.3f,  0.0f, 0.0f,
+    };
+
+    unsigned int pyramidIndices[] = {
+         0,  1,  2,
+         3,  4,  5,
+         6,  7,  8,
+         9, 10, 11,
+        12, 13, 14, 14, 15, 12
+    };
+
+    meshes = new MeshRegistry();
+    cubeMesh = meshes->add(vertices, 24, indices, 36);
+    pyramidMesh = meshes->add(pyramid, 16, pyramidIndices, 18);
+    VertexArray* meshVAO = &meshes->getVertexArray();
 
-    VertexBufferLayout layout;
-    layout.Push<float>(3); // position
-    layout.Push<float>(2); // texcoord
+    // per-instance streams, grown on demand in drawInstances()
+    instanceModels = new StreamBuffer(GL_ARRAY_BUFFER, sizeof(glm::mat4), 1024);
+    instanceColors = new StreamBuffer(GL_ARRAY_BUFFER, sizeof(glm::vec4), 1024);
+    instanceRegions = new StreamBuffer(GL_ARRAY_BUFFER, sizeof(AtlasRegion), 1024);
 
-    triangleVAO->addBuffer(*triangleVB, layout);
+    // a_Model (one location per column), a_Color, a_AtlasRect + a_AtlasLayer
+    meshVAO->addBuffer(*instanceModels, VertexLayoutOf<glm::mat4>::value, 2, 1);
+    meshVAO->addBuffer(*instanceColors, VertexLayoutOf<glm::vec4>::value, 6, 1);
+    meshVAO->addBuffer(*instanceRegions, AtlasRegionLayout::value, 7, 1);
 
     triangleInitialized = true;
 }
@@ -115,15 +202,297 @@ void Graphicsengine::drawTriangle(const glm::mat4& model,
 {
     initTriangle();
 
-    glm::mat4 mvp = proj * view * model;
-
+    // view/projection come from the FrameData block
+    Shader* shader = meshShaders->get(ObjectVariant);
     shader->Bind();
-    shader->setUniformMat4f("u_MVP", mvp);
-   shader->setUniform4f("u_Color", color.r, color.g, color.b, color.a);
+    shader->setUniformMat4f(Uniforms::Model, model);
+   shader->setUniform4f(Uniforms::Color, color.r, color.g, color.b, color.a);
+
+    shader->setUniform1i(Uniforms::Texture, 0);
+    ResourceCache::get(texture)->Bind(0);
+    renderer->DrawMesh(meshes->getVertexArray(), meshes->getIndexBuffer(), *shader, meshes->get(cubeMesh));
+}
+
+// ------------------------------------------------------------
+// Draw many cubes in one call
+// ------------------------------------------------------------
+void Graphicsengine::drawInstances(const glm::mat4* models,
+                                   const glm::vec4* colors,
+                                   size_t count,
+                                   BlendMode blend)
+{
+    if (count == 0)
+        return;
+
+    initTriangle();
+
+    ensureInstanceSpace((unsigned int)count);
+
+    unsigned int first = instanceModels->write(models, (unsigned int)count);
+    unsigned int firstColor = instanceColors->write(colors, (unsigned int)count);
+    ASSERT(first == firstColor);
+    (void)firstColor;
+    // only claimed, to keep the streams in step; InstanceVariant doesn't
+    // read regions
+    unsigned int firstRegion;
+    instanceRegions->map((unsigned int)count, firstRegion);
+    instanceRegions->unmap();
+    ASSERT(first == firstRegion);
+
+    // only worth a pass over the instances when there's a budget to keep
+    if (TextureResidency::getBudget() > 0)
+    {
+        float screenSize = 0.0f;
+        for (size_t i = 0; i < count; ++i)
+            screenSize = std::max(screenSize, textureScreenSize(models[i]));
+        TextureResidency::requestScreenSize(ResourceCache::get(texture), screenSize);
+    }
+
+    // the sort key's depth: opaque batches by their nearest instance,
+    // blended ones by their farthest, so each goes as early as it should
+    float depth = viewDepth(models[0]);
+    for (size_t i = 1; i < count; ++i)
+    {
+        float d = viewDepth(models[i]);
+        depth = blend == BlendMode::Opaque ? std::min(depth, d) : std::max(depth, d);
+    }
+
+    DrawPacket packet;
+    packet.shader = meshShaders->get(InstanceVariant);
+    packet.va = &meshes->getVertexArray();
+    packet.ib = &meshes->getIndexBuffer();
+    packet.texture = ResourceCache::get(texture);
+    packet.blend = blend;
+    packet.depth = depth;
+    packet.firstInstance = first;
+    packet.instanceCount = (unsigned int)count;
+    packet.firstIndex = meshes->get(cubeMesh).firstIndex;
+    packet.indexCount = meshes->get(cubeMesh).indexCount;
+    packet.baseVertex = meshes->get(cubeMesh).baseVertex;
+    renderer->Submit(packet);
+}
+
+// every call this frame appends behind the previous one, so queued
+// packets keep their data until endFrame()
+void Graphicsengine::ensureInstanceSpace(unsigned int count)
+{
+    if (count <= instanceModels->available())
+        return;
+
+    // draw what is queued, then grow; the old storage stays alive
+    // in the driver until those draws are done
+    flushQueue();
+    unsigned int perFrame = std::max(count, instanceModels->getElementsPerFrame() * 2);
+    instanceModels->resize(perFrame);
+    instanceColors->resize(perFrame);
+    instanceRegions->resize(perFrame);
+    instanceModels->beginFrame();
+    instanceColors->beginFrame();
+    instanceRegions->beginFrame();
+}
+
+// ------------------------------------------------------------
+// Draw any registered mesh; batched per frame
+// ------------------------------------------------------------
+void Graphicsengine::draw(ObjectId id, const glm::mat4& model, const glm::vec4& color)
+{
+    pendingDraws.push_back({id, model, color, AtlasRegion(), 0, EngineTextureGroup});
+}
+
+void Graphicsengine::draw(ObjectId id, const glm::mat4& model, const glm::vec4& color, const AtlasRegion& region)
+{
+    pendingDraws.push_back({id, model, color, region, 0, atlasTexture ? AtlasGroup : EngineTextureGroup});
+}
+
+void Graphicsengine::draw(ObjectId id, const glm::mat4& model, const glm::vec4& color,
+                          TextureTable::TextureId image)
+{
+    // bound by no one, so this is also what keeps them recently used
+    if (textures->isBindless())
+        textures->requestScreenSize(image, textureScreenSize(model));
+    // the region is looked up in submitMeshDraws(): an image added this
+    // frame has none until the table's update()
+    pendingDraws.push_back({id, model, color, AtlasRegion(), image, TableGroup});
+}
+
+TextureTable::TextureId Graphicsengine::addTexture(const std::string& path)
+{
+    TextureTable::TextureId id = textures->add(path);
+    meshShaders->get(InstanceVariant | textures->getShaderFeatures());
+    return id;
+}
+
+void Graphicsengine::setAtlas(const TextureAtlas* atlas)
+{
+    atlasTexture = atlas ? atlas->getTexture() : nullptr;
+    if (atlasTexture)
+        meshShaders->get(AtlasVariant);
+}
+
+// Groups this frame's draw() calls by texture group and mesh, streams their
+// instance data in that order and submits a multi-draw packet per group:
+// one command per mesh, one GL call for all of them where multi-draw
+// indirect is available.
+void Graphicsengine::submitMeshDraws()
+{
+    if (pendingDraws.empty())
+        return;
+
+    initTriangle();
+
+    unsigned int total = (unsigned int)pendingDraws.size();
+    ensureInstanceSpace(total);
+    // images added since beginFrame(); nothing queued uses the table yet
+    textures->update();
+
+    // counting sort by group, then mesh id
+    size_t meshCount = meshes->size();
+    auto bucket = [meshCount](const MeshDraw& d) { return d.mesh + d.group * meshCount; };
+    meshDrawOffsets.assign(meshCount * DrawGroupCount + 1, 0);
+    for (const MeshDraw& d : pendingDraws)
+        meshDrawOffsets[bucket(d) + 1]++;
+    for (size_t m = 1; m < meshDrawOffsets.size(); ++m)
+        meshDrawOffsets[m] += meshDrawOffsets[m - 1];
+
+    unsigned int first, firstColor, firstRegion;
+    glm::mat4* models = (glm::mat4*)instanceModels->map(total, first);
+    glm::vec4* colors = (glm::vec4*)instanceColors->map(total, firstColor);
+    AtlasRegion* regions = (AtlasRegion*)instanceRegions->map(total, firstRegion);
+    ASSERT(first == firstColor && first == firstRegion);
+
+    for (std::vector<DrawElementsIndirectCommand>& commands : groupCommands)
+        commands.clear();
+    for (size_t b = 0; b + 1 < meshDrawOffsets.size(); ++b)
+    {
+        unsigned int count = meshDrawOffsets[b + 1] - meshDrawOffsets[b];
+        if (count == 0)
+            continue;
+        const MeshRange& range = meshes->get((ObjectId)(b % meshCount));
+        groupCommands[b / meshCount].push_back(
+            {range.indexCount, count, range.firstIndex, range.baseVertex, first + meshDrawOffsets[b]});
+    }
+
+    // atlas pages are pinned (TextureResidency), only the engine's texture streams
+    float screenSize = 0.0f;
+    bool residency = TextureResidency::getBudget() > 0;
+    // each group's packet sorts by its nearest draw
+    float groupDepths[DrawGroupCount];
+    std::fill(groupDepths, groupDepths + DrawGroupCount, std::numeric_limits<float>::max());
+    for (const MeshDraw& d : pendingDraws)
+    {
+        unsigned int slot = meshDrawOffsets[bucket(d)]++;
+        models[slot] = d.model;
+        colors[slot] = d.color;
+        regions[slot] = d.group == TableGroup ? textures->getRegion(d.image) : d.region;
+        groupDepths[d.group] = std::min(groupDepths[d.group], viewDepth(d.model));
+        if (residency && d.group == EngineTextureGroup)
+            screenSize = std::max(screenSize, textureScreenSize(d.model));
+    }
+    if (screenSize > 0.0f)
+        TextureResidency::requestScreenSize(ResourceCache::get(texture), screenSize);
+    instanceModels->unmap();
+    instanceColors->unmap();
+    instanceRegions->unmap();
+
+    const uint32_t groupVariants[DrawGroupCount] = {InstanceVariant, AtlasVariant,
+                                                    InstanceVariant | textures->getShaderFeatures()};
+    const Texture* groupTextures[DrawGroupCount] = {ResourceCache::get(texture), atlasTexture,
+                                                     textures->getTexture()};
+    for (int group = 0; group < DrawGroupCount; ++group)
+    {
+        if (groupCommands[group].empty())
+            continue;
+        DrawPacket packet;
+        packet.shader = meshShaders->get(groupVariants[group]);
+        packet.va = &meshes->getVertexArray();
+        packet.ib = &meshes->getIndexBuffer();
+        packet.texture = groupTextures[group];
+        packet.depth = groupDepths[group];
+        packet.commands = groupCommands[group].data();
+        packet.commandCount = (unsigned int)groupCommands[group].size();
+        renderer->Submit(packet);
+    }
+
+    pendingDraws.clear();
+}
+
+// distance in front of the camera of the mesh's origin; behind it is 0
+float Graphicsengine::viewDepth(const glm::mat4& model) const
+{
+    const glm::vec4& origin = model[3];
+    float z = view[0].z * origin.x + view[1].z * origin.y + view[2].z * origin.z + view[3].z * origin.w;
+    return std::max(-z, 0.0f);
+}
+
+// the face's projected height at the mesh's origin; meshes are small
+// enough that the nearest and farthest texel hardly differ
+float Graphicsengine::textureScreenSize(const glm::mat4& model) const
+{
+    float depth = std::max(viewDepth(model), 0.1f);
+    float scale = std::max(glm::length(glm::vec3(model[0])),
+                           std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    return TexturedFaceSize * scale * proj[1][1] * viewportHeight * 0.5f / depth;
+}
+
+// ------------------------------------------------------------
+// Frame boundaries
+// ------------------------------------------------------------
+void Graphicsengine::beginFrame(float time, float brightness)
+{
+    GLState::resetCounters();
+    initTriangle();
+
+    FrameUniforms frame;
+    frame.view = view;
+    frame.proj = proj;
+    frame.viewProj = proj * view;
+    frame.time = time;
+    frame.brightness = brightness;
+    frame.pad[0] = frame.pad[1] = 0.0f;
+    frameUBO->setData(&frame, sizeof(frame));
+    frameUBO->bindBase(FrameBlockBinding);
+
+    // waits only if the GPU is still reading the region from 3 frames ago
+    instanceModels->beginFrame();
+    instanceColors->beginFrame();
+    instanceRegions->beginFrame();
+
+    // before anything is flushed: new handles resident and the block
+    // bound, or the fallback array repacked
+    textures->update();
+    textures->bind();
+}
+
+void Graphicsengine::endFrame()
+{
+    submitMeshDraws();
+    flushQueue();
+    instanceModels->endFrame();
+    instanceColors->endFrame();
+    instanceRegions->endFrame();
+}
+
+void Graphicsengine::flushQueue()
+{
+    // camera and globals are in FrameData; per-object data lives in
+    // the instance streams
+    Shader* instanceShader = meshShaders->get(InstanceVariant);
+    instanceShader->Bind();
+    instanceShader->setUniform1i(Uniforms::Texture, 0);
+    if (atlasTexture)
+    {
+        Shader* atlasShader = meshShaders->get(AtlasVariant);
+        atlasShader->Bind();
+        atlasShader->setUniform1i(Uniforms::Texture, 0);
+    }
+    if (textures->size() > 0 && !textures->isBindless())
+    {
+        Shader* tableShader = meshShaders->get(InstanceVariant | textures->getShaderFeatures());
+        tableShader->Bind();
+        tableShader->setUniform1i(Uniforms::Texture, 0);
+    }
 
-    shader->setUniform1i("u_Texture", 0);
-    texture->Bind(0);
-    renderer->Draw(*triangleVAO, *triangleIB, *shader);
+    renderer->Flush();
 }
 
 // ------------------------------------------------------------
@@ -131,7 +500,6 @@ void Graphicsengine::drawTriangle(const glm::mat4& model,
 // ------------------------------------------------------------
 void Graphicsengine::clear(const glm::vec4& color)
 {
-    glClearColor(color.r, color.g, color.b, color.a);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    renderer->Clear(color);
 }
 
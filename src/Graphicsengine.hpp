@@ -6,16 +6,28 @@
 #include <unordered_map>
 #include <cstdint>
 #include "Shader.hpp"
+#include "ShaderVariants.hpp"
 #include "VertexArray.hpp"
 #include "VertexBuffer.hpp"
 #include "IndexBuffer.hpp"
+#include "StreamBuffer.hpp"
+#include "UniformBuffer.hpp"
+#include "MeshRegistry.hpp"
+#include <vector>
+#include <cstddef>
 #include "Texture.hpp"
+#include "TextureAtlas.hpp"
+#include "TextureTable.hpp"
+#include "ResourceCache.hpp"
 #include "Renderer.hpp"
+#include "AssetWatcher.hpp"
 
 
 class Graphicsengine {
 public:
-    Graphicsengine(GLFWwindow* window);
+    // window may be null when GLState is headless; the engine takes
+    // ownership of `backend` (a GL Renderer is created when null)
+    Graphicsengine(GLFWwindow* window, Renderer* backend = nullptr);
     ~Graphicsengine();
 
     using ObjectId = uint32_t;
@@ -23,8 +35,44 @@ public:
     void drawTriangle(const glm::mat4& model,
                       const glm::vec4& color);
 
-    
+    // Draws `count` cubes with a single glDrawElementsInstanced.
+    // models/colors are contiguous per-instance arrays (one entry per cube).
+    // The draw is queued; it reaches GL in endFrame().
+    void drawInstances(const glm::mat4* models,
+                       const glm::vec4* colors,
+                       size_t count,
+                       BlendMode blend = BlendMode::Opaque);
+
+    // uploads FrameData (view, proj, time, brightness) once for the frame
+    void beginFrame(float time, float brightness);
+    void endFrame();
+    // waits for the engine's shaders and draws each once offscreen
+    // (ShaderCompiler::warmUp), so the first frames don't hitch
+    void warmUp();
+    // lets `watcher` swap the engine's shaders and texture when their
+    // files change; the watcher must go before the engine does
+    void watchAssets(AssetWatcher& watcher);
+    const RenderQueueStats& getQueueStats() const { return renderer->getQueueStats(); }
+    unsigned int getStreamStalls() const { return instanceModels ? instanceModels->getStallCount() : 0; }
+
+    // Queues one instance of a registered mesh. At endFrame() all of them
+    // go out as a single multi-draw, grouped by mesh.
     void draw(ObjectId id, const glm::mat4& model, const glm::vec4& color = glm::vec4(1.0f));
+    // the same, textured with one image of the atlas given to setAtlas();
+    // every such draw, whatever its image, shares a second multi-draw
+    void draw(ObjectId id, const glm::mat4& model, const glm::vec4& color, const AtlasRegion& region);
+    // not owned; null goes back to the engine's texture. Call again after
+    // the atlas is rebuilt, its texture changes.
+    void setAtlas(const TextureAtlas* atlas);
+
+    // Images objects can be drawn with by index (TextureTable): bindless
+    // handles where the driver has them, an atlas array otherwise. All
+    // draws with them share one multi-draw and no texture is bound per
+    // object.
+    TextureTable::TextureId addTexture(const std::string& path);
+    void draw(ObjectId id, const glm::mat4& model, const glm::vec4& color, TextureTable::TextureId image);
+    ObjectId cubeMesh = 0;
+    ObjectId pyramidMesh = 0;
     void clear(const glm::vec4& color);
     glm::mat4 proj;
     glm::mat4 view;
@@ -32,21 +80,50 @@ public:
 
 private:
     void initTriangle();
-    VertexArray* triangleVAO = nullptr;
-    VertexBuffer* triangleVB = nullptr;
-    IndexBuffer* triangleIB = nullptr;
-    
-    struct Buffer {
-        VertexArray* vao;
-        VertexBuffer* vb;
-        IndexBuffer* ib;
-        Texture* texture;
-    };
+    void flushQueue();
+    void ensureInstanceSpace(unsigned int count);
+    void submitMeshDraws();
+    // view-space distance of a mesh drawn with `model`, for the sort key
+    float viewDepth(const glm::mat4& model) const;
+    // pixels the texture spans on one face of a mesh drawn with `model`
+    float textureScreenSize(const glm::mat4& model) const;
 
-    std::unordered_map<ObjectId, Buffer> buffersMap;
+    // every mesh shares one VAO / VBO / IBO
+    MeshRegistry* meshes = nullptr;
+    StreamBuffer* instanceModels = nullptr;
+    StreamBuffer* instanceColors = nullptr;
+    // AtlasRegion per instance, in lockstep with the two above
+    StreamBuffer* instanceRegions = nullptr;
+
+    // what a queued draw is textured with; one packet per group
+    enum DrawGroup : uint8_t {
+        EngineTextureGroup, // `texture`
+        AtlasGroup,         // setAtlas()
+        TableGroup,         // `textures`
+        DrawGroupCount
+    };
+    struct MeshDraw {
+        ObjectId mesh;
+        glm::mat4 model;
+        glm::vec4 color;
+        AtlasRegion region;
+        TextureTable::TextureId image; // TableGroup
+        DrawGroup group;
+    };
+    std::vector<MeshDraw> pendingDraws;
+    std::vector<unsigned int> meshDrawOffsets;
+    std::vector<DrawElementsIndirectCommand> groupCommands[DrawGroupCount];
+    const Texture* atlasTexture = nullptr;
+    TextureTable* textures = nullptr;
 
-    Shader* shader = nullptr;
+    // both from ResourceCache; meshShaders is `meshShader` resolved, it
+    // never moves while referenced. The texture is looked up per use: a
+    // reload replaces it.
+    ShaderHandle meshShader;
+    ShaderVariants* meshShaders = nullptr;
+    UniformBuffer* frameUBO = nullptr;
     Renderer* renderer = nullptr;
-    Texture* texture;
+    TextureHandle texture;
     bool triangleInitialized = false;
+    float viewportHeight = 680.0f;
 };
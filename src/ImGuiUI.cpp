@@ -35,6 +35,12 @@ void UIObjectListPanel::render()
         if (onAddObject)
             onAddObject();
     }
+    ImGui::SameLine();
+    if (ImGui::Button("Pyramid"))
+    {
+        if (onAddPyramid)
+            onAddPyramid();
+    }
 
    if (!controls || controls->empty())
     return;
@@ -76,4 +82,36 @@ void UIObjectListPanel::render()
         if (onResetAll)
             onResetAll();
     }
-}
\ No newline at end of file
+}
+
+void UIStatsPanel::render()
+{
+    ImGui::Separator();
+    ImGui::Text("Instances: %zu visible / %zu culled", stats->drawnInstances, stats->culledInstances);
+    ImGui::Text("Render CPU: %.3f ms   Frame: %.2f ms", stats->renderCpuMs, stats->frameMs);
+    ImGui::Text("Packets: %u  Draw calls: %u  Program: %u  VAO: %u  Texture: %u  Blend: %u",
+                stats->queue.packets, stats->queue.drawCalls, stats->queue.programSwitches, stats->queue.vaoSwitches,
+                stats->queue.textureSwitches, stats->queue.blendSwitches);
+    ImGui::Text("Binds: %u issued / %u skipped   Uniforms: %u issued / %u skipped",
+                stats->glState.bindsIssued, stats->glState.bindsSkipped,
+                stats->glState.uniformsIssued, stats->glState.uniformsSkipped);
+    ImGui::Text("Stream stalls: %u", stats->streamStalls);
+    ImGui::Text("Hot reload: %u reloaded, %u unchanged, %u failed",
+                stats->assets.reloads, stats->assets.unchanged, stats->assets.failed);
+    ImGui::Text("Texture loads: %u pending, %u loaded, %u failed   Upload: %.2f ms, %zu KB",
+                stats->textures.pending, stats->textures.loaded, stats->textures.failed,
+                stats->textures.uploadMs, stats->textures.uploadedBytes / 1024);
+    ImGui::Text("Texture memory: %zu / %zu MB   %u textures, %u reduced, %u streaming (%u dropped, %u restored)",
+                stats->residency.residentBytes >> 20, stats->residency.budgetBytes >> 20, stats->residency.textures,
+                stats->residency.reduced, stats->residency.streaming, stats->residency.dropped,
+                stats->residency.restored);
+    ImGui::Text("Resources: %u textures, %u shaders   %u loaded, %u shared, %u releasing",
+                stats->resources.textures, stats->resources.shaders, stats->resources.loads,
+                stats->resources.shared, stats->resources.releasing);
+    if (stats->queue.skippedPackets)
+        ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.2f, 1.0f), "Compiling: %u packets skipped", stats->queue.skippedPackets);
+
+    // 1 .. 1M cubes, all drawn with one glDrawElementsInstanced
+    ImGui::SliderInt("Stress Instances", &stats->stressInstances, 0, 1000000,
+                     "%d", ImGuiSliderFlags_Logarithmic);
+}
@@ -52,6 +52,7 @@ UIObjectListPanel(
     std::function<void()> onRemoveLast;
     std::function<void()> onResetAll;
     std::function<void()> onAddCube;
+    std::function<void()> onAddPyramid;
 
 
 
@@ -63,4 +64,14 @@ private:
     float* backgroundBrightness;   
     ImVec4* clearColor;
 
-};
\ No newline at end of file
+};
+
+class UIStatsPanel : public UIComponent {
+public:
+    UIStatsPanel(FrameStats* stats) : stats(stats) {}
+
+    void render() override;
+
+private:
+    FrameStats* stats;
+};
@@ -0,0 +1,288 @@
+#include "ImageIngest.hpp"
+#include "Console.hpp"
+#include "vendor/stb_image/stb_image.h"
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define INGEST_SSSE3 1
+#define INGEST_SSE2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define INGEST_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define INGEST_NEON 1
+#endif
+
+// Every loop below runs from the last texel down: texel i's source bytes
+// start at i * channels and its RGBA at i * 4, so writing texel i never
+// touches a source byte of a texel below it. Each vector step loads all
+// its sources before storing, and the texels above the last whole step
+// go first, one at a time.
+namespace
+{
+    void expandTail(unsigned char *pixels, int channels, size_t first, size_t end)
+    {
+        for (size_t i = end; i-- > first;)
+        {
+            const unsigned char *src = pixels + i * channels;
+            unsigned char r, g, b, a = 255;
+            switch (channels)
+            {
+            case 1:
+                r = g = b = src[0];
+                break;
+            case 2:
+                r = g = b = src[0];
+                a = src[1];
+                break;
+            default:
+                r = src[0];
+                g = src[1];
+                b = src[2];
+                break;
+            }
+            unsigned char *dst = pixels + i * 4;
+            dst[0] = r;
+            dst[1] = g;
+            dst[2] = b;
+            dst[3] = a;
+        }
+    }
+
+    // 16 texels per step
+    void expandGrey(unsigned char *pixels, size_t count)
+    {
+#if INGEST_SSE2 || INGEST_NEON
+        size_t i = count & ~(size_t)15;
+#else
+        size_t i = 0;
+#endif
+        expandTail(pixels, 1, i, count);
+#if INGEST_SSE2
+        const __m128i opaque = _mm_set1_epi8((char)0xFF);
+        while (i > 0)
+        {
+            i -= 16;
+            __m128i grey = _mm_loadu_si128((const __m128i *)(pixels + i));
+            __m128i pairLo = _mm_unpacklo_epi8(grey, grey), pairHi = _mm_unpackhi_epi8(grey, grey);
+            __m128i alphaLo = _mm_unpacklo_epi8(grey, opaque), alphaHi = _mm_unpackhi_epi8(grey, opaque);
+            __m128i *dst = (__m128i *)(pixels + i * 4);
+            _mm_storeu_si128(dst + 0, _mm_unpacklo_epi16(pairLo, alphaLo));
+            _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(pairLo, alphaLo));
+            _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(pairHi, alphaHi));
+            _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(pairHi, alphaHi));
+        }
+#elif INGEST_NEON
+        while (i > 0)
+        {
+            i -= 16;
+            uint8x16x4_t rgba;
+            rgba.val[0] = rgba.val[1] = rgba.val[2] = vld1q_u8(pixels + i);
+            rgba.val[3] = vdupq_n_u8(255);
+            vst4q_u8(pixels + i * 4, rgba);
+        }
+#endif
+    }
+
+    // grey + alpha, 8 texels per step (16 on NEON)
+    void expandGreyAlpha(unsigned char *pixels, size_t count)
+    {
+#if INGEST_SSE2
+        size_t i = count & ~(size_t)7;
+#elif INGEST_NEON
+        size_t i = count & ~(size_t)15;
+#else
+        size_t i = 0;
+#endif
+        expandTail(pixels, 2, i, count);
+#if INGEST_SSE2
+        const __m128i low = _mm_set1_epi16(0x00FF);
+        while (i > 0)
+        {
+            i -= 8;
+            __m128i greyAlpha = _mm_loadu_si128((const __m128i *)(pixels + i * 2));
+            __m128i grey = _mm_and_si128(greyAlpha, low);
+            __m128i pair = _mm_or_si128(grey, _mm_slli_epi16(grey, 8));
+            __m128i *dst = (__m128i *)(pixels + i * 4);
+            _mm_storeu_si128(dst + 0, _mm_unpacklo_epi16(pair, greyAlpha));
+            _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(pair, greyAlpha));
+        }
+#elif INGEST_NEON
+        while (i > 0)
+        {
+            i -= 16;
+            uint8x16x2_t greyAlpha = vld2q_u8(pixels + i * 2);
+            uint8x16x4_t rgba;
+            rgba.val[0] = rgba.val[1] = rgba.val[2] = greyAlpha.val[0];
+            rgba.val[3] = greyAlpha.val[1];
+            vst4q_u8(pixels + i * 4, rgba);
+        }
+#endif
+    }
+
+    // 16 texels per step. The SSSE3 loads read 4 bytes past the 48 they
+    // use, which the count * 4 buffer always has.
+    void expandRGB(unsigned char *pixels, size_t count)
+    {
+#if INGEST_SSSE3 || INGEST_NEON
+        size_t i = count & ~(size_t)15;
+#else
+        size_t i = 0;
+#endif
+        expandTail(pixels, 3, i, count);
+#if INGEST_SSSE3
+        const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i opaque = _mm_set1_epi32((int)0xFF000000);
+        while (i > 0)
+        {
+            i -= 16;
+            const unsigned char *src = pixels + i * 3;
+            __m128i a = _mm_loadu_si128((const __m128i *)(src + 0));
+            __m128i b = _mm_loadu_si128((const __m128i *)(src + 12));
+            __m128i c = _mm_loadu_si128((const __m128i *)(src + 24));
+            __m128i d = _mm_loadu_si128((const __m128i *)(src + 36));
+            __m128i *dst = (__m128i *)(pixels + i * 4);
+            _mm_storeu_si128(dst + 0, _mm_or_si128(_mm_shuffle_epi8(a, spread), opaque));
+            _mm_storeu_si128(dst + 1, _mm_or_si128(_mm_shuffle_epi8(b, spread), opaque));
+            _mm_storeu_si128(dst + 2, _mm_or_si128(_mm_shuffle_epi8(c, spread), opaque));
+            _mm_storeu_si128(dst + 3, _mm_or_si128(_mm_shuffle_epi8(d, spread), opaque));
+        }
+#elif INGEST_NEON
+        while (i > 0)
+        {
+            i -= 16;
+            uint8x16x3_t rgb = vld3q_u8(pixels + i * 3);
+            uint8x16x4_t rgba;
+            rgba.val[0] = rgb.val[0];
+            rgba.val[1] = rgb.val[1];
+            rgba.val[2] = rgb.val[2];
+            rgba.val[3] = vdupq_n_u8(255);
+            vst4q_u8(pixels + i * 4, rgba);
+        }
+#endif
+    }
+
+    std::vector<unsigned char> readFile(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<unsigned char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+}
+
+TextureImage ImageIngest::decode(const unsigned char *data, size_t size)
+{
+    TextureImage image;
+    int channels = 0;
+    image.pixels = stbi_load_from_memory(data, (int)size, &image.width, &image.height, &channels, 0);
+    if (!image.pixels || channels == 4)
+        return image;
+
+    // stb's buffer is malloc'd, so it can grow where it is
+    size_t count = (size_t)image.width * image.height;
+    unsigned char *grown = (unsigned char *)std::realloc(image.pixels, count * 4);
+    if (!grown)
+    {
+        stbi_image_free(image.pixels);
+        image.pixels = nullptr;
+        return image;
+    }
+    image.pixels = grown;
+    expandToRGBA(image.pixels, channels, count);
+    return image;
+}
+
+TextureImage ImageIngest::load(const std::string &path)
+{
+    std::vector<unsigned char> data = readFile(path);
+    return decode(data.data(), data.size());
+}
+
+void ImageIngest::expandToRGBA(unsigned char *pixels, int channels, size_t count)
+{
+    switch (channels)
+    {
+    case 1:
+        expandGrey(pixels, count);
+        break;
+    case 2:
+        expandGreyAlpha(pixels, count);
+        break;
+    case 3:
+        expandRGB(pixels, count);
+        break;
+    }
+}
+
+void ImageIngest::benchmark(const std::string &directory, int repeats)
+{
+    std::error_code error;
+    std::vector<std::string> paths;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+    {
+        if (entry.is_regular_file() && stbi_info(entry.path().string().c_str(), nullptr, nullptr, nullptr))
+            paths.push_back(entry.path().string());
+    }
+    std::sort(paths.begin(), paths.end());
+    if (paths.empty())
+    {
+        Console::LOGN("ImageIngest: no images in " + directory, Color::RED);
+        return;
+    }
+
+    auto time = [repeats](auto &&decodeOnce) {
+        double best = 1e30;
+        for (int r = 0; r < repeats; ++r)
+        {
+            auto start = std::chrono::steady_clock::now();
+            decodeOnce();
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    };
+
+    // the table is laid out with snprintf, printed through Console
+    char line[160];
+    double totals[3] = {};
+    std::snprintf(line, sizeof(line), "%-32s %11s %3s %10s %10s %10s", "image", "size", "ch", "flip+stb", "stb",
+                  "ingest");
+    Console::LOGN("[ImageIngest] best of " + std::to_string(repeats) + ", " + directory);
+    Console::LOGN(line);
+    for (const std::string &path : paths)
+    {
+        std::vector<unsigned char> data = readFile(path);
+        int width = 0, height = 0, channels = 0;
+        stbi_info_from_memory(data.data(), (int)data.size(), &width, &height, &channels);
+
+        auto viaStb = [&](int flip) {
+            stbi_set_flip_vertically_on_load_thread(flip);
+            int w, h, n;
+            stbi_image_free(stbi_load_from_memory(data.data(), (int)data.size(), &w, &h, &n, 4));
+            stbi_set_flip_vertically_on_load_thread(0);
+        };
+        double ms[3] = {
+            time([&]() { viaStb(1); }),
+            time([&]() { viaStb(0); }),
+            time([&]() { stbi_image_free(decode(data.data(), data.size()).pixels); }),
+        };
+        for (int i = 0; i < 3; ++i)
+            totals[i] += ms[i];
+        std::string size = std::to_string(width) + "x" + std::to_string(height);
+        std::snprintf(line, sizeof(line), "%-32s %11s %3d %8.2fms %8.2fms %8.2fms",
+                      std::filesystem::path(path).filename().string().c_str(), size.c_str(), channels, ms[0], ms[1],
+                      ms[2]);
+        Console::LOGN(line);
+    }
+    std::snprintf(line, sizeof(line), "%-32s %15s %8.2fms %8.2fms %8.2fms  (%.0f%% of flip+stb)", "total", "",
+                  totals[0], totals[1], totals[2], totals[2] / totals[0] * 100.0);
+    Console::LOGN(line, Color::GREEN);
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include "Texture.hpp"
+
+// Turns image files into what Texture uploads: RGBA8, rows in the order
+// the file stores them (top first). Nothing is flipped; texture
+// coordinates put v = 0 at the top row instead, which is where GL's
+// t = 0 lands when the rows go up as they are.
+//
+// stb_image decodes at the file's own channel count and the widening to
+// RGBA happens afterwards, in place in the same buffer and with SIMD
+// (SSSE3 / SSE2 / NEON) rather than stb's per-texel loop. Thread safe.
+class ImageIngest
+{
+public:
+    ImageIngest() = delete;
+    ~ImageIngest() = delete;
+
+    // an encoded image (PNG, JPEG, TGA, ... whatever stb_image reads);
+    // null pixels if it doesn't decode. Free with stbi_image_free.
+    static TextureImage decode(const unsigned char *data, size_t size);
+    static TextureImage load(const std::string &path);
+
+    // `pixels` holds `count` texels of `channels` (1 grey, 2 grey + alpha,
+    // 3 RGB) at the front and has room for count * 4 bytes; they are
+    // widened to RGBA in place
+    static void expandToRGBA(unsigned char *pixels, int channels, size_t count);
+
+    // decodes every image in `directory` `repeats` times the old way
+    // (flipped, stb widening to RGBA), without the flip, and through
+    // decode(), and prints the time each takes
+    static void benchmark(const std::string &directory, int repeats);
+};
@@ -0,0 +1,110 @@
+#include "ImageWriter.hpp"
+#include "Console.hpp"
+#include <fstream>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+namespace
+{
+    uint32_t crc32(const unsigned char *data, size_t size, uint32_t crc = 0)
+    {
+        static uint32_t table[256];
+        static bool tableReady = false;
+        if (!tableReady)
+        {
+            for (uint32_t n = 0; n < 256; ++n)
+            {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                table[n] = c;
+            }
+            tableReady = true;
+        }
+
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i)
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    void putU32(std::vector<unsigned char> &out, uint32_t v)
+    {
+        out.push_back((unsigned char)(v >> 24));
+        out.push_back((unsigned char)(v >> 16));
+        out.push_back((unsigned char)(v >> 8));
+        out.push_back((unsigned char)v);
+    }
+
+    void putChunk(std::vector<unsigned char> &out, const char *type, const std::vector<unsigned char> &data)
+    {
+        putU32(out, (uint32_t)data.size());
+        size_t start = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data.begin(), data.end());
+        putU32(out, crc32(out.data() + start, out.size() - start));
+    }
+}
+
+bool ImageWriter::writePNG(const std::string &path, int width, int height, const unsigned char *rgba)
+{
+    // scanlines, each behind a 0 (no filter) byte
+    size_t rowBytes = (size_t)width * 4;
+    std::vector<unsigned char> raw;
+    raw.reserve((rowBytes + 1) * height);
+    for (int y = 0; y < height; ++y)
+    {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgba + y * rowBytes, rgba + (y + 1) * rowBytes);
+    }
+
+    // zlib stream of stored blocks
+    std::vector<unsigned char> z;
+    z.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    z.push_back(0x78);
+    z.push_back(0x01);
+    uint32_t a = 1, b = 0;
+    size_t pos = 0;
+    do
+    {
+        size_t len = std::min<size_t>(raw.size() - pos, 65535);
+        z.push_back(pos + len == raw.size() ? 1 : 0);
+        z.push_back((unsigned char)len);
+        z.push_back((unsigned char)(len >> 8));
+        z.push_back((unsigned char)~len);
+        z.push_back((unsigned char)(~len >> 8));
+        z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + len);
+        for (size_t i = pos; i < pos + len; ++i)
+        {
+            a = (a + raw[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        pos += len;
+    } while (pos < raw.size());
+    putU32(z, (b << 16) | a);
+
+    std::vector<unsigned char> header;
+    putU32(header, (uint32_t)width);
+    putU32(header, (uint32_t)height);
+    header.push_back(8); // bits per channel
+    header.push_back(6); // RGBA
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<unsigned char> png(signature, signature + 8);
+    putChunk(png, "IHDR", header);
+    putChunk(png, "IDAT", z);
+    putChunk(png, "IEND", {});
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        Console::LOGN("Failed to write " + path, Color::RED);
+        return false;
+    }
+    file.write((const char *)png.data(), (std::streamsize)png.size());
+    return (bool)file;
+}
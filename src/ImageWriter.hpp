@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+
+// Image output for CPU backends. vendor/ has no stb_image_write, and the
+// reference renders only need to be readable, so the PNG is written with
+// stored (uncompressed) deflate blocks.
+class ImageWriter
+{
+public:
+    ImageWriter() = delete;
+    ~ImageWriter() = delete;
+
+    // rgba: width * height RGBA8 pixels, top row first
+    static bool writePNG(const std::string &path, int width, int height, const unsigned char *rgba);
+};
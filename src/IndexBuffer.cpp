@@ -1,26 +1,70 @@
+#define GL_SUBSYSTEM GLSubsystemBuffers
 #include "IndexBuffer.hpp"
 #include "Renderer.hpp"
+#include "GLState.hpp"
+#include "VertexBuffer.hpp"
+#include <algorithm>
 
-IndexBuffer::IndexBuffer(const unsigned int *data, unsigned int count) : m_Count(count)
+IndexBuffer::IndexBuffer(const unsigned int *data, unsigned int count) : m_Count(data ? count : 0), m_Capacity(count)
 {
     ASSERT(sizeof(unsigned int) == sizeof(GLuint));
+    if (GLState::headless())
+    {
+        m_RendererId = GLState::headlessName();
+        m_Cpu.assign(count, 0);
+        if (data)
+            std::copy(data, data + count, m_Cpu.begin());
+        return;
+    }
+
     GLCall(glGenBuffers(1, &m_RendererId));
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererId));
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererId);
     GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));
 }
 
 
 IndexBuffer::~IndexBuffer()
 {
-    GLCall(glDeleteBuffers(1, &m_RendererId));
+    GLState::forgetBuffer(m_RendererId);
+    if (!GLState::headless())
+    {
+        GLCall(glDeleteBuffers(1, &m_RendererId));
+    }
+}
+
+void IndexBuffer::reserve(unsigned int capacity)
+{
+    if (capacity <= m_Capacity)
+        return;
+    if (GLState::headless())
+        m_Cpu.resize(capacity);
+    else
+        VertexBuffer::growStorage(m_RendererId, m_Capacity * sizeof(unsigned int),
+                                  capacity * sizeof(unsigned int), GL_STATIC_DRAW);
+    m_Capacity = capacity;
+}
+
+void IndexBuffer::setSubData(const unsigned int *data, unsigned int first, unsigned int count)
+{
+    ASSERT(first + count <= m_Capacity);
+    if (GLState::headless())
+        std::copy(data, data + count, m_Cpu.begin() + first);
+    else
+    {
+        Bind();
+        GLCall(glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, first * sizeof(unsigned int),
+                               count * sizeof(unsigned int), data));
+    }
+    if (first + count > m_Count)
+        m_Count = first + count;
 }
 
 void IndexBuffer::Bind() const
 {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererId));
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererId);
 }
 
 void IndexBuffer::UnBind() const
 {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererId));
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
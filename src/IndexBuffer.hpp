@@ -1,19 +1,29 @@
 #pragma once
 #include<iostream>
+#include <vector>
 class IndexBuffer
 {
 private:
     unsigned int m_RendererId;
     unsigned int m_Count;
+    unsigned int m_Capacity;
+    std::vector<unsigned int> m_Cpu; // headless: the indices
 public:
     IndexBuffer(const unsigned int* data, unsigned int count);
     ~IndexBuffer();
 
+    // grows to hold `capacity` indices, keeping the contents
+    void reserve(unsigned int capacity);
+    // writes indices at `first`; count grows to cover them
+    void setSubData(const unsigned int* data, unsigned int first, unsigned int count);
+
     void Bind()const;
     void UnBind()const;
 
     inline unsigned int getCount() const {return m_Count;}
     unsigned int GetRendererID() const { return m_RendererId; }
+    // headless only (null otherwise), for CPU backends
+    const unsigned int* getCpuData() const { return m_Cpu.empty() ? nullptr : m_Cpu.data(); }
 
 
 };
\ No newline at end of file
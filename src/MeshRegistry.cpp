@@ -0,0 +1,59 @@
+#define GL_SUBSYSTEM GLSubsystemBuffers
+#include "MeshRegistry.hpp"
+#include "Renderer.hpp"
+#include <algorithm>
+
+using MeshVertexLayout = VertexLayout<MeshVertex, VERTEX_ATTRIBUTE(MeshVertex, position),
+                                      VERTEX_ATTRIBUTE(MeshVertex, texCoord)>;
+
+MeshRegistry::MeshRegistry()
+{
+    m_VertexCapacity = 1024;
+    m_IndexCapacity = 4096;
+
+    m_VAO = new VertexArray();
+    m_VB = new VertexBuffer(nullptr, m_VertexCapacity * FloatsPerVertex * sizeof(float));
+
+    // the element binding is VAO state, so create the IB with it bound
+    m_VAO->Bind();
+    m_IB = new IndexBuffer(nullptr, m_IndexCapacity);
+
+    m_VAO->addBuffer(*m_VB, MeshVertexLayout::value);
+}
+
+MeshRegistry::~MeshRegistry()
+{
+    delete m_VAO;
+    delete m_VB;
+    delete m_IB;
+}
+
+MeshRegistry::MeshId MeshRegistry::add(const float *vertices, unsigned int vertexCount,
+                                       const unsigned int *indices, unsigned int indexCount)
+{
+    MeshRange range;
+    range.firstIndex = m_IB->getCount();
+    range.indexCount = indexCount;
+    range.baseVertex = (int)m_VertexCount;
+
+    const unsigned int vertexBytes = FloatsPerVertex * sizeof(float);
+
+    if (m_VertexCount + vertexCount > m_VertexCapacity)
+    {
+        m_VertexCapacity = std::max(m_VertexCount + vertexCount, m_VertexCapacity * 2);
+        m_VB->reserve(m_VertexCapacity * vertexBytes);
+    }
+    m_VB->setSubData(vertices, m_VertexCount * vertexBytes, vertexCount * vertexBytes);
+    m_VertexCount += vertexCount;
+
+    m_VAO->Bind();
+    if (range.firstIndex + indexCount > m_IndexCapacity)
+    {
+        m_IndexCapacity = std::max(range.firstIndex + indexCount, m_IndexCapacity * 2);
+        m_IB->reserve(m_IndexCapacity);
+    }
+    m_IB->setSubData(indices, range.firstIndex, indexCount);
+
+    m_Meshes.push_back(range);
+    return (MeshId)(m_Meshes.size() - 1);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "VertexArray.hpp"
+#include "VertexBuffer.hpp"
+#include "IndexBuffer.hpp"
+
+// What add() takes, FloatsPerVertex floats each.
+struct MeshVertex
+{
+    glm::vec3 position;
+    glm::vec2 texCoord;
+};
+
+// Where a mesh lives inside the registry's shared buffers.
+struct MeshRange
+{
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    int baseVertex;
+};
+
+// Layout fixed by GL (ARB_draw_indirect), one per sub-draw.
+struct DrawElementsIndirectCommand
+{
+    unsigned int count;
+    unsigned int instanceCount;
+    unsigned int firstIndex;
+    int baseVertex;
+    unsigned int baseInstance;
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 20, "indirect command must be 5 tightly packed uints");
+
+// Packs every mesh into one vertex buffer and one index buffer, so all of
+// them share a single VAO and can go out in one multi-draw. Indices are
+// stored mesh-local; baseVertex does the offset.
+// Vertices are MeshVertex.
+class MeshRegistry
+{
+public:
+    using MeshId = uint32_t;
+
+    static const unsigned int FloatsPerVertex = sizeof(MeshVertex) / sizeof(float);
+
+    MeshRegistry();
+    ~MeshRegistry();
+
+    MeshId add(const float *vertices, unsigned int vertexCount,
+               const unsigned int *indices, unsigned int indexCount);
+
+    const MeshRange &get(MeshId id) const { return m_Meshes[id]; }
+    size_t size() const { return m_Meshes.size(); }
+
+    // attributes 0 (position) and 1 (texcoord) are set up; callers add
+    // their instance streams from location 2
+    VertexArray &getVertexArray() { return *m_VAO; }
+    IndexBuffer &getIndexBuffer() { return *m_IB; }
+
+private:
+    VertexArray *m_VAO = nullptr;
+    VertexBuffer *m_VB = nullptr;
+    IndexBuffer *m_IB = nullptr;
+
+    unsigned int m_VertexCount = 0;
+    unsigned int m_VertexCapacity = 0;
+    unsigned int m_IndexCapacity = 0;
+
+    std::vector<MeshRange> m_Meshes;
+};
@@ -0,0 +1,258 @@
+#include "MipGenerator.hpp"
+#include "Texture.hpp"
+#include "ShaderCache.hpp"
+#include "Simd.hpp"
+#include "Console.hpp"
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const char Magic[4] = {'M', 'I', 'P', '1'};
+
+    struct FileHeader
+    {
+        char magic[4];
+        uint32_t filter;
+        int32_t width, height; // level 0
+        uint64_t hash;         // of level 0's pixels
+        uint64_t length;       // bytes of every level after the header
+    };
+
+    // in destination texels; at a 2:1 reduction that is 8 source taps
+    const float KaiserRadius = 2.0f;
+    const float KaiserAlpha = 4.0f;
+
+    float besselI0(float x)
+    {
+        // converges well before 20 terms for the alpha used here
+        float sum = 1.0f, term = 1.0f;
+        for (int k = 1; k < 20; ++k)
+        {
+            term *= (x * 0.5f / k) * (x * 0.5f / k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    float weight(MipFilter filter, float d)
+    {
+        if (filter == MipFilter::Box)
+            return std::fabs(d) <= 0.5f ? 1.0f : 0.0f;
+
+        float t = d / KaiserRadius;
+        if (std::fabs(t) >= 1.0f)
+            return 0.0f;
+        const float pi = 3.14159265358979f;
+        float sinc = d == 0.0f ? 1.0f : std::sin(pi * d) / (pi * d);
+        return sinc * besselI0(KaiserAlpha * std::sqrt(1.0f - t * t)) / besselI0(KaiserAlpha);
+    }
+
+    // per destination texel along one axis: `count` source indices
+    // (clamped to the edge) and their normalized weights
+    struct Taps
+    {
+        int count;
+        std::vector<int> index;
+        std::vector<float> weight;
+    };
+
+    Taps makeTaps(int src, int dst, MipFilter filter)
+    {
+        float radius = filter == MipFilter::Kaiser ? KaiserRadius : 0.5f;
+        float scale = (float)src / (float)dst;
+
+        Taps taps;
+        taps.count = (int)std::ceil(2.0f * radius * scale) + 1;
+        taps.index.resize((size_t)dst * taps.count);
+        taps.weight.resize((size_t)dst * taps.count);
+        for (int x = 0; x < dst; ++x)
+        {
+            float center = (x + 0.5f) * scale;
+            int first = (int)std::ceil(center - radius * scale - 0.5f);
+            float sum = 0.0f;
+            for (int k = 0; k < taps.count; ++k)
+            {
+                int i = first + k;
+                float w = weight(filter, (i + 0.5f - center) / scale);
+                taps.index[(size_t)x * taps.count + k] = std::min(std::max(i, 0), src - 1);
+                taps.weight[(size_t)x * taps.count + k] = w;
+                sum += w;
+            }
+            for (int k = 0; k < taps.count; ++k)
+                taps.weight[(size_t)x * taps.count + k] /= sum;
+        }
+        return taps;
+    }
+
+    // RGBA floats, `src` sw x sh into `dst` dw x dh
+    void downsample(const float *src, int sw, int sh, float *dst, int dw, int dh, MipFilter filter,
+                    std::vector<float> &rows)
+    {
+        Taps horizontal = makeTaps(sw, dw, filter);
+        Taps vertical = makeTaps(sh, dh, filter);
+
+        // every source row at the new width; four channels side by side
+        // is what the compiler vectorizes here
+        size_t rowFloats = (size_t)dw * 4;
+        rows.resize((size_t)sh * rowFloats);
+        for (int y = 0; y < sh; ++y)
+        {
+            const float *in = src + (size_t)y * sw * 4;
+            float *out = rows.data() + (size_t)y * rowFloats;
+            for (int x = 0; x < dw; ++x)
+            {
+                float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+                const int *index = &horizontal.index[(size_t)x * horizontal.count];
+                const float *w = &horizontal.weight[(size_t)x * horizontal.count];
+                for (int k = 0; k < horizontal.count; ++k)
+                {
+                    const float *texel = in + (size_t)index[k] * 4;
+                    for (int c = 0; c < 4; ++c)
+                        acc[c] += w[k] * texel[c];
+                }
+                for (int c = 0; c < 4; ++c)
+                    out[x * 4 + c] = acc[c];
+            }
+        }
+
+        // whole rows weighed together, simd::Width floats at a time
+        for (int y = 0; y < dh; ++y)
+        {
+            const int *index = &vertical.index[(size_t)y * vertical.count];
+            const float *w = &vertical.weight[(size_t)y * vertical.count];
+            float *out = dst + (size_t)y * rowFloats;
+            size_t i = 0;
+            for (; i + simd::Width <= rowFloats; i += simd::Width)
+            {
+                simd::f32 acc = simd::set1(0.0f);
+                for (int k = 0; k < vertical.count; ++k)
+                    acc = simd::madd(simd::set1(w[k]), simd::load(rows.data() + (size_t)index[k] * rowFloats + i), acc);
+                simd::store(out + i, acc);
+            }
+            for (; i < rowFloats; ++i)
+            {
+                float acc = 0.0f;
+                for (int k = 0; k < vertical.count; ++k)
+                    acc += w[k] * rows[(size_t)index[k] * rowFloats + i];
+                out[i] = acc;
+            }
+        }
+    }
+
+    unsigned char quantize(float value)
+    {
+        // Kaiser lobes overshoot on hard edges
+        return (unsigned char)std::min(std::max(value + 0.5f, 0.0f), 255.0f);
+    }
+
+    bool readCache(const std::string &path, MipFilter filter, const TextureImage &image, uint64_t hash,
+                   MipChain &chain)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        FileHeader header;
+        if (!file.read((char *)&header, sizeof(header)) || !std::equal(Magic, Magic + 4, header.magic) ||
+            header.filter != (uint32_t)filter || header.width != image.width || header.height != image.height ||
+            header.hash != hash)
+            return false;
+
+        // the level sizes follow from level 0, only the total is stored
+        chain.levels.clear();
+        size_t size = 0;
+        for (int w = image.width, h = image.height; w > 1 || h > 1;)
+        {
+            w = std::max(1, w / 2);
+            h = std::max(1, h / 2);
+            chain.levels.push_back({w, h, size});
+            size += (size_t)w * h * 4;
+        }
+        if (header.length != size)
+            return false;
+        chain.pixels.resize(size);
+        return (bool)file.read((char *)chain.pixels.data(), (std::streamsize)size);
+    }
+
+    void writeCache(const std::string &path, MipFilter filter, const TextureImage &image, uint64_t hash,
+                    const MipChain &chain)
+    {
+        // renamed over the old one, like ShaderCache, so readers never see half a file
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                Console::LOGN("[MipGenerator] can't write " + temporary, Color::YELLOW);
+                return;
+            }
+            FileHeader header = {{Magic[0], Magic[1], Magic[2], Magic[3]}, (uint32_t)filter, image.width,
+                                 image.height, hash, (uint64_t)chain.pixels.size()};
+            file.write((const char *)&header, sizeof(header));
+            file.write((const char *)chain.pixels.data(), (std::streamsize)chain.pixels.size());
+            if (!file)
+                return;
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+    }
+}
+
+int MipGenerator::levelCount(int width, int height)
+{
+    int levels = 1;
+    for (int size = std::max(width, height); size > 1; size /= 2)
+        ++levels;
+    return levels;
+}
+
+void MipGenerator::build(const TextureImage &image, MipFilter filter, MipChain &chain)
+{
+    chain.levels.clear();
+    chain.pixels.clear();
+    if (filter == MipFilter::Driver || !image.pixels)
+        return;
+
+    int width = image.width, height = image.height;
+    std::vector<float> current((size_t)width * height * 4);
+    for (size_t i = 0; i < current.size(); ++i)
+        current[i] = image.pixels[i];
+    std::vector<float> next, rows;
+
+    // a full chain is a third of level 0
+    chain.pixels.reserve(current.size() / 3 + 4);
+    while (width > 1 || height > 1)
+    {
+        int w = std::max(1, width / 2);
+        int h = std::max(1, height / 2);
+        next.resize((size_t)w * h * 4);
+        downsample(current.data(), width, height, next.data(), w, h, filter, rows);
+
+        size_t offset = chain.pixels.size();
+        chain.levels.push_back({w, h, offset});
+        chain.pixels.resize(offset + next.size());
+        for (size_t i = 0; i < next.size(); ++i)
+            chain.pixels[offset + i] = quantize(next[i]);
+
+        current.swap(next);
+        width = w;
+        height = h;
+    }
+}
+
+void MipGenerator::buildCached(const std::string &sourcePath, const TextureImage &image, MipFilter filter,
+                               MipChain &chain)
+{
+    if (filter == MipFilter::Driver || !image.pixels)
+        return build(image, filter, chain);
+
+    uint64_t hash = ShaderCache::hash(image.pixels, (size_t)image.width * image.height * 4);
+    std::string path = sourcePath + ".mips";
+    if (readCache(path, filter, image, hash, chain))
+        return;
+
+    build(image, filter, chain);
+    writeCache(path, filter, image, hash, chain);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct TextureImage;
+
+// How the levels below 0 are made.
+enum class MipFilter : uint32_t
+{
+    Box,    // 2x2 average; fast, a little soft and prone to aliasing
+    Kaiser, // Kaiser-windowed sinc over 8 taps per axis; keeps detail
+    Driver  // glGenerateMipmap after level 0 is uploaded, nothing on the CPU
+};
+
+// Levels 1 and down of an image, RGBA8, top row first like level 0.
+struct MipChain
+{
+    struct Level
+    {
+        int width, height;
+        size_t offset; // into pixels
+    };
+    std::vector<Level> levels;
+    std::vector<unsigned char> pixels;
+
+    const unsigned char *levelPixels(size_t level) const { return pixels.data() + levels[level].offset; }
+};
+
+// CPU mip generation. Each level is filtered from the float result of the
+// one above, not from its 8-bit copy, so rounding doesn't pile up down the
+// chain. The filter is separable: a horizontal pass per source row, then a
+// vertical pass that weighs whole rows at once with simd::f32.
+//
+// build() can run on any thread; TextureLoader calls it on its workers.
+class MipGenerator
+{
+public:
+    MipGenerator() = delete;
+    ~MipGenerator() = delete;
+
+    // level 0 included, down to 1x1
+    static int levelCount(int width, int height);
+
+    // MipFilter::Driver leaves `chain` empty
+    static void build(const TextureImage &image, MipFilter filter, MipChain &chain);
+
+    // build() through "<sourcePath>.mips", which holds the chain with a
+    // hash of level 0 and the filter; a mismatch rebuilds and rewrites it
+    static void buildCached(const std::string &sourcePath, const TextureImage &image, MipFilter filter,
+                            MipChain &chain);
+};
@@ -0,0 +1,29 @@
+#include "NullRenderer.hpp"
+
+void NullRenderer::Draw(const VertexArray &, IndexBuffer &, const Shader &) const
+{
+}
+
+void NullRenderer::DrawInstanced(const VertexArray &, IndexBuffer &, const Shader &, unsigned int) const
+{
+}
+
+void NullRenderer::DrawMesh(const VertexArray &, IndexBuffer &, const Shader &, const MeshRange &) const
+{
+}
+
+void NullRenderer::Clear(const glm::vec4 &) const
+{
+}
+
+void NullRenderer::Submit(const DrawPacket &)
+{
+    m_Submitted++;
+}
+
+void NullRenderer::Flush()
+{
+    m_QueueStats = RenderQueueStats();
+    m_QueueStats.packets = m_Submitted;
+    m_Submitted = 0;
+}
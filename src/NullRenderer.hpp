@@ -0,0 +1,21 @@
+#pragma once
+#include "Renderer.hpp"
+
+// Renderer that drops every draw. With GLState headless it lets the engine
+// run its whole frame loop without a GL driver, so what gets measured is
+// only the CPU side: simulation, culling, stream writes and Submit().
+class NullRenderer : public Renderer
+{
+public:
+    void Draw(const VertexArray& va, IndexBuffer& ib, const Shader& shader) const override;
+    void DrawInstanced(const VertexArray& va, IndexBuffer& ib, const Shader& shader, unsigned int instanceCount) const override;
+    void DrawMesh(const VertexArray& va, IndexBuffer& ib, const Shader& shader, const MeshRange& mesh) const override;
+    void Clear(const glm::vec4& color) const override;
+
+    // counts packets (reported as RenderQueueStats::packets), keeps nothing
+    void Submit(const DrawPacket& packet) override;
+    void Flush() override;
+
+private:
+    unsigned int m_Submitted = 0;
+};
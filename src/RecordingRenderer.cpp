@@ -0,0 +1,164 @@
+#include "RecordingRenderer.hpp"
+#include "Texture.hpp"
+#include "Console.hpp"
+#include <string>
+
+void RecordingRenderer::record(const RecordedCommand &command) const
+{
+    m_Log.push_back(command);
+    m_Totals.commands++;
+    if (command.type == RecordedCommand::Type::Clear)
+        return;
+
+    m_Totals.drawCalls++;
+    m_Totals.subDraws += command.subDraws;
+    m_Totals.instances += command.instanceCount;
+    m_Totals.indices += command.indexCount;
+}
+
+void RecordingRenderer::Draw(const VertexArray &va, IndexBuffer &ib, const Shader &shader) const
+{
+    RecordedCommand c;
+    c.type = RecordedCommand::Type::Draw;
+    c.program = shader.GetRendererID();
+    c.vao = va.GetRendererID();
+    c.indexCount = ib.getCount();
+    c.instanceCount = 1;
+    c.bytes = (uint64_t)c.indexCount * sizeof(unsigned int);
+    m_Totals.indexBytes += c.bytes;
+    record(c);
+}
+
+void RecordingRenderer::DrawInstanced(const VertexArray &va, IndexBuffer &ib, const Shader &shader, unsigned int instanceCount) const
+{
+    RecordedCommand c;
+    c.type = RecordedCommand::Type::DrawInstanced;
+    c.program = shader.GetRendererID();
+    c.vao = va.GetRendererID();
+    c.indexCount = ib.getCount();
+    c.instanceCount = instanceCount;
+
+    uint64_t indexBytes = (uint64_t)c.indexCount * sizeof(unsigned int);
+    uint64_t instanceBytes = (uint64_t)instanceCount * va.getInstanceStride();
+    c.bytes = indexBytes + instanceBytes;
+    m_Totals.indexBytes += indexBytes;
+    m_Totals.instanceBytes += instanceBytes;
+    record(c);
+}
+
+void RecordingRenderer::DrawMesh(const VertexArray &va, IndexBuffer &, const Shader &shader, const MeshRange &mesh) const
+{
+    RecordedCommand c;
+    c.type = RecordedCommand::Type::DrawMesh;
+    c.program = shader.GetRendererID();
+    c.vao = va.GetRendererID();
+    c.indexCount = mesh.indexCount;
+    c.instanceCount = 1;
+    c.bytes = (uint64_t)c.indexCount * sizeof(unsigned int);
+    m_Totals.indexBytes += c.bytes;
+    record(c);
+}
+
+void RecordingRenderer::Clear(const glm::vec4 &) const
+{
+    RecordedCommand c;
+    c.type = RecordedCommand::Type::Clear;
+    record(c);
+}
+
+// same walk as Renderer::Flush, with the GL calls replaced by log entries
+void RecordingRenderer::Flush()
+{
+    m_QueueStats = RenderQueueStats();
+    m_QueueStats.packets = (unsigned int)m_Packets.size();
+    m_Totals.flushes++;
+    if (m_Packets.empty())
+        return;
+
+    sortPackets();
+
+    const Shader *boundShader = nullptr;
+    const VertexArray *boundVA = nullptr;
+    const Texture *boundTexture = nullptr;
+    int blend = -1;
+
+    for (const SortEntry &entry : m_SortEntries)
+    {
+        const DrawPacket &p = m_Packets[entry.packet];
+
+        if (p.shader != boundShader)
+        {
+            boundShader = p.shader;
+            m_QueueStats.programSwitches++;
+        }
+        if (p.va != boundVA)
+        {
+            boundVA = p.va;
+            m_QueueStats.vaoSwitches++;
+        }
+        if (p.texture && p.texture != boundTexture)
+        {
+            boundTexture = p.texture;
+            m_QueueStats.textureSwitches++;
+        }
+        if ((int)p.blend != blend)
+        {
+            blend = (int)p.blend;
+            m_QueueStats.blendSwitches++;
+        }
+
+        RecordedCommand c;
+        c.type = RecordedCommand::Type::Packet;
+        c.blend = p.blend;
+        c.program = p.shader ? p.shader->GetRendererID() : 0;
+        c.vao = p.va ? p.va->GetRendererID() : 0;
+        c.texture = p.texture ? p.texture->GetRendererID() : 0;
+        c.subDraws = p.commandCount;
+
+        if (p.commandCount == 0)
+        {
+            c.indexCount = p.indexCount ? p.indexCount : (p.ib ? p.ib->getCount() : 0);
+            c.instanceCount = p.instanceCount;
+        }
+        for (unsigned int i = 0; i < p.commandCount; ++i)
+        {
+            c.indexCount += p.commands[i].count;
+            c.instanceCount += p.commands[i].instanceCount;
+        }
+
+        uint64_t indexBytes = (uint64_t)c.indexCount * sizeof(unsigned int);
+        uint64_t instanceBytes = p.va ? (uint64_t)c.instanceCount * p.va->getInstanceStride() : 0;
+        uint64_t indirectBytes = (uint64_t)p.commandCount * sizeof(DrawElementsIndirectCommand);
+        c.bytes = indexBytes + instanceBytes + indirectBytes;
+        m_Totals.indexBytes += indexBytes;
+        m_Totals.instanceBytes += instanceBytes;
+        m_Totals.indirectBytes += indirectBytes;
+
+        record(c);
+        m_QueueStats.drawCalls++;
+    }
+
+    m_Packets.clear();
+    m_SortEntries.clear();
+}
+
+void RecordingRenderer::reset()
+{
+    m_Log.clear();
+    m_Totals = RecordingTotals();
+}
+
+void RecordingRenderer::printSummary() const
+{
+    const RecordingTotals &t = m_Totals;
+    Console::LOGN("[RecordingRenderer] " + std::to_string(t.flushes) + " flushes, " +
+                      std::to_string(t.commands) + " commands, " +
+                      std::to_string(t.drawCalls) + " draw calls (" +
+                      std::to_string(t.subDraws) + " multi-draw sub-draws)",
+                  Color::GREEN);
+    Console::LOGN("  instances: " + std::to_string(t.instances) +
+                  ", indices: " + std::to_string(t.indices));
+    Console::LOGN("  bytes: index " + std::to_string(t.indexBytes) +
+                  ", instance " + std::to_string(t.instanceBytes) +
+                  ", indirect " + std::to_string(t.indirectBytes));
+}
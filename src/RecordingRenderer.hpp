@@ -0,0 +1,64 @@
+#pragma once
+#include "Renderer.hpp"
+#include <vector>
+#include <cstdint>
+
+// One entry in RecordingRenderer's log.
+struct RecordedCommand
+{
+    enum class Type : uint8_t { Clear, Draw, DrawInstanced, DrawMesh, Packet };
+
+    Type type = Type::Draw;
+    BlendMode blend = BlendMode::Opaque;
+    // GL names, or GLState::headlessName() ones when headless
+    unsigned int program = 0;
+    unsigned int vao = 0;
+    unsigned int texture = 0;
+    unsigned int indexCount = 0;    // summed over sub-draws
+    unsigned int instanceCount = 0; // summed over sub-draws
+    unsigned int subDraws = 0;      // multi-draw commands, 0 for a plain draw
+    uint64_t bytes = 0;             // indices + instance attributes + indirect commands read
+};
+
+// Running totals since construction (or reset()).
+struct RecordingTotals
+{
+    uint64_t flushes = 0;
+    uint64_t commands = 0;
+    uint64_t drawCalls = 0;
+    uint64_t subDraws = 0;
+    uint64_t instances = 0;
+    uint64_t indices = 0;
+    uint64_t indexBytes = 0;
+    uint64_t instanceBytes = 0;
+    uint64_t indirectBytes = 0;
+};
+
+// Renderer that issues nothing and logs every draw instead. Flush() sorts
+// and walks the queue like Renderer does, so RenderQueueStats (switches,
+// draw calls) match what the GL backend would report for the same frame.
+class RecordingRenderer : public Renderer
+{
+public:
+    void Draw(const VertexArray& va, IndexBuffer& ib, const Shader& shader) const override;
+    void DrawInstanced(const VertexArray& va, IndexBuffer& ib, const Shader& shader, unsigned int instanceCount) const override;
+    void DrawMesh(const VertexArray& va, IndexBuffer& ib, const Shader& shader, const MeshRange& mesh) const override;
+    void Clear(const glm::vec4& color) const override;
+
+    void Flush() override;
+
+    const std::vector<RecordedCommand>& getLog() const { return m_Log; }
+    const RecordingTotals& getTotals() const { return m_Totals; }
+    // drops the log, keeps the totals
+    void clearLog() { m_Log.clear(); }
+    void reset();
+
+    void printSummary() const;
+
+private:
+    // the immediate Draw* calls are const on Renderer
+    mutable std::vector<RecordedCommand> m_Log;
+    mutable RecordingTotals m_Totals;
+
+    void record(const RecordedCommand& command) const;
+};
@@ -1,15 +1,25 @@
 #include"Renderer.hpp"
+#include "Texture.hpp"
+#include "GLExtensions.hpp"
 #include "Console.hpp"
 #include<iostream>
+#include <algorithm>
+#include <cstring>
 
-void GLClearError()
+unsigned int g_GLCheckedSubsystems = GL_CHECK_SUBSYSTEMS;
+
+void GLClearError(unsigned int subsystem)
 {
+    if (!(g_GLCheckedSubsystems & subsystem))
+        return;
     while (glGetError() != GL_NO_ERROR)
         ;
 }
 
-bool GLLogCall(const char* function, const char* file, int line)
+bool GLLogCall(unsigned int subsystem, const char* function, const char* file, int line)
 {
+    if (!(g_GLCheckedSubsystems & subsystem))
+        return true;
     while (GLenum error = glGetError())
     {
         Console::LOGN("[OpenGL ERROR] (" + std::to_string(error) + ")", Color::RED);
@@ -21,8 +31,15 @@ bool GLLogCall(const char* function, const char* file, int line)
 }
 
 
+Renderer::~Renderer()
+{
+    delete m_IndirectBuffer;
+}
+
 void Renderer::Draw(const VertexArray &va, IndexBuffer &ib, const Shader &shader) const
 {
+    if (!shader.isReady())
+        return;
     shader.Bind();
     va.Bind();
     ib.Bind();
@@ -30,10 +47,241 @@ void Renderer::Draw(const VertexArray &va, IndexBuffer &ib, const Shader &shader
 
 }
 
+void Renderer::DrawInstanced(const VertexArray &va, IndexBuffer &ib, const Shader &shader, unsigned int instanceCount) const
+{
+    if (!shader.isReady())
+        return;
+    shader.Bind();
+    va.Bind();
+    ib.Bind();
+    GLCall(glDrawElementsInstanced(GL_TRIANGLES, ib.getCount(), GL_UNSIGNED_INT, nullptr, instanceCount));
+}
+
+void Renderer::DrawMesh(const VertexArray &va, IndexBuffer &ib, const Shader &shader, const MeshRange &mesh) const
+{
+    if (!shader.isReady())
+        return;
+    shader.Bind();
+    va.Bind();
+    ib.Bind();
+    GLCall(glDrawElementsBaseVertex(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT,
+                                    (const void *)(uintptr_t)(mesh.firstIndex * sizeof(unsigned int)),
+                                    mesh.baseVertex));
+}
+
 void Renderer::Clear(const glm::vec4& color) const
 {
     glClearColor(color.r, color.g, color.b, color.a);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
+// ------------------------------------------------------------
+// Sort key
+// ------------------------------------------------------------
+//  opaque: | 0 | program:12 | vao:12 | texture:12 | depth:24 | 3 unused |
+//  alpha:  | 1 | ~depth:24  | program:12 | vao:12 | texture:12 | 3 unused |
+// Opaque packets group by state and go front to back inside a group,
+// alpha packets go back to front. GL names are masked to 12 bits, which
+// only costs batching (never correctness) past 4096 objects.
+uint64_t Renderer::makeSortKey(const DrawPacket &packet)
+{
+    uint64_t program = packet.shader ? packet.shader->GetRendererID() & 0xFFF : 0;
+    uint64_t vao = packet.va ? packet.va->GetRendererID() & 0xFFF : 0;
+    uint64_t texture = packet.texture ? packet.texture->GetRendererID() & 0xFFF : 0;
+
+    // non-negative floats sort like their bit patterns; keep the top 24 bits
+    float d = std::max(packet.depth, 0.0f);
+    uint32_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    uint64_t depth = bits >> 8;
+
+    if (packet.blend == BlendMode::Opaque)
+        return (program << 51) | (vao << 39) | (texture << 27) | (depth << 3);
+
+    uint64_t farFirst = (~depth) & 0xFFFFFF;
+    return (1ull << 63) | (farFirst << 39) | (program << 27) | (vao << 15) | (texture << 3);
+}
+
+void Renderer::Submit(const DrawPacket &packet)
+{
+    m_SortEntries.push_back({makeSortKey(packet), (uint32_t)m_Packets.size()});
+    m_Packets.push_back(packet);
+}
+
+// LSD radix sort, 8 bits per pass; passes where every key shares the
+// same byte are skipped, which is most of them for small queues
+void Renderer::sortPackets()
+{
+    size_t n = m_SortEntries.size();
+    m_SortScratch.resize(n);
+
+    SortEntry *src = m_SortEntries.data();
+    SortEntry *dst = m_SortScratch.data();
+
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        size_t counts[256] = {};
+        for (size_t i = 0; i < n; ++i)
+            counts[(src[i].key >> shift) & 0xFF]++;
+
+        if (counts[(src[0].key >> shift) & 0xFF] == n)
+            continue;
+
+        size_t sum = 0;
+        for (size_t &c : counts)
+        {
+            size_t tmp = c;
+            c = sum;
+            sum += tmp;
+        }
+
+        for (size_t i = 0; i < n; ++i)
+            dst[counts[(src[i].key >> shift) & 0xFF]++] = src[i];
+
+        std::swap(src, dst);
+    }
+
+    if (src != m_SortEntries.data())
+        m_SortEntries.swap(m_SortScratch);
+}
+
+void Renderer::Flush()
+{
+    m_QueueStats = RenderQueueStats();
+    m_QueueStats.packets = (unsigned int)m_Packets.size();
+    if (m_Packets.empty())
+        return;
+
+    sortPackets();
+
+    // all indirect commands of this flush go up in one write
+    unsigned int totalCommands = 0;
+    for (const DrawPacket &p : m_Packets)
+        totalCommands += p.commandCount;
+
+    bool indirect = totalCommands > 0 && GLExtensions::ARB_multi_draw_indirect;
+    if (indirect)
+    {
+        if (!m_IndirectBuffer)
+            m_IndirectBuffer = new StreamBuffer(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand), 256);
+        if (totalCommands > m_IndirectBuffer->getElementsPerFrame())
+            m_IndirectBuffer->resize(std::max(totalCommands, m_IndirectBuffer->getElementsPerFrame() * 2));
+        m_IndirectBuffer->beginFrame();
+    }
+
+    const Shader *boundShader = nullptr;
+    const VertexArray *boundVA = nullptr;
+    const Texture *boundTexture = nullptr;
+    int blend = -1; // unknown until the first packet
+
+    for (const SortEntry &entry : m_SortEntries)
+    {
+        const DrawPacket &p = m_Packets[entry.packet];
+
+        // never wait on the compiler mid-frame; the draw shows up once ready
+        if (!p.shader->isReady())
+        {
+            m_QueueStats.skippedPackets++;
+            continue;
+        }
+        if (p.shader != boundShader)
+        {
+            p.shader->Bind();
+            boundShader = p.shader;
+            m_QueueStats.programSwitches++;
+        }
+        if (p.va != boundVA)
+        {
+            p.va->Bind();
+            p.ib->Bind();
+            boundVA = p.va;
+            m_QueueStats.vaoSwitches++;
+        }
+        if (p.texture && p.texture != boundTexture)
+        {
+            p.texture->Bind(0);
+            boundTexture = p.texture;
+            m_QueueStats.textureSwitches++;
+        }
+        if ((int)p.blend != blend)
+        {
+            if (p.blend == BlendMode::Alpha)
+            {
+                GLCall(glEnable(GL_BLEND));
+                GLCall(glDepthMask(GL_FALSE));
+            }
+            else
+            {
+                GLCall(glDisable(GL_BLEND));
+                GLCall(glDepthMask(GL_TRUE));
+            }
+            blend = (int)p.blend;
+            m_QueueStats.blendSwitches++;
+        }
+
+        if (p.commandCount == 0)
+            drawPacket(p);
+        else if (indirect)
+            drawMulti(p, m_IndirectBuffer->write(p.commands, p.commandCount));
+        else
+            drawMultiFallback(p);
+    }
+
+    if (indirect)
+        m_IndirectBuffer->endFrame();
+
+    // leave the defaults App::initGL set up
+    GLCall(glEnable(GL_BLEND));
+    GLCall(glDepthMask(GL_TRUE));
+
+    m_Packets.clear();
+    m_SortEntries.clear();
+}
+
+void Renderer::drawPacket(const DrawPacket &p)
+{
+    unsigned int count = p.indexCount ? p.indexCount : p.ib->getCount();
+    const void *offset = (const void *)(uintptr_t)(p.firstIndex * sizeof(unsigned int));
 
+    p.va->setBaseInstance(p.firstInstance);
+    if (p.baseVertex)
+    {
+        GLCall(glDrawElementsInstancedBaseVertex(GL_TRIANGLES, count, GL_UNSIGNED_INT, offset,
+                                                 p.instanceCount, p.baseVertex));
+    }
+    else
+    {
+        GLCall(glDrawElementsInstanced(GL_TRIANGLES, count, GL_UNSIGNED_INT, offset, p.instanceCount));
+    }
+    m_QueueStats.drawCalls++;
+}
+
+// every sub-draw in one call; base instances come from the commands
+void Renderer::drawMulti(const DrawPacket &p, unsigned int indirectFirst)
+{
+    p.va->setBaseInstance(0);
+    m_IndirectBuffer->Bind();
+    GLCall(GLExtensions::MultiDrawElementsIndirect(
+        GL_TRIANGLES, GL_UNSIGNED_INT,
+        (const void *)(uintptr_t)(indirectFirst * sizeof(DrawElementsIndirectCommand)),
+        p.commandCount, 0));
+    m_QueueStats.drawCalls++;
+}
+
+// Without multi-draw indirect this is a loop: one instanced draw per
+// command, with the VAO re-based to its instances. GL 3.3 can't merge
+// them; a glMultiDrawElementsBaseVertex has neither gl_DrawID nor a base
+// instance, so every sub-draw would read the same per-instance data.
+void Renderer::drawMultiFallback(const DrawPacket &p)
+{
+    for (unsigned int i = 0; i < p.commandCount; ++i)
+    {
+        const DrawElementsIndirectCommand &command = p.commands[i];
+        p.va->setBaseInstance(command.baseInstance);
+        GLCall(glDrawElementsInstancedBaseVertex(
+            GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+            (const void *)(uintptr_t)(command.firstIndex * sizeof(unsigned int)),
+            command.instanceCount, command.baseVertex));
+        m_QueueStats.drawCalls++;
+    }
+}
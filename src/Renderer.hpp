@@ -1,25 +1,152 @@
 #pragma once
 //#include <GLFW/glfw3.h>
+#include <vector>
+#include <cstdint>
 #include "VertexArray.hpp"
 #include "IndexBuffer.hpp"
 #include "Shader.hpp"
+#include "MeshRegistry.hpp"
+#include "StreamBuffer.hpp"
 
 
+// ------------------------------------------------------------
+// GL error checking
+// ------------------------------------------------------------
+// GL_ERROR_CHECKS=1: GLCall brackets the call with glGetError, but only
+//   for subsystems in the check mask (GL_CHECK_SUBSYSTEMS at build time,
+//   GLSetCheckedSubsystems() at run time).
+// GL_ERROR_CHECKS=0: GLCall(x) is just x. Errors arrive asynchronously
+//   through the KHR_debug callback instead, see GLDebug.
+// Defaults to 0 with NDEBUG, 1 otherwise.
+#ifndef GL_ERROR_CHECKS
+#ifdef NDEBUG
+#define GL_ERROR_CHECKS 0
+#else
+#define GL_ERROR_CHECKS 1
+#endif
+#endif
+
+enum GLSubsystem : unsigned int
+{
+    GLSubsystemCore     = 1u << 0, // Renderer, Graphicsengine
+    GLSubsystemBuffers  = 1u << 1, // vertex/index buffers, VAOs
+    GLSubsystemShaders  = 1u << 2,
+    GLSubsystemTextures = 1u << 3,
+    GLSubsystemState    = 1u << 4, // GLState binds
+    GLSubsystemAll      = ~0u
+};
+
+#ifndef GL_CHECK_SUBSYSTEMS
+#define GL_CHECK_SUBSYSTEMS GLSubsystemAll
+#endif
+
+// a .cpp picks its subsystem by defining GL_SUBSYSTEM before any include
+#ifndef GL_SUBSYSTEM
+#define GL_SUBSYSTEM GLSubsystemCore
+#endif
+
 #define ASSERT(x) \
     if (!(x))     \
         __builtin_debugtrap();
-#define GLCall(x)   \
-    GLClearError(); \
-    x;              \
-    ASSERT(GLLogCall(#x, __FILE__, __LINE__))
 
-void GLClearError();
-bool GLLogCall(const char *function, const char *file, int line);
+#if GL_ERROR_CHECKS
+#define GLCall(x)                 \
+    GLClearError(GL_SUBSYSTEM);   \
+    x;                            \
+    ASSERT(GLLogCall(GL_SUBSYSTEM, #x, __FILE__, __LINE__))
+#else
+#define GLCall(x) x
+#endif
+
+extern unsigned int g_GLCheckedSubsystems;
+
+inline void GLSetCheckedSubsystems(unsigned int mask) { g_GLCheckedSubsystems = mask; }
+inline unsigned int GLGetCheckedSubsystems() { return g_GLCheckedSubsystems; }
+
+void GLClearError(unsigned int subsystem);
+bool GLLogCall(unsigned int subsystem, const char *function, const char *file, int line);
+
+class Texture;
+
+enum class BlendMode : uint8_t
+{
+    Opaque = 0,
+    Alpha = 1 // drawn after all opaque packets, back to front
+};
+
+// One recorded draw. Uniforms are per program, so anything that differs
+// between packets must come from instance streams, not uniforms.
+struct DrawPacket
+{
+    const Shader* shader = nullptr;
+    const VertexArray* va = nullptr;
+    const IndexBuffer* ib = nullptr;
+    const Texture* texture = nullptr; // bound to slot 0, may be null
+    // view-space distance, >= 0; a batch uses its nearest instance when
+    // opaque, its farthest when blended
+    float depth = 0.0f;
+    BlendMode blend = BlendMode::Opaque;
+    unsigned int firstInstance = 0;
+    unsigned int instanceCount = 1;
+    // index range inside ib; indexCount 0 means the whole buffer
+    unsigned int firstIndex = 0;
+    unsigned int indexCount = 0;
+    int baseVertex = 0;
+
+    // multi-draw: commandCount sub-draws sharing this packet's state, each
+    // with its own index range and instances (base instance included).
+    // The array must stay alive until Flush().
+    const DrawElementsIndirectCommand* commands = nullptr;
+    unsigned int commandCount = 0;
+};
+
+struct RenderQueueStats
+{
+    unsigned int packets = 0;
+    unsigned int programSwitches = 0;
+    unsigned int vaoSwitches = 0;
+    unsigned int textureSwitches = 0;
+    unsigned int blendSwitches = 0;
+    unsigned int drawCalls = 0;
+    unsigned int skippedPackets = 0; // program still compiling
+};
 
 class Renderer
 {
 public:
-    virtual ~Renderer() = default;
+    virtual ~Renderer();
     virtual void Draw(const VertexArray& va, IndexBuffer& ib, const Shader& shader) const;
+    virtual void DrawInstanced(const VertexArray& va, IndexBuffer& ib, const Shader& shader, unsigned int instanceCount) const;
+    virtual void DrawMesh(const VertexArray& va, IndexBuffer& ib, const Shader& shader, const MeshRange& mesh) const;
     virtual void Clear(const glm::vec4& color) const;
-};
\ No newline at end of file
+
+    // Deferred path: Submit() records, Flush() sorts by key and replays
+    // with the fewest program / VAO / texture / blend changes.
+    virtual void Submit(const DrawPacket& packet);
+    virtual void Flush();
+
+    const RenderQueueStats& getQueueStats() const { return m_QueueStats; }
+
+    static uint64_t makeSortKey(const DrawPacket& packet);
+
+protected:
+    struct SortEntry
+    {
+        uint64_t key;
+        uint32_t packet;
+    };
+
+    std::vector<DrawPacket> m_Packets;
+    std::vector<SortEntry> m_SortEntries;
+    std::vector<SortEntry> m_SortScratch;
+    RenderQueueStats m_QueueStats;
+
+    // multi-draw commands go through here on GL 4.3+; without it each
+    // command is a draw call of its own (drawMultiFallback)
+    StreamBuffer* m_IndirectBuffer = nullptr;
+
+    void sortPackets();
+    void drawPacket(const DrawPacket& packet);
+    void drawMulti(const DrawPacket& packet, unsigned int indirectFirst);
+    void drawMultiFallback(const DrawPacket& packet);
+};
@@ -0,0 +1,238 @@
+#include "ResourceCache.hpp"
+#include "TextureLoader.hpp"
+#include "ShaderVariants.hpp"
+#include "Console.hpp"
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <filesystem>
+#include <system_error>
+
+namespace
+{
+    // frame boundaries between the last release() and the delete; the
+    // renderer's queue and the stream buffers never look further back
+    const uint32_t ReleaseFrames = 3;
+
+    uint32_t s_Frame = 0;
+    ResourceCacheStats s_Stats;
+
+    template <typename T>
+    struct Table
+    {
+        struct Slot
+        {
+            T *object = nullptr;
+            uint32_t generation = 1;
+            uint32_t refs = 0;
+            uint32_t releasedAt = 0; // s_Frame when refs reached 0
+            bool releasing = false;  // in `released`
+            std::string key;
+        };
+
+        // a deque, so slots never move (getSlot)
+        std::deque<Slot> slots;
+        std::vector<uint32_t> free;
+        std::unordered_map<std::string, uint32_t> byKey;
+        std::vector<uint32_t> released;
+
+        Slot *find(ResourceHandle<T> handle)
+        {
+            if (handle.index >= slots.size())
+                return nullptr;
+            Slot &slot = slots[handle.index];
+            return slot.object && slot.generation == handle.generation ? &slot : nullptr;
+        }
+
+        template <typename Load>
+        ResourceHandle<T> acquire(const std::string &key, Load load)
+        {
+            auto it = byKey.find(key);
+            if (it != byKey.end())
+            {
+                Slot &slot = slots[it->second];
+                slot.refs++;
+                s_Stats.shared++;
+                return {it->second, slot.generation};
+            }
+
+            uint32_t index;
+            if (!free.empty())
+            {
+                index = free.back();
+                free.pop_back();
+            }
+            else
+            {
+                index = (uint32_t)slots.size();
+                slots.emplace_back();
+            }
+            Slot &slot = slots[index];
+            slot.object = load();
+            slot.refs = 1;
+            slot.key = key;
+            byKey.emplace(key, index);
+            s_Stats.loads++;
+            return {index, slot.generation};
+        }
+
+        void retain(ResourceHandle<T> handle)
+        {
+            if (Slot *slot = find(handle))
+                slot->refs++;
+        }
+
+        void release(ResourceHandle<T> handle)
+        {
+            Slot *slot = find(handle);
+            if (!slot || slot->refs == 0)
+                return;
+            if (--slot->refs > 0)
+                return;
+            slot->releasedAt = s_Frame;
+            if (!slot->releasing)
+            {
+                slot->releasing = true;
+                released.push_back(handle.index);
+            }
+        }
+
+        void destroy(uint32_t index)
+        {
+            Slot &slot = slots[index];
+            byKey.erase(slot.key);
+            delete slot.object;
+            slot.object = nullptr;
+            slot.key.clear();
+            slot.refs = 0;
+            slot.releasing = false;
+            // every handle to it is stale from here; 0 stays the null one
+            if (++slot.generation == 0)
+                slot.generation = 1;
+            free.push_back(index);
+        }
+
+        void collect()
+        {
+            size_t kept = 0;
+            for (uint32_t index : released)
+            {
+                Slot &slot = slots[index];
+                if (slot.refs > 0)
+                    slot.releasing = false; // loaded again meanwhile
+                else if (s_Frame - slot.releasedAt >= ReleaseFrames)
+                    destroy(index);
+                else
+                    released[kept++] = index;
+            }
+            released.resize(kept);
+        }
+
+        void clear(const char *kind)
+        {
+            for (uint32_t i = 0; i < slots.size(); ++i)
+            {
+                if (!slots[i].object)
+                    continue;
+                if (slots[i].refs > 0)
+                {
+                    Console::LOGN(std::string("ResourceCache: ") + kind + " " + slots[i].key + " still has " +
+                                      std::to_string(slots[i].refs) + " users",
+                                  Color::YELLOW);
+                }
+                destroy(i);
+            }
+            released.clear();
+        }
+
+        unsigned int alive() const { return (unsigned int)(slots.size() - free.size()); }
+    };
+
+    Table<Texture> s_Textures;
+    Table<ShaderVariants> s_Shaders;
+
+    std::string textureKey(const std::string &path, const TextureSampling &sampling)
+    {
+        return ResourceCache::canonicalPath(path) + "|" + std::to_string(sampling.mipmaps) +
+               std::to_string((int)sampling.mipFilter) + std::to_string(sampling.trilinear) + "|" +
+               std::to_string(sampling.anisotropy);
+    }
+}
+
+TextureHandle ResourceCache::loadTexture(const std::string &path, const TextureSampling &sampling)
+{
+    return s_Textures.acquire(textureKey(path, sampling), [&]() { return TextureLoader::load(path, sampling); });
+}
+
+ShaderHandle ResourceCache::loadShader(const std::string &path)
+{
+    return s_Shaders.acquire(canonicalPath(path), [&]() { return new ShaderVariants(path); });
+}
+
+Texture *ResourceCache::get(TextureHandle handle)
+{
+    auto *slot = s_Textures.find(handle);
+    return slot ? slot->object : nullptr;
+}
+
+ShaderVariants *ResourceCache::get(ShaderHandle handle)
+{
+    auto *slot = s_Shaders.find(handle);
+    return slot ? slot->object : nullptr;
+}
+
+Texture **ResourceCache::getSlot(TextureHandle handle)
+{
+    auto *slot = s_Textures.find(handle);
+    return slot ? &slot->object : nullptr;
+}
+
+void ResourceCache::retain(TextureHandle handle)
+{
+    s_Textures.retain(handle);
+}
+
+void ResourceCache::retain(ShaderHandle handle)
+{
+    s_Shaders.retain(handle);
+}
+
+void ResourceCache::release(TextureHandle handle)
+{
+    s_Textures.release(handle);
+}
+
+void ResourceCache::release(ShaderHandle handle)
+{
+    s_Shaders.release(handle);
+}
+
+void ResourceCache::update()
+{
+    s_Frame++;
+    s_Textures.collect();
+    s_Shaders.collect();
+}
+
+void ResourceCache::clear()
+{
+    s_Textures.clear("texture");
+    s_Shaders.clear("shader");
+}
+
+const ResourceCacheStats &ResourceCache::getStats()
+{
+    s_Stats.textures = s_Textures.alive();
+    s_Stats.shaders = s_Shaders.alive();
+    s_Stats.releasing = (unsigned int)(s_Textures.released.size() + s_Shaders.released.size());
+    return s_Stats;
+}
+
+std::string ResourceCache::canonicalPath(const std::string &path)
+{
+    std::error_code error;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+    if (error)
+        canonical = std::filesystem::absolute(path, error).lexically_normal();
+    return canonical.generic_string();
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include "Texture.hpp"
+
+class ShaderVariants;
+
+// A slot in one of the cache's tables and the generation it was handed
+// out at; once the slot is reused the old handle resolves to null.
+// Generation 0 is never live, so a default handle is the null one.
+template <typename T>
+struct ResourceHandle
+{
+    uint32_t index = 0;
+    uint32_t generation = 0;
+
+    bool operator==(const ResourceHandle &other) const
+    {
+        return index == other.index && generation == other.generation;
+    }
+    bool operator!=(const ResourceHandle &other) const { return !(*this == other); }
+    explicit operator bool() const { return generation != 0; }
+};
+
+using TextureHandle = ResourceHandle<Texture>;
+using ShaderHandle = ResourceHandle<ShaderVariants>;
+
+struct ResourceCacheStats
+{
+    unsigned int textures = 0;  // alive, referenced or not
+    unsigned int shaders = 0;   // ShaderVariants files, alive
+    unsigned int loads = 0;     // went to the file, total
+    unsigned int shared = 0;    // handed an existing one, total
+    unsigned int releasing = 0; // unreferenced, destroyed in a few frames
+};
+
+// Owns the textures and shader files the engine draws with, one object
+// per file and load parameters: asking for the same path again (however
+// it is spelled, see canonicalPath) with the same TextureSampling hands
+// back the existing texture with one more reference, instead of a second
+// copy in GPU memory.
+//
+// Handles index the tables directly; get() is an array lookup and a
+// generation compare. Objects stay where they are in memory for their
+// whole life, so a slot (getSlot) can go to AssetWatcher, which replaces
+// the texture in it on reload and every handle then sees the new one.
+//
+// The last release() doesn't destroy: that happens in update() a few
+// frame boundaries later, after anything queued with the object has gone
+// out, and a load of the same thing meanwhile takes it back.
+//
+// Main thread only.
+class ResourceCache
+{
+public:
+    ResourceCache() = delete;
+    ~ResourceCache() = delete;
+
+    // each one holds a reference, to be given back with release()
+    static TextureHandle loadTexture(const std::string &path, const TextureSampling &sampling = TextureSampling());
+    static ShaderHandle loadShader(const std::string &path);
+
+    // null for a stale or null handle
+    static Texture *get(TextureHandle handle);
+    static ShaderVariants *get(ShaderHandle handle);
+    // what AssetWatcher::watchTexture swaps. The pointer stays valid, but
+    // the texture in it is null once destroyed (the last release() plus a
+    // few frames, or clear()), and a later load may reuse the slot: watch
+    // only while holding a reference.
+    static Texture **getSlot(TextureHandle handle);
+
+    static void retain(TextureHandle handle);
+    static void retain(ShaderHandle handle);
+    static void release(TextureHandle handle);
+    static void release(ShaderHandle handle);
+
+    // main thread, at the frame boundary: destroys what was released long
+    // enough ago
+    static void update();
+    // destroys everything, referenced or not (which is logged); before
+    // TextureLoader::shutdown
+    static void clear();
+
+    static const ResourceCacheStats &getStats();
+
+    // the key files are told apart by: the absolute, lexically normal
+    // path, with symlinks resolved as far as the file exists
+    static std::string canonicalPath(const std::string &path);
+};
@@ -1,30 +1,193 @@
 #pragma once
 #include <string>
-#include <unordered_map>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <glad/glad.h>
 #include"vendor/glm/glm.hpp"
 
+// A uniform (or uniform block) name, FNV-1a hashed. As a constexpr the
+// hash is done at compile time and setUniform* never touches a string:
+//   static constexpr UniformHandle u_Model("u_Model");
+//   shader->setUniformMat4f(u_Model, model);
+struct UniformHandle
+{
+    uint32_t hash;
+    const char *name; // for warnings only; must outlive the call
+
+    constexpr explicit UniformHandle(const char *name) : hash(fnv1a(name)), name(name) {}
+
+    static constexpr uint32_t fnv1a(const char *s)
+    {
+        uint32_t h = 2166136261u;
+        while (*s)
+            h = (h ^ (unsigned char)*s++) * 16777619u;
+        return h;
+    }
+};
+
+// the names Mesh.shader uses
+namespace Uniforms
+{
+    constexpr UniformHandle Model("u_Model");
+    constexpr UniformHandle Color("u_Color");
+    constexpr UniformHandle Texture("u_Texture");
+    constexpr UniformHandle FrameData("FrameData");
+    constexpr UniformHandle TextureHandles("TextureHandles");
+}
+
+// "#shader vertex|fragment|geometry|compute" sections of a .shader file
+enum ShaderStage : unsigned int
+{
+    StageVertex = 1u << 0,
+    StageFragment = 1u << 1,
+    StageGeometry = 1u << 2,
+    StageCompute = 1u << 3, // on its own only
+    StageAll = 0xFu
+};
+constexpr int ShaderStageCount = 4;
+
+// One GL program, or a program pipeline of several. To the renderers
+// both are "a Shader": Bind(), isReady(), setUniform*.
 class Shader
 {
+    friend class ShaderCompiler;
+
 private:
     unsigned int m_renderedId;
     std::string m_filePath;
-    mutable std::unordered_map<std::string, int> m_uniformLoactionCache;
+    // "#define NAME 1" lines put after #version in every stage
+    std::string m_Defines;
+    // the sections built (those of them the file has)
+    unsigned int m_Stages = StageAll;
+    // linked with GL_PROGRAM_SEPARABLE, for use in a pipeline
+    bool m_Separable = false;
+    // pipeline: the stage programs, read through their slots on Bind()
+    // so hot reload can replace them; empty for plain programs
+    std::vector<Shader *const *> m_PipelineStages;
+    mutable std::vector<unsigned int> m_AttachedPrograms;
+    // m_filePath and everything it #includes
+    std::vector<std::string> m_Files;
+
+    // the active uniforms outside blocks, filled once the program is
+    // linked (or from the sources when headless)
+    struct UniformSlot
+    {
+        uint32_t hash;
+        int location;
+        bool hasValue;
+        // last value uploaded, so unchanged uniforms aren't re-sent
+        std::array<unsigned char, 64> value;
+    };
+    std::vector<UniformSlot> m_Uniforms;
+    // open addressing over the hashes, a power of two at least twice
+    // m_Uniforms' size: index into m_Uniforms, -1 for empty
+    std::vector<int> m_UniformLookup;
+    struct BlockSlot
+    {
+        uint32_t hash;
+        unsigned int index;
+    };
+    std::vector<BlockSlot> m_Blocks;
+    // set but not in the program; warned about once
+    std::vector<uint32_t> m_MissingUniforms;
+
+    // Compiling -> Linked (compile thread done) -> Ready (main thread set
+    // it up), or Failed. See ShaderCompiler for who does the compiling.
+    enum class CompileState : int
+    {
+        Compiling,
+        Linked,
+        Ready,
+        Failed
+    };
+    std::atomic<int> m_State{(int)CompileState::Compiling};
+    // the program, m_renderedId only once it is ready
+    std::atomic<unsigned int> m_Program{0};
+    // what building the program takes, owned by whichever thread compiles
+    // until Linked / Failed. ShaderCompiler's worker takes it along, so a
+    // Shader deleted mid-compile needn't wait for the worker.
+    struct ProgramBuild
+    {
+        std::string slot; // cacheSlot(), for the cache and the log
+        bool separable = false;
+        // one per ShaderStage bit, empty if the program doesn't have it
+        std::string sources[ShaderStageCount];
+        unsigned int pendingShaders[ShaderStageCount] = {};
+        uint64_t cacheKey = 0;
+        bool fromCache = false;
+    };
+    ProgramBuild m_Build;
 
 public:
-    Shader(const std::string &filepath);
+    // filepath: "#shader <stage>" sections, with #include "file" resolved
+    // relative to the including file. stages picks which sections to
+    // build; separable makes it a stage program for the constructor below
+    // (needs GLExtensions::ARB_separate_shader_objects).
+    Shader(const std::string &filepath, const std::string &defines = "", unsigned int stages = StageAll,
+           bool separable = false);
+    // A program pipeline over separable stage programs, so N vertex and M
+    // fragment programs combine without N x M links. Doesn't own them;
+    // each slot must outlive the pipeline and is re-read on Bind(), so a
+    // stage that was swapped (hot reload) is picked up.
+    explicit Shader(const std::vector<Shader *const *> &stages);
     ~Shader();
 
     void Bind()const;
     void UnBind();
+    // the program, or the pipeline
+    unsigned int GetRendererID() const { return m_renderedId; }
+    bool isPipeline() const { return !m_PipelineStages.empty(); }
+    // false while the program is still compiling (never blocks); the
+    // renderers skip draws with it and setUniform* does nothing, so set
+    // uniforms every frame rather than once after creation
+    bool isReady() const;
+    bool hasFailed() const;
     // SetUniform4f → color
-    void setUniform1i(const std::string &name, int value);
+    void setUniform1i(UniformHandle uniform, int value);
     // SetUniform1f → opacity
-    void setUniform1f(const std::string &name, float value);
+    void setUniform1f(UniformHandle uniform, float value);
 
     // current used→
-    void setUniform4f(const std::string &name, float v0, float v1, float v2, float v3);
-    void setUniformMat4f(const std::string &name, const glm::mat4& matrix);
+    void setUniform4f(UniformHandle uniform, float v0, float v1, float v2, float v3);
+    void setUniformMat4f(UniformHandle uniform, const glm::mat4& matrix);
+    // by name: the same table, but the hash is done per call
+    void setUniform1i(const std::string &name, int value) { setUniform1i(UniformHandle(name.c_str()), value); }
+    void setUniform1f(const std::string &name, float value) { setUniform1f(UniformHandle(name.c_str()), value); }
+    void setUniform4f(const std::string &name, float v0, float v1, float v2, float v3)
+    {
+        setUniform4f(UniformHandle(name.c_str()), v0, v1, v2, v3);
+    }
+    void setUniformMat4f(const std::string &name, const glm::mat4& matrix)
+    {
+        setUniformMat4f(UniformHandle(name.c_str()), matrix);
+    }
+    // points a named std140 block at a binding point; no-op if the
+    // program doesn't use the block
+    void bindUniformBlock(UniformHandle block, unsigned int binding);
+    // last value set through setUniform*; false if it never was. Lets CPU
+    // backends see what the program would.
+    bool getUniform(UniformHandle uniform, void *out, size_t size) const;
+    bool getUniform(const std::string &name, void *out, size_t size) const
+    {
+        return getUniform(UniformHandle(name.c_str()), out, size);
+    }
+    unsigned int getUniformCount() const { return (unsigned int)m_Uniforms.size(); }
+    const std::string &getDefines() const { return m_Defines; }
+    unsigned int getStages() const { return m_Stages; }
+    bool isSeparable() const { return m_Separable; }
+
+    // compute programs: binds and runs `x * y * z` work groups; a no-op
+    // until ready (GLExtensions::ARB_compute_shader)
+    void Dispatch(unsigned int x, unsigned int y = 1, unsigned int z = 1) const;
+    const std::vector<std::string> &getFiles() const { return m_Files; }
+
+    // the file with every #include "..." pasted in, each file once per
+    // "#shader" section (which also ends cycles); `files` gets every file
+    // read, filepath first.
+    // False if a file can't be opened.
+    static bool expandIncludes(const std::string &filepath, std::string &text, std::vector<std::string> &files);
 
 
 private:
@@ -32,10 +195,36 @@ private:
     {
         std::string vertexSource;
         std::string fragmentSource;
+        std::string geometrySource;
+        std::string computeSource;
     };
 
     shaderProgrammingSources parseShader(const std::string &filepath);
-    unsigned int compileShader(unsigned int type, const std::string &source);
-    unsigned int createShader(const std::string &vertexShader, const std::string &fragmentshader);
-    int getUniformLocation(const std::string &name);
+    // the ShaderCache slot: the path, plus the defines for variants
+    std::string cacheSlot() const;
+    static unsigned int compileShader(unsigned int type, const std::string &source);
+    static bool checkCompile(unsigned int id, unsigned int type, const std::string &slot);
+    // issues compile + link (or loads the cached binary) without waiting
+    static unsigned int beginProgram(ProgramBuild &build);
+    // reports, validates and caches; only once the driver is done
+    static bool endProgram(ProgramBuild &build, unsigned int program);
+    void compileNow();
+    bool pollCompile(int state);
+    // pipeline: all stages ready -> create and fill the pipeline
+    bool pollPipeline();
+    void attachStages() const;
+    // the stage programs that have the uniform, or a warning
+    template <typename Set>
+    void setOnStages(UniformHandle uniform, Set set);
+
+    // the uniform table; reflectUniforms() asks the linked program,
+    // parseUniforms() reads the declarations when there is none
+    void reflectUniforms();
+    void parseUniforms(const shaderProgrammingSources &source);
+    void addUniform(std::string name, int location);
+    void buildUniformLookup();
+    int lookupUniform(uint32_t hash) const;
+    UniformSlot *findUniform(UniformHandle uniform);
+    // stores the value; false if it is unchanged or not in the program
+    bool uniformChanged(UniformSlot *slot, const void *data, size_t size);
 };
@@ -0,0 +1,151 @@
+#define GL_SUBSYSTEM GLSubsystemShaders
+#include "ShaderCache.hpp"
+#include "GLExtensions.hpp"
+#include "Renderer.hpp"
+#include "Console.hpp"
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <cstdio>
+
+namespace
+{
+    std::string s_Directory = "cache/shaders";
+    bool s_Enabled = true;
+
+    const char Magic[4] = {'S', 'P', 'B', '1'};
+
+    struct FileHeader
+    {
+        char magic[4];
+        uint32_t format; // binaryFormat from glGetProgramBinary
+        uint64_t key;
+        uint64_t length;
+    };
+
+    std::string slotPath(const std::string &slot)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin",
+                      (unsigned long long)ShaderCache::hash(slot.data(), slot.size()));
+        return s_Directory + "/" + name;
+    }
+
+    std::string glString(GLenum name)
+    {
+        const GLubyte *value = glGetString(name);
+        return value ? (const char *)value : "";
+    }
+}
+
+void ShaderCache::setDirectory(const std::string &directory)
+{
+    s_Directory = directory;
+}
+
+void ShaderCache::setEnabled(bool enabled)
+{
+    s_Enabled = enabled;
+}
+
+bool ShaderCache::available()
+{
+    return s_Enabled && GLExtensions::ARB_get_program_binary;
+}
+
+uint64_t ShaderCache::hash(const void *data, size_t size, uint64_t seed)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    uint64_t h = seed;
+    for (size_t i = 0; i < size; ++i)
+    {
+        h ^= bytes[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+uint64_t ShaderCache::makeKey(const std::string &sources)
+{
+    // the driver strings don't change while we run
+    static const std::string driver =
+        glString(GL_VENDOR) + '\n' + glString(GL_RENDERER) + '\n' + glString(GL_VERSION);
+
+    // the terminating null keeps "ab"+"c" and "a"+"bc" apart
+    uint64_t h = hash(sources.c_str(), sources.size() + 1);
+    return hash(driver.c_str(), driver.size() + 1, h);
+}
+
+bool ShaderCache::load(unsigned int program, const std::string &slot, uint64_t key)
+{
+    if (!available())
+        return false;
+
+    std::string path = slotPath(slot);
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    FileHeader header;
+    if (!file.read((char *)&header, sizeof(header)) ||
+        std::char_traits<char>::compare(header.magic, Magic, 4) != 0 || header.key != key)
+        return false; // stale, the next store replaces it
+
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), (std::streamsize)binary.size()))
+        return false;
+    file.close();
+
+    GLCall(GLExtensions::ProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size()));
+    int linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (linked == GL_FALSE)
+    {
+        // a driver may reject its own old binaries; rebuild from source
+        Console::LOGN("[ShaderCache] driver rejected " + path + ", recompiling", Color::YELLOW);
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        return false;
+    }
+    return true;
+}
+
+void ShaderCache::store(unsigned int program, const std::string &slot, uint64_t key)
+{
+    if (!available())
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary((size_t)length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    GLCall(GLExtensions::GetProgramBinary(program, length, &written, &format, binary.data()));
+    if (written <= 0)
+        return;
+
+    std::error_code error;
+    std::filesystem::create_directories(s_Directory, error);
+
+    // written next to the slot and renamed over it, so a crash mid-write
+    // can't leave a truncated binary behind
+    std::string path = slotPath(slot);
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            Console::LOGN("[ShaderCache] can't write " + temporary, Color::YELLOW);
+            return;
+        }
+        FileHeader header = {{Magic[0], Magic[1], Magic[2], Magic[3]}, format, key, (uint64_t)written};
+        file.write((const char *)&header, sizeof(header));
+        file.write(binary.data(), written);
+        if (!file)
+            return;
+    }
+    std::filesystem::rename(temporary, path, error);
+}
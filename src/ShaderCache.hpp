@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+// On-disk cache of linked programs (ARB_get_program_binary, core in 4.1).
+//
+// One file per slot (the shader's path), holding the key it was built
+// from: a hash of the parsed sources plus GL_VENDOR, GL_RENDERER and
+// GL_VERSION. A driver update or an edited shader changes the key, the
+// lookup misses and the next store overwrites the slot, so stale
+// binaries never pile up. A binary the driver refuses is deleted.
+class ShaderCache
+{
+public:
+    ShaderCache() = delete;
+    ~ShaderCache() = delete;
+
+    // where the binaries go, created on first store; default "cache/shaders"
+    static void setDirectory(const std::string &directory);
+    static void setEnabled(bool enabled);
+    // GLExtensions::ARB_get_program_binary and not disabled
+    static bool available();
+
+    // sources: every stage, as compiled
+    static uint64_t makeKey(const std::string &sources);
+
+    // loads the binary into `program`; false on a miss or if the driver
+    // no longer accepts it (the program is then still unlinked)
+    static bool load(unsigned int program, const std::string &slot, uint64_t key);
+    // `program` must be linked, with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+    static void store(unsigned int program, const std::string &slot, uint64_t key);
+
+    // FNV-1a, also used for the slot file names
+    static uint64_t hash(const void *data, size_t size, uint64_t seed = 14695981039346656037ull);
+};
@@ -0,0 +1,204 @@
+#define GL_SUBSYSTEM GLSubsystemShaders
+#include "ShaderCompiler.hpp"
+#include "Shader.hpp"
+#include "Renderer.hpp"
+#include "GLState.hpp"
+#include "GLExtensions.hpp"
+#include "Console.hpp"
+#include <GLFW/glfw3.h>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    ShaderCompiler::Mode s_Mode = ShaderCompiler::Mode::Sync;
+
+    // Worker mode
+    GLFWwindow *s_Context = nullptr;
+    std::thread s_Thread;
+    std::mutex s_Mutex;
+    std::condition_variable s_Wake;
+    std::deque<Shader *> s_Queue;
+    // what the worker is compiling; reset to null if the Shader is deleted
+    // meanwhile, and the worker then throws the program away
+    const Shader *s_Current = nullptr;
+    bool s_Quit = false;
+
+    bool s_WarmUp = true;
+    const int WarmUpSize = 4;
+}
+
+void ShaderCompiler::init(GLFWwindow *mainWindow)
+{
+    if (GLState::headless() || s_Mode != Mode::Sync)
+        return;
+
+    if (GLExtensions::KHR_parallel_shader_compile)
+    {
+        // the driver's own choice of thread count
+        GLCall(GLExtensions::MaxShaderCompilerThreads(0xFFFFFFFFu));
+        s_Mode = Mode::Parallel;
+        Console::LOGN("ShaderCompiler: KHR_parallel_shader_compile", Color::GREEN);
+        return;
+    }
+
+    // same hints as the main window (they stick), just never shown
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    s_Context = glfwCreateWindow(1, 1, "shader compiler", nullptr, mainWindow);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (!s_Context)
+    {
+        Console::LOGN("ShaderCompiler: no shared context, compiling on the main thread", Color::YELLOW);
+        return;
+    }
+
+    s_Quit = false;
+    s_Mode = Mode::Worker;
+    s_Thread = std::thread(workerLoop);
+    Console::LOGN("ShaderCompiler: worker thread with a shared context", Color::GREEN);
+}
+
+void ShaderCompiler::shutdown()
+{
+    if (s_Mode == Mode::Worker)
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            s_Quit = true;
+            s_Queue.clear();
+        }
+        s_Wake.notify_all();
+        s_Thread.join();
+        glfwDestroyWindow(s_Context);
+        s_Context = nullptr;
+    }
+    s_Mode = Mode::Sync;
+}
+
+ShaderCompiler::Mode ShaderCompiler::getMode()
+{
+    return s_Mode;
+}
+
+void ShaderCompiler::enqueue(Shader *shader)
+{
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        s_Queue.push_back(shader);
+    }
+    s_Wake.notify_one();
+}
+
+void ShaderCompiler::cancel(const Shader *shader)
+{
+    if (s_Mode != Mode::Worker)
+        return;
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    s_Queue.erase(std::remove(s_Queue.begin(), s_Queue.end(), shader), s_Queue.end());
+    if (s_Current == shader)
+        s_Current = nullptr;
+}
+
+void ShaderCompiler::workerLoop()
+{
+    glfwMakeContextCurrent(s_Context);
+    for (;;)
+    {
+        Shader *shader;
+        Shader::ProgramBuild build;
+        {
+            std::unique_lock<std::mutex> lock(s_Mutex);
+            s_Wake.wait(lock, [] { return s_Quit || !s_Queue.empty(); });
+            if (s_Quit)
+                break;
+            shader = s_Queue.front();
+            s_Queue.pop_front();
+            s_Current = shader;
+            // the Shader may go while this compiles (cancel()); nothing
+            // below touches it until the lock is held again
+            build = std::move(shader->m_Build);
+        }
+
+        unsigned int program = Shader::beginProgram(build);
+        bool linked = Shader::endProgram(build, program);
+        // the main context may only use the program once it is complete
+        glFinish();
+
+        bool abandoned;
+        {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            abandoned = s_Current != shader;
+            if (!abandoned)
+            {
+                shader->m_Program = program;
+                shader->m_State.store((int)(linked ? Shader::CompileState::Linked : Shader::CompileState::Failed),
+                                      std::memory_order_release);
+            }
+            s_Current = nullptr;
+        }
+        if (abandoned)
+            glDeleteProgram(program);
+    }
+    glfwMakeContextCurrent(nullptr);
+}
+
+void ShaderCompiler::setWarmUpEnabled(bool enabled)
+{
+    s_WarmUp = enabled;
+}
+
+void ShaderCompiler::warmUp(const std::vector<const Shader *> &shaders)
+{
+    if (!s_WarmUp || GLState::headless())
+        return;
+
+    for (const Shader *shader : shaders)
+    {
+        while (!shader->isReady() && !shader->hasFailed())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    GLint viewport[4];
+    GLCall(glGetIntegerv(GL_VIEWPORT, viewport));
+
+    unsigned int target, fbo, vao;
+    GLCall(glGenRenderbuffers(1, &target));
+    GLCall(glBindRenderbuffer(GL_RENDERBUFFER, target));
+    GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WarmUpSize, WarmUpSize));
+    GLCall(glGenFramebuffers(1, &fbo));
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, fbo));
+    GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target));
+    GLCall(glViewport(0, 0, WarmUpSize, WarmUpSize));
+
+    // no attributes enabled: every input reads its default, which is
+    // all a first draw needs to make the driver finish the program
+    GLCall(glGenVertexArrays(1, &vao));
+    GLState::bindVertexArray(vao);
+
+    unsigned int drawn = 0;
+    for (const Shader *shader : shaders)
+    {
+        if (!shader->isReady())
+            continue;
+        shader->Bind();
+        GLCall(glDrawArrays(GL_TRIANGLES, 0, 3));
+        drawn++;
+    }
+    GLCall(glFinish());
+
+    GLState::bindVertexArray(0);
+    GLState::forgetVertexArray(vao);
+    GLCall(glDeleteVertexArrays(1, &vao));
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+    GLCall(glDeleteFramebuffers(1, &fbo));
+    GLCall(glDeleteRenderbuffers(1, &target));
+    GLCall(glViewport(viewport[0], viewport[1], viewport[2], viewport[3]));
+
+    Console::LOGN("ShaderCompiler: warmed up " + std::to_string(drawn) + " of " +
+                      std::to_string(shaders.size()) + " programs",
+                  Color::GREEN);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+
+struct GLFWwindow;
+class Shader;
+
+// Decides where Shader programs get compiled, so creating one never
+// waits for the driver:
+//   Sync      before init() and when headless; compiled in the constructor
+//   Parallel  KHR_parallel_shader_compile: the driver compiles on its own
+//             threads, Shader polls GL_COMPLETION_STATUS_KHR
+//   Worker    otherwise: one thread with a hidden window whose context
+//             shares objects with the main one compiles queued shaders
+// Either way Shader::isReady() stays false until the program can be used,
+// and the renderers skip draws with a program that isn't ready.
+class ShaderCompiler
+{
+public:
+    enum class Mode
+    {
+        Sync,
+        Parallel,
+        Worker
+    };
+
+    ShaderCompiler() = delete;
+    ~ShaderCompiler() = delete;
+
+    // main thread, with `mainWindow`'s context current and GLExtensions loaded
+    static void init(GLFWwindow *mainWindow);
+    // after every Shader is gone, before the main window is destroyed
+    static void shutdown();
+    static Mode getMode();
+
+    // For loading screens, not frames: waits until every shader is ready
+    // (or failed), then draws each once into a small offscreen target.
+    // Drivers that only finish compiling on the first draw do it here.
+    static void warmUp(const std::vector<const Shader *> &shaders);
+    // on by default; off makes warmUp() a no-op
+    static void setWarmUpEnabled(bool enabled);
+
+private:
+    friend class Shader;
+    static void enqueue(Shader *shader);
+    // drops a queued shader; if the worker has it right now, the program
+    // is deleted once done instead of handed over. Never waits.
+    static void cancel(const Shader *shader);
+    static void workerLoop();
+};
@@ -0,0 +1,90 @@
+#include "ShaderVariants.hpp"
+#include "Shader.hpp"
+#include "AssetWatcher.hpp"
+#include "GLExtensions.hpp"
+#include "GLState.hpp"
+#include "Console.hpp"
+
+namespace
+{
+    const char *FeatureNames[ShaderFeatureCount] = {"INSTANCED", "TEXTURED", "ALPHA_TEST", "ATLAS", "BINDLESS"};
+}
+
+ShaderVariants::ShaderVariants(const std::string &filepath)
+    : m_FilePath(filepath), m_Separable(GLExtensions::ARB_separate_shader_objects && !GLState::headless())
+{
+}
+
+ShaderVariants::~ShaderVariants()
+{
+    // pipelines first, they point into the stage tables
+    for (Shader *shader : m_Variants)
+        delete shader;
+    for (Shader *shader : m_VertexStages)
+        delete shader;
+    for (Shader *shader : m_FragmentStages)
+        delete shader;
+}
+
+Shader *ShaderVariants::get(uint32_t features)
+{
+    if (features >= VariantCount)
+    {
+        Console::LOGN("ShaderVariants: unknown feature bits in " + std::to_string(features), Color::RED);
+        features &= VariantCount - 1;
+    }
+
+    Shader *&variant = m_Variants[features];
+    if (variant)
+        return variant;
+
+    if (m_Separable)
+    {
+        Shader **vertex = getStage(m_VertexStages, features & ShaderVertexFeatures, StageVertex);
+        Shader **fragment = getStage(m_FragmentStages, features & ShaderFragmentFeatures, StageFragment);
+        variant = new Shader(std::vector<Shader *const *>{vertex, fragment});
+        return variant;
+    }
+
+    variant = new Shader(m_FilePath, defines(features));
+    if (m_Watcher)
+        m_Watcher->watchShader(m_FilePath, &variant, variant->getDefines());
+    return variant;
+}
+
+Shader **ShaderVariants::getStage(Shader **table, uint32_t features, unsigned int stage)
+{
+    Shader *&program = table[features];
+    if (!program)
+    {
+        program = new Shader(m_FilePath, defines(features), stage, true);
+        if (m_Watcher)
+            m_Watcher->watchShader(m_FilePath, &program, program->getDefines());
+    }
+    return &program;
+}
+
+void ShaderVariants::watch(AssetWatcher &watcher)
+{
+    m_Watcher = &watcher;
+    // pipelines pick up reloaded stages on their own
+    for (Shader **table : {m_VertexStages, m_FragmentStages, m_Variants})
+    {
+        for (uint32_t i = 0; i < VariantCount; ++i)
+        {
+            if (table[i] && !table[i]->isPipeline())
+                watcher.watchShader(m_FilePath, &table[i], table[i]->getDefines());
+        }
+    }
+}
+
+std::string ShaderVariants::defines(uint32_t features)
+{
+    std::string text;
+    for (uint32_t bit = 0; bit < ShaderFeatureCount; ++bit)
+    {
+        if (features & (1u << bit))
+            text += std::string("#define ") + FeatureNames[bit] + " 1\n";
+    }
+    return text;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+class Shader;
+class AssetWatcher;
+
+// Feature bits; each one is a "#define NAME 1" in the variant's sources.
+enum ShaderFeature : uint32_t
+{
+    ShaderInstanced = 1u << 0, // INSTANCED
+    ShaderTextured = 1u << 1,  // TEXTURED
+    ShaderAlphaTest = 1u << 2, // ALPHA_TEST
+    ShaderAtlas = 1u << 3,     // ATLAS
+    ShaderBindless = 1u << 4,  // BINDLESS
+    ShaderFeatureCount = 5
+};
+
+// the features each stage reads; ATLAS changes both
+constexpr uint32_t ShaderVertexFeatures = ShaderInstanced | ShaderAtlas;
+constexpr uint32_t ShaderFragmentFeatures = ~ShaderInstanced;
+
+// One .shader file written with #ifdef per feature, compiled into a
+// separate program per feature combination, so untaken branches are
+// stripped by the compiler instead of tested per fragment.
+//
+// A variant is only built the first time get() asks for its bitmask (it
+// then compiles like any Shader, see ShaderCompiler) and lives in a flat
+// table indexed by that mask. Ask again every frame rather than keeping
+// the pointer: with watch(), hot reload replaces variants in place.
+//
+// With ARB_separate_shader_objects the stages are built on their own
+// instead: one vertex program per ShaderVertexFeatures combination and
+// one fragment program per ShaderFragmentFeatures one, and a variant is a
+// program pipeline over the two. N + M compiles instead of N * M links,
+// and a new variant of stages already built costs no compile at all.
+class ShaderVariants
+{
+public:
+    explicit ShaderVariants(const std::string &filepath);
+    ~ShaderVariants();
+
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    Shader *get(uint32_t features);
+
+    // hands every variant, built now or later, to `watcher`
+    void watch(AssetWatcher &watcher);
+
+    static std::string defines(uint32_t features);
+
+private:
+    static const uint32_t VariantCount = 1u << ShaderFeatureCount;
+
+    std::string m_FilePath;
+    bool m_Separable = false;
+    // linked programs, or pipelines over the stage tables (by stage features)
+    Shader *m_Variants[VariantCount] = {};
+    Shader *m_VertexStages[VariantCount] = {};
+    Shader *m_FragmentStages[VariantCount] = {};
+    AssetWatcher *m_Watcher = nullptr;
+
+    Shader **getStage(Shader **table, uint32_t features, unsigned int stage);
+};
@@ -0,0 +1,156 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+
+// Minimal float SIMD wrapper: AVX (8 lanes), SSE2 or NEON (4 lanes),
+// scalar otherwise. Only what the CPU-side passes need. The app ships on
+// Apple silicon, so NEON is a first-class path, not a fallback.
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define SIMD_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SIMD_SSE 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SIMD_NEON 1
+#endif
+
+namespace simd
+{
+#if SIMD_AVX
+    const int Width = 8;
+    typedef __m256 f32;
+
+    inline f32 load(const float *p) { return _mm256_loadu_ps(p); }
+    inline void store(float *p, f32 a) { _mm256_storeu_ps(p, a); }
+    inline f32 set1(float v) { return _mm256_set1_ps(v); }
+    inline f32 add(f32 a, f32 b) { return _mm256_add_ps(a, b); }
+    inline f32 sub(f32 a, f32 b) { return _mm256_sub_ps(a, b); }
+    inline f32 mul(f32 a, f32 b) { return _mm256_mul_ps(a, b); }
+    inline f32 madd(f32 a, f32 b, f32 c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+    inline f32 min(f32 a, f32 b) { return _mm256_min_ps(a, b); }
+    inline f32 max(f32 a, f32 b) { return _mm256_max_ps(a, b); }
+    // comparisons return all-ones lanes
+    inline f32 div(f32 a, f32 b) { return _mm256_div_ps(a, b); }
+    inline f32 floor(f32 a) { return _mm256_floor_ps(a); }
+    inline f32 cmpge(f32 a, f32 b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    inline f32 cmpgt(f32 a, f32 b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    inline f32 andMask(f32 a, f32 b) { return _mm256_and_ps(a, b); }
+    // mask lanes take a, the others b
+    inline f32 select(f32 m, f32 a, f32 b) { return _mm256_blendv_ps(b, a, m); }
+    inline int movemask(f32 m) { return _mm256_movemask_ps(m); }
+
+#elif SIMD_SSE
+    const int Width = 4;
+    typedef __m128 f32;
+
+    inline f32 load(const float *p) { return _mm_loadu_ps(p); }
+    inline void store(float *p, f32 a) { _mm_storeu_ps(p, a); }
+    inline f32 set1(float v) { return _mm_set1_ps(v); }
+    inline f32 add(f32 a, f32 b) { return _mm_add_ps(a, b); }
+    inline f32 sub(f32 a, f32 b) { return _mm_sub_ps(a, b); }
+    inline f32 mul(f32 a, f32 b) { return _mm_mul_ps(a, b); }
+    inline f32 madd(f32 a, f32 b, f32 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    inline f32 min(f32 a, f32 b) { return _mm_min_ps(a, b); }
+    inline f32 max(f32 a, f32 b) { return _mm_max_ps(a, b); }
+    inline f32 div(f32 a, f32 b) { return _mm_div_ps(a, b); }
+    // no _mm_floor_ps before SSE4.1: truncate, then step down where that rounded up
+    inline f32 floor(f32 a)
+    {
+        __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+        return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.0f)));
+    }
+    inline f32 cmpge(f32 a, f32 b) { return _mm_cmpge_ps(a, b); }
+    inline f32 cmpgt(f32 a, f32 b) { return _mm_cmpgt_ps(a, b); }
+    inline f32 andMask(f32 a, f32 b) { return _mm_and_ps(a, b); }
+    inline f32 select(f32 m, f32 a, f32 b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+    inline int movemask(f32 m) { return _mm_movemask_ps(m); }
+
+#elif SIMD_NEON
+    const int Width = 4;
+    typedef float32x4_t f32;
+
+    inline f32 load(const float *p) { return vld1q_f32(p); }
+    inline void store(float *p, f32 a) { vst1q_f32(p, a); }
+    inline f32 set1(float v) { return vdupq_n_f32(v); }
+    inline f32 add(f32 a, f32 b) { return vaddq_f32(a, b); }
+    inline f32 sub(f32 a, f32 b) { return vsubq_f32(a, b); }
+    inline f32 mul(f32 a, f32 b) { return vmulq_f32(a, b); }
+    inline f32 madd(f32 a, f32 b, f32 c) { return vmlaq_f32(c, a, b); }
+    inline f32 min(f32 a, f32 b) { return vminq_f32(a, b); }
+    inline f32 max(f32 a, f32 b) { return vmaxq_f32(a, b); }
+    inline f32 div(f32 a, f32 b) { return vdivq_f32(a, b); }
+    inline f32 floor(f32 a) { return vrndmq_f32(a); }
+    inline f32 cmpge(f32 a, f32 b) { return vreinterpretq_f32_u32(vcgeq_f32(a, b)); }
+    inline f32 cmpgt(f32 a, f32 b) { return vreinterpretq_f32_u32(vcgtq_f32(a, b)); }
+    inline f32 andMask(f32 a, f32 b)
+    {
+        return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+    }
+    inline f32 select(f32 m, f32 a, f32 b) { return vbslq_f32(vreinterpretq_u32_f32(m), a, b); }
+    inline int movemask(f32 m)
+    {
+        // lane i's sign bit -> bit i
+        static const int32_t shifts[4] = {0, 1, 2, 3};
+        uint32x4_t bits = vshrq_n_u32(vreinterpretq_u32_f32(m), 31);
+        return (int)vaddvq_u32(vshlq_u32(bits, vld1q_s32(shifts)));
+    }
+
+#else
+    const int Width = 4;
+    struct f32
+    {
+        float v[4];
+    };
+
+    inline f32 load(const float *p) { return {{p[0], p[1], p[2], p[3]}}; }
+    inline void store(float *p, f32 a)
+    {
+        for (int i = 0; i < 4; ++i)
+            p[i] = a.v[i];
+    }
+    inline f32 set1(float v) { return {{v, v, v, v}}; }
+#define SIMD_SCALAR_OP(name, expr)                 \
+    inline f32 name(f32 a, f32 b)                  \
+    {                                              \
+        f32 r;                                     \
+        for (int i = 0; i < 4; ++i)                \
+            r.v[i] = expr;                         \
+        return r;                                  \
+    }
+    SIMD_SCALAR_OP(add, a.v[i] + b.v[i])
+    SIMD_SCALAR_OP(sub, a.v[i] - b.v[i])
+    SIMD_SCALAR_OP(mul, a.v[i] * b.v[i])
+    SIMD_SCALAR_OP(div, a.v[i] / b.v[i])
+    SIMD_SCALAR_OP(min, a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+    SIMD_SCALAR_OP(max, a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+    SIMD_SCALAR_OP(cmpge, a.v[i] >= b.v[i] ? -1.0f : 0.0f)
+    SIMD_SCALAR_OP(cmpgt, a.v[i] > b.v[i] ? -1.0f : 0.0f)
+    SIMD_SCALAR_OP(andMask, (a.v[i] < 0.0f && b.v[i] < 0.0f) ? -1.0f : 0.0f)
+#undef SIMD_SCALAR_OP
+    inline f32 madd(f32 a, f32 b, f32 c) { return add(mul(a, b), c); }
+    inline f32 floor(f32 a)
+    {
+        f32 r;
+        for (int i = 0; i < 4; ++i)
+            r.v[i] = std::floor(a.v[i]);
+        return r;
+    }
+    inline f32 select(f32 m, f32 a, f32 b)
+    {
+        f32 r;
+        for (int i = 0; i < 4; ++i)
+            r.v[i] = m.v[i] < 0.0f ? a.v[i] : b.v[i];
+        return r;
+    }
+    inline int movemask(f32 m)
+    {
+        int bits = 0;
+        for (int i = 0; i < 4; ++i)
+            bits |= (m.v[i] < 0.0f ? 1 : 0) << i;
+        return bits;
+    }
+#endif
+}
@@ -0,0 +1,386 @@
+#include "SoftwareRasterizer.hpp"
+#include "Texture.hpp"
+#include "Simd.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    struct ByteToFloat
+    {
+        float v[256];
+        ByteToFloat()
+        {
+            for (int i = 0; i < 256; ++i)
+                v[i] = (float)i / 255.0f;
+        }
+    };
+    const ByteToFloat s_ByteToFloat;
+
+    // GL_LINEAR with GL_CLAMP_TO_BORDER. Coordinates and weights are done
+    // simd::Width lanes at a time; only the texel fetches are per lane
+    // (no gather below AVX2), and only for lanes that are drawn.
+    void sampleTexture(const unsigned char *texels, int width, int height, int lanes,
+                       simd::f32 u, simd::f32 v, simd::f32 out[4])
+    {
+        using namespace simd;
+
+        // clamped so wild values near the clip planes still convert to int
+        f32 tx = max(min(sub(mul(u, set1((float)width)), set1(0.5f)), set1((float)width + 1.0f)), set1(-2.0f));
+        f32 ty = max(min(sub(mul(v, set1((float)height)), set1(0.5f)), set1((float)height + 1.0f)), set1(-2.0f));
+        f32 fx = floor(tx);
+        f32 fy = floor(ty);
+        f32 wx = sub(tx, fx);
+        f32 wy = sub(ty, fy);
+
+        alignas(32) float ix[Width], iy[Width];
+        store(ix, fx);
+        store(iy, fy);
+
+        // [corner][channel][lane], corners x0y0, x1y0, x0y1, x1y1
+        alignas(32) float texel[4][4][Width];
+        for (int lane = 0; lane < Width; ++lane)
+        {
+            if (!(lanes & (1 << lane)))
+            {
+                for (int corner = 0; corner < 4; ++corner)
+                    for (int ch = 0; ch < 4; ++ch)
+                        texel[corner][ch][lane] = 0.0f;
+                continue;
+            }
+
+            int x = (int)ix[lane];
+            int y = (int)iy[lane];
+            for (int corner = 0; corner < 4; ++corner)
+            {
+                int cx = x + (corner & 1);
+                int cy = y + (corner >> 1);
+                if (cx < 0 || cy < 0 || cx >= width || cy >= height)
+                {
+                    for (int ch = 0; ch < 4; ++ch)
+                        texel[corner][ch][lane] = Texture::BorderColor[ch];
+                    continue;
+                }
+                const unsigned char *p = texels + ((size_t)cy * width + cx) * 4;
+                for (int ch = 0; ch < 4; ++ch)
+                    texel[corner][ch][lane] = s_ByteToFloat.v[p[ch]];
+            }
+        }
+
+        for (int ch = 0; ch < 4; ++ch)
+        {
+            f32 c00 = load(texel[0][ch]);
+            f32 c10 = load(texel[1][ch]);
+            f32 c01 = load(texel[2][ch]);
+            f32 c11 = load(texel[3][ch]);
+            f32 row0 = madd(sub(c10, c00), wx, c00);
+            f32 row1 = madd(sub(c11, c01), wx, c01);
+            out[ch] = madd(sub(row1, row0), wy, row0);
+        }
+    }
+}
+
+SoftwareRasterizer::SoftwareRasterizer(int width, int height, unsigned int threads)
+    : m_Width(width), m_Height(height)
+{
+    m_TilesX = (width + TileSize - 1) / TileSize;
+    m_TilesY = (height + TileSize - 1) / TileSize;
+    m_Stride = m_TilesX * TileSize;
+
+    size_t pixels = (size_t)m_Stride * m_TilesY * TileSize;
+    m_R.assign(pixels, 0.0f);
+    m_G.assign(pixels, 0.0f);
+    m_B.assign(pixels, 0.0f);
+    m_A.assign(pixels, 0.0f);
+    m_Depth.assign(pixels, 1.0f);
+    m_Bins.resize((size_t)m_TilesX * m_TilesY);
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int i = 1; i < threads; ++i)
+        m_Workers.emplace_back(&SoftwareRasterizer::workerLoop, this);
+}
+
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Quit = true;
+    }
+    m_Wake.notify_all();
+    for (std::thread &worker : m_Workers)
+        worker.join();
+}
+
+void SoftwareRasterizer::clear(const glm::vec4 &color)
+{
+    resolve();
+    std::fill(m_R.begin(), m_R.end(), color.r);
+    std::fill(m_G.begin(), m_G.end(), color.g);
+    std::fill(m_B.begin(), m_B.end(), color.b);
+    std::fill(m_A.begin(), m_A.end(), color.a);
+    std::fill(m_Depth.begin(), m_Depth.end(), 1.0f);
+}
+
+void SoftwareRasterizer::addTriangle(const RasterVertex &a, const RasterVertex &b, const RasterVertex &c,
+                                     const RasterState &state)
+{
+    // pixel centers sit at +0.5
+    float minXf = std::min(a.x, std::min(b.x, c.x));
+    float maxXf = std::max(a.x, std::max(b.x, c.x));
+    float minYf = std::min(a.y, std::min(b.y, c.y));
+    float maxYf = std::max(a.y, std::max(b.y, c.y));
+    if (!(minXf < (float)m_Width && maxXf > 0.0f && minYf < (float)m_Height && maxYf > 0.0f))
+        return; // off screen, or NaN
+
+    SetupTriangle t;
+    t.minX = std::max(0, (int)std::ceil(minXf - 0.5f));
+    t.maxX = std::min(m_Width - 1, (int)std::floor(maxXf - 0.5f));
+    t.minY = std::max(0, (int)std::ceil(minYf - 0.5f));
+    t.maxY = std::min(m_Height - 1, (int)std::floor(maxYf - 0.5f));
+    if (t.minX > t.maxX || t.minY > t.maxY)
+        return; // covers no pixel center
+
+    float area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+    if (area == 0.0f)
+        return;
+    float invArea = 1.0f / area;
+
+    // edge i is opposite vertex i and is 1 there; no face culling, the
+    // division by the signed area makes the inside positive either way
+    const RasterVertex *v[3] = {&a, &b, &c};
+    for (int i = 0; i < 3; ++i)
+    {
+        const RasterVertex &p = *v[(i + 1) % 3];
+        const RasterVertex &q = *v[(i + 2) % 3];
+        Plane &e = t.edge[i];
+        e.a = (p.y - q.y) * invArea;
+        e.b = (q.x - p.x) * invArea;
+        e.c = (p.x * q.y - q.x * p.y) * invArea;
+
+        // left edges and top edges (y is up) own the pixels on them
+        bool topLeft = e.a > 0.0f || (e.a == 0.0f && e.b < 0.0f);
+        t.bias[i] = topLeft ? 0.0f : std::numeric_limits<float>::min();
+    }
+
+    auto plane = [&](float va, float vb, float vc)
+    {
+        float values[3] = {va, vb, vc};
+        Plane p = {0.0f, 0.0f, 0.0f};
+        for (int i = 0; i < 3; ++i)
+        {
+            p.a += values[i] * t.edge[i].a;
+            p.b += values[i] * t.edge[i].b;
+            p.c += values[i] * t.edge[i].c;
+        }
+        return p;
+    };
+    t.z = plane(a.z, b.z, c.z);
+    t.invW = plane(a.invW, b.invW, c.invW);
+    t.u = plane(a.u, b.u, c.u);
+    t.v = plane(a.v, b.v, c.v);
+
+    t.color = state.color;
+    t.texels = state.texture ? state.texture->getPixels() : nullptr;
+    t.texWidth = state.texture ? state.texture->getWidth() : 0;
+    t.texHeight = state.texture ? state.texture->getHeight() : 0;
+    t.blend = state.blend;
+    t.depthWrite = state.depthWrite;
+
+    uint32_t index = (uint32_t)m_Triangles.size();
+    m_Triangles.push_back(t);
+    m_Stats.triangles++;
+
+    for (int ty = t.minY / TileSize; ty <= t.maxY / TileSize; ++ty)
+        for (int tx = t.minX / TileSize; tx <= t.maxX / TileSize; ++tx)
+            m_Bins[(size_t)ty * m_TilesX + tx].push_back(index);
+}
+
+void SoftwareRasterizer::resolve()
+{
+    if (m_Triangles.empty())
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+
+    m_NextTile = 0;
+    m_Pixels = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Busy = (unsigned int)m_Workers.size();
+        m_Generation++;
+    }
+    m_Wake.notify_all();
+
+    rasterizeTiles();
+
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Done.wait(lock, [this] { return m_Busy == 0; });
+    }
+
+    m_Stats.pixels += m_Pixels;
+    m_Stats.resolves++;
+    m_Stats.rasterSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (std::vector<uint32_t> &bin : m_Bins)
+        bin.clear();
+    m_Triangles.clear();
+}
+
+void SoftwareRasterizer::workerLoop()
+{
+    unsigned int seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Wake.wait(lock, [&] { return m_Quit || m_Generation != seen; });
+            if (m_Quit)
+                return;
+            seen = m_Generation;
+        }
+
+        rasterizeTiles();
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (--m_Busy == 0)
+                m_Done.notify_one();
+        }
+    }
+}
+
+void SoftwareRasterizer::rasterizeTiles()
+{
+    unsigned int tileCount = (unsigned int)m_Bins.size();
+    for (unsigned int tile = m_NextTile++; tile < tileCount; tile = m_NextTile++)
+        rasterizeTile((int)tile);
+}
+
+void SoftwareRasterizer::rasterizeTile(int tile)
+{
+    using namespace simd;
+
+    const std::vector<uint32_t> &bin = m_Bins[tile];
+    if (bin.empty())
+        return;
+
+    int tileX = (tile % m_TilesX) * TileSize;
+    int tileY = (tile / m_TilesX) * TileSize;
+
+    alignas(32) float laneCenters[Width];
+    for (int i = 0; i < Width; ++i)
+        laneCenters[i] = (float)i + 0.5f;
+    const f32 lanes = load(laneCenters);
+    const f32 one = set1(1.0f);
+
+    uint64_t pixels = 0;
+    for (uint32_t index : bin)
+    {
+        const SetupTriangle &t = m_Triangles[index];
+
+        // Width divides TileSize, so aligning down stays inside the tile
+        int x0 = std::max(t.minX, tileX) & ~(Width - 1);
+        int x1 = std::min(t.maxX, tileX + TileSize - 1);
+        int y0 = std::max(t.minY, tileY);
+        int y1 = std::min(t.maxY, tileY + TileSize - 1);
+
+        f32 e0a = set1(t.edge[0].a), e1a = set1(t.edge[1].a), e2a = set1(t.edge[2].a);
+        f32 bias0 = set1(t.bias[0]), bias1 = set1(t.bias[1]), bias2 = set1(t.bias[2]);
+        f32 za = set1(t.z.a), wa = set1(t.invW.a), ua = set1(t.u.a), va = set1(t.v.a);
+        f32 cr = set1(t.color.r), cg = set1(t.color.g), cb = set1(t.color.b), ca = set1(t.color.a);
+
+        for (int y = y0; y <= y1; ++y)
+        {
+            float fy = (float)y + 0.5f;
+            f32 e0row = set1(t.edge[0].b * fy + t.edge[0].c);
+            f32 e1row = set1(t.edge[1].b * fy + t.edge[1].c);
+            f32 e2row = set1(t.edge[2].b * fy + t.edge[2].c);
+            f32 zrow = set1(t.z.b * fy + t.z.c);
+            f32 wrow = set1(t.invW.b * fy + t.invW.c);
+            f32 urow = set1(t.u.b * fy + t.u.c);
+            f32 vrow = set1(t.v.b * fy + t.v.c);
+
+            size_t row = (size_t)y * m_Stride;
+            float *rowR = &m_R[row], *rowG = &m_G[row], *rowB = &m_B[row], *rowA = &m_A[row];
+            float *rowD = &m_Depth[row];
+
+            for (int x = x0; x <= x1; x += Width)
+            {
+                f32 px = add(set1((float)x), lanes);
+                f32 inside = andMask(cmpge(madd(e0a, px, e0row), bias0),
+                                     andMask(cmpge(madd(e1a, px, e1row), bias1),
+                                             cmpge(madd(e2a, px, e2row), bias2)));
+                if (!movemask(inside))
+                    continue;
+
+                // depth LESS, and clipped at the far plane
+                f32 z = madd(za, px, zrow);
+                f32 depth = load(rowD + x);
+                f32 mask = andMask(inside, andMask(cmpgt(depth, z), cmpge(one, z)));
+                int bits = movemask(mask);
+                if (!bits)
+                    continue;
+
+                f32 w = div(one, madd(wa, px, wrow));
+                f32 u = mul(madd(ua, px, urow), w);
+                f32 v = mul(madd(va, px, vrow), w);
+
+                f32 color[4];
+                if (t.texels)
+                    sampleTexture(t.texels, t.texWidth, t.texHeight, bits, u, v, color);
+                else
+                    color[0] = color[1] = color[2] = color[3] = one;
+                f32 r = mul(color[0], cr), g = mul(color[1], cg), b = mul(color[2], cb), a = mul(color[3], ca);
+
+                f32 dr = load(rowR + x), dg = load(rowG + x), db = load(rowB + x), da = load(rowA + x);
+                if (t.blend)
+                {
+                    f32 inv = sub(one, a);
+                    r = madd(r, a, mul(dr, inv));
+                    g = madd(g, a, mul(dg, inv));
+                    b = madd(b, a, mul(db, inv));
+                    a = madd(a, a, mul(da, inv));
+                }
+                store(rowR + x, select(mask, r, dr));
+                store(rowG + x, select(mask, g, dg));
+                store(rowB + x, select(mask, b, db));
+                store(rowA + x, select(mask, a, da));
+                if (t.depthWrite)
+                    store(rowD + x, select(mask, z, depth));
+
+                pixels += (uint64_t)__builtin_popcount((unsigned int)bits);
+            }
+        }
+    }
+    m_Pixels += pixels;
+}
+
+void SoftwareRasterizer::readPixels(std::vector<unsigned char> &rgba)
+{
+    resolve();
+
+    auto toByte = [](float v)
+    {
+        v = std::min(std::max(v, 0.0f), 1.0f);
+        return (unsigned char)(v * 255.0f + 0.5f);
+    };
+
+    rgba.resize((size_t)m_Width * m_Height * 4);
+    for (int y = 0; y < m_Height; ++y)
+    {
+        // bottom-up framebuffer, top-down image
+        size_t src = (size_t)(m_Height - 1 - y) * m_Stride;
+        unsigned char *dst = &rgba[(size_t)y * m_Width * 4];
+        for (int x = 0; x < m_Width; ++x)
+        {
+            dst[x * 4 + 0] = toByte(m_R[src + x]);
+            dst[x * 4 + 1] = toByte(m_G[src + x]);
+            dst[x * 4 + 2] = toByte(m_B[src + x]);
+            dst[x * 4 + 3] = toByte(m_A[src + x]);
+        }
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include "vendor/glm/glm.hpp"
+
+class Texture;
+
+// A vertex after the perspective divide: window coordinates with the
+// origin bottom left (like GL), depth in [0, 1], and u, v already
+// multiplied by invW for perspective-correct interpolation.
+struct RasterVertex
+{
+    float x, y, z;
+    float invW;
+    float u, v;
+};
+
+// What the fragment stage does for one triangle:
+// texture(u_Texture, uv) * color, then blend / depth.
+struct RasterState
+{
+    const Texture* texture = nullptr; // null samples white
+    glm::vec4 color = glm::vec4(1.0f);
+    bool blend = false;               // SRC_ALPHA, ONE_MINUS_SRC_ALPHA
+    bool depthWrite = true;           // the depth test (LESS) is always on
+};
+
+struct RasterStats
+{
+    uint64_t triangles = 0; // binned, after clipping and culling empty ones
+    uint64_t pixels = 0;    // fragments that passed the depth test
+    uint64_t resolves = 0;
+    double rasterSeconds = 0.0;
+};
+
+// Tile-based rasterizer. addTriangle() sets up edge and attribute planes
+// and bins the triangle into every TileSize x TileSize tile its bounds
+// touch; resolve() then hands tiles to a pool of threads. Each tile walks
+// its bin in submission order, so the output doesn't depend on the
+// thread count. Pixels are shaded simd::Width at a time.
+//
+// The framebuffer is float planes (R, G, B, A, depth), padded to whole
+// tiles, converted to RGBA8 on readPixels().
+class SoftwareRasterizer
+{
+public:
+    static const int TileSize = 64;
+
+    // threads: 0 = one per hardware thread (the caller's thread included)
+    SoftwareRasterizer(int width, int height, unsigned int threads = 0);
+    ~SoftwareRasterizer();
+
+    SoftwareRasterizer(const SoftwareRasterizer&) = delete;
+    SoftwareRasterizer& operator=(const SoftwareRasterizer&) = delete;
+
+    // finishes what is binned, then fills color and depth (1.0)
+    void clear(const glm::vec4& color);
+    void addTriangle(const RasterVertex& a, const RasterVertex& b, const RasterVertex& c,
+                     const RasterState& state);
+    // rasterizes everything binned so far
+    void resolve();
+
+    // RGBA8, top row first (ready for an image file)
+    void readPixels(std::vector<unsigned char>& rgba);
+
+    int getWidth() const { return m_Width; }
+    int getHeight() const { return m_Height; }
+    unsigned int getThreadCount() const { return (unsigned int)m_Workers.size() + 1; }
+    const RasterStats& getStats() const { return m_Stats; }
+    void resetStats() { m_Stats = RasterStats(); }
+
+private:
+    // edge functions are normalized by the area, so inside a triangle
+    // they are its barycentrics; every attribute is a plane a*x + b*y + c
+    struct Plane
+    {
+        float a, b, c;
+    };
+    struct SetupTriangle
+    {
+        Plane edge[3];
+        float bias[3]; // 0 on top-left edges, so shared edges are drawn once
+        Plane z, invW, u, v;
+        int minX, minY, maxX, maxY;
+        glm::vec4 color;
+        const unsigned char* texels;
+        int texWidth, texHeight;
+        bool blend, depthWrite;
+    };
+
+    int m_Width, m_Height;
+    int m_TilesX, m_TilesY;
+    int m_Stride; // padded width
+    std::vector<float> m_R, m_G, m_B, m_A, m_Depth;
+
+    std::vector<SetupTriangle> m_Triangles;
+    std::vector<std::vector<uint32_t>> m_Bins;
+    RasterStats m_Stats;
+
+    // worker pool; resolve() bumps m_Generation and joins in
+    std::vector<std::thread> m_Workers;
+    std::mutex m_Mutex;
+    std::condition_variable m_Wake;
+    std::condition_variable m_Done;
+    unsigned int m_Generation = 0;
+    unsigned int m_Busy = 0;
+    bool m_Quit = false;
+    std::atomic<unsigned int> m_NextTile{0};
+    std::atomic<uint64_t> m_Pixels{0};
+
+    void workerLoop();
+    void rasterizeTiles();
+    void rasterizeTile(int tile);
+};
@@ -0,0 +1,233 @@
+#include "SoftwareRenderer.hpp"
+#include "Texture.hpp"
+#include "UniformBuffer.hpp"
+#include "ImageWriter.hpp"
+#include "Console.hpp"
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+    struct ClipVertex
+    {
+        glm::vec4 pos;
+        float u, v;
+    };
+
+    ClipVertex lerp(const ClipVertex &a, const ClipVertex &b, float t)
+    {
+        return {a.pos + (b.pos - a.pos) * t, a.u + (b.u - a.u) * t, a.v + (b.v - a.v) * t};
+    }
+
+    template <typename T>
+    T fetch(const VertexArray::AttributeSource &src, unsigned int element)
+    {
+        T value;
+        std::memcpy(&value, src.data + (size_t)element * src.stride, sizeof(T));
+        return value;
+    }
+}
+
+SoftwareRenderer::SoftwareRenderer(int width, int height, unsigned int threads)
+{
+    m_Raster = new SoftwareRasterizer(width, height, threads);
+}
+
+SoftwareRenderer::~SoftwareRenderer()
+{
+    delete m_Raster;
+}
+
+void SoftwareRenderer::Draw(const VertexArray &va, IndexBuffer &ib, const Shader &shader) const
+{
+    DrawInstanced(va, ib, shader, 1);
+}
+
+void SoftwareRenderer::DrawInstanced(const VertexArray &va, IndexBuffer &ib, const Shader &shader, unsigned int instanceCount) const
+{
+    int slot = 0;
+    shader.getUniform(Uniforms::Texture, &slot, sizeof(slot));
+    drawRange(va, ib, shader, Texture::boundAt(slot), {0, ib.getCount(), 0, 0, instanceCount}, true, true);
+}
+
+void SoftwareRenderer::DrawMesh(const VertexArray &va, IndexBuffer &ib, const Shader &shader, const MeshRange &mesh) const
+{
+    int slot = 0;
+    shader.getUniform(Uniforms::Texture, &slot, sizeof(slot));
+    drawRange(va, ib, shader, Texture::boundAt(slot), {mesh.firstIndex, mesh.indexCount, mesh.baseVertex, 0, 1},
+              true, true);
+}
+
+void SoftwareRenderer::Clear(const glm::vec4 &color) const
+{
+    m_Raster->clear(color);
+}
+
+void SoftwareRenderer::Flush()
+{
+    m_QueueStats = RenderQueueStats();
+    m_QueueStats.packets = (unsigned int)m_Packets.size();
+
+    if (!m_Packets.empty())
+    {
+        // the sort matters here too: opaque front to back, alpha last
+        sortPackets();
+        for (const SortEntry &entry : m_SortEntries)
+        {
+            const DrawPacket &p = m_Packets[entry.packet];
+            bool blend = p.blend == BlendMode::Alpha;
+
+            if (p.commandCount == 0)
+            {
+                unsigned int count = p.indexCount ? p.indexCount : p.ib->getCount();
+                drawRange(*p.va, *p.ib, *p.shader, p.texture,
+                          {p.firstIndex, count, p.baseVertex, p.firstInstance, p.instanceCount}, blend, !blend);
+            }
+            for (unsigned int i = 0; i < p.commandCount; ++i)
+            {
+                const DrawElementsIndirectCommand &c = p.commands[i];
+                drawRange(*p.va, *p.ib, *p.shader, p.texture,
+                          {c.firstIndex, c.count, c.baseVertex, c.baseInstance, c.instanceCount}, blend, !blend);
+            }
+            m_QueueStats.drawCalls++;
+        }
+        m_Packets.clear();
+        m_SortEntries.clear();
+    }
+
+    m_Raster->resolve();
+}
+
+// the vertex stage, then near-plane clipping, the divide and the viewport
+void SoftwareRenderer::drawRange(const VertexArray &va, const IndexBuffer &ib, const Shader &shader,
+                                 const Texture *texture, const Range &range, bool blend, bool depthWrite) const
+{
+    auto start = std::chrono::steady_clock::now();
+
+    const unsigned int *indices = ib.getCpuData();
+    VertexArray::AttributeSource position, texCoord, model, color;
+    if (!indices || !va.getAttribute(0, position))
+    {
+        Console::LOGN("SoftwareRenderer: no CPU-side vertex data (GLState not headless?)", Color::RED);
+        return;
+    }
+    // a VAO can carry instance streams the program doesn't read (the plain
+    // Mesh.shader variant on the mesh VAO), so a uniform that was set wins
+    glm::mat4 uniformModel(1.0f);
+    glm::vec4 uniformColor(1.0f);
+    bool hasTexCoord = va.getAttribute(1, texCoord);
+    bool instanceModel = !shader.getUniform(Uniforms::Model, &uniformModel, sizeof(uniformModel)) &&
+                         va.getAttribute(2, model) && model.divisor;
+    bool instanceColor = !shader.getUniform(Uniforms::Color, &uniformColor, sizeof(uniformColor)) &&
+                         va.getAttribute(6, color) && color.divisor;
+
+    FrameUniforms frame;
+    frame.viewProj = glm::mat4(1.0f);
+    frame.brightness = 1.0f;
+    const UniformBuffer *frameBlock = UniformBuffer::boundAt(FrameBlockBinding);
+    if (frameBlock && frameBlock->getCpuData())
+        std::memcpy(&frame, frameBlock->getCpuData(), sizeof(frame));
+
+    float halfWidth = m_Raster->getWidth() * 0.5f;
+    float halfHeight = m_Raster->getHeight() * 0.5f;
+
+    RasterState state;
+    state.texture = texture;
+    state.blend = blend;
+    state.depthWrite = depthWrite;
+
+    for (unsigned int instance = 0; instance < range.instanceCount; ++instance)
+    {
+        unsigned int element = range.firstInstance + instance;
+        glm::mat4 mvp = frame.viewProj *
+                        (instanceModel ? fetch<glm::mat4>(model, element / model.divisor) : uniformModel);
+        state.color = instanceColor ? fetch<glm::vec4>(color, element / color.divisor) : uniformColor;
+        state.color.r *= frame.brightness;
+        state.color.g *= frame.brightness;
+        state.color.b *= frame.brightness;
+
+        for (unsigned int i = 0; i + 2 < range.indexCount; i += 3)
+        {
+            ClipVertex in[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                unsigned int vertex = (unsigned int)((int)indices[range.firstIndex + i + k] + range.baseVertex);
+                in[k].pos = mvp * glm::vec4(fetch<glm::vec3>(position, vertex), 1.0f);
+                glm::vec2 uv = hasTexCoord ? fetch<glm::vec2>(texCoord, vertex) : glm::vec2(0.0f);
+                in[k].u = uv.x;
+                in[k].v = uv.y;
+            }
+
+            // entirely outside one clip plane
+            bool outside = false;
+            for (int axis = 0; axis < 3 && !outside; ++axis)
+            {
+                outside = (in[0].pos[axis] > in[0].pos.w && in[1].pos[axis] > in[1].pos.w &&
+                           in[2].pos[axis] > in[2].pos.w) ||
+                          (in[0].pos[axis] < -in[0].pos.w && in[1].pos[axis] < -in[1].pos.w &&
+                           in[2].pos[axis] < -in[2].pos.w);
+            }
+            if (outside)
+                continue;
+
+            // near plane (z >= -w) only; the rasterizer clips x / y to the
+            // screen and z to the far plane per pixel
+            ClipVertex poly[4];
+            int count = 0;
+            for (int k = 0; k < 3; ++k)
+            {
+                const ClipVertex &a = in[k];
+                const ClipVertex &b = in[(k + 1) % 3];
+                float da = a.pos.z + a.pos.w;
+                float db = b.pos.z + b.pos.w;
+                if (da >= 0.0f)
+                    poly[count++] = a;
+                if ((da >= 0.0f) != (db >= 0.0f))
+                    poly[count++] = lerp(a, b, da / (da - db));
+            }
+            if (count < 3)
+                continue;
+
+            RasterVertex screen[4];
+            for (int k = 0; k < count; ++k)
+            {
+                float invW = 1.0f / poly[k].pos.w;
+                screen[k].x = (poly[k].pos.x * invW + 1.0f) * halfWidth;
+                screen[k].y = (poly[k].pos.y * invW + 1.0f) * halfHeight;
+                screen[k].z = poly[k].pos.z * invW * 0.5f + 0.5f;
+                screen[k].invW = invW;
+                screen[k].u = poly[k].u * invW;
+                screen[k].v = poly[k].v * invW;
+            }
+            for (int k = 1; k + 1 < count; ++k)
+                m_Raster->addTriangle(screen[0], screen[k], screen[k + 1], state);
+        }
+    }
+
+    m_GeometrySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool SoftwareRenderer::writeImage(const std::string &path) const
+{
+    std::vector<unsigned char> pixels;
+    m_Raster->readPixels(pixels);
+    return ImageWriter::writePNG(path, m_Raster->getWidth(), m_Raster->getHeight(), pixels.data());
+}
+
+void SoftwareRenderer::printSummary() const
+{
+    const RasterStats &s = m_Raster->getStats();
+    double seconds = m_GeometrySeconds + s.rasterSeconds;
+    double mtris = seconds > 0.0 ? s.triangles / seconds / 1e6 : 0.0;
+    double mpix = s.rasterSeconds > 0.0 ? s.pixels / s.rasterSeconds / 1e6 : 0.0;
+
+    Console::LOGN("[SoftwareRenderer] " + std::to_string(m_Raster->getWidth()) + "x" +
+                      std::to_string(m_Raster->getHeight()) + ", " +
+                      std::to_string(m_Raster->getThreadCount()) + " threads, " +
+                      std::to_string(s.resolves) + " resolves",
+                  Color::GREEN);
+    Console::LOGN("  " + std::to_string(s.triangles) + " triangles, " + std::to_string(s.pixels) +
+                  " pixels; vertex " + std::to_string(m_GeometrySeconds * 1000.0) + " ms, raster " +
+                  std::to_string(s.rasterSeconds * 1000.0) + " ms");
+    Console::LOGN("  " + std::to_string(mtris) + " Mtri/s, " + std::to_string(mpix) + " Mpix/s");
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "Renderer.hpp"
+#include "SoftwareRasterizer.hpp"
+#include <string>
+
+// CPU backend: runs what the Mesh.shader variants do (FrameData
+// viewProj * model, texture * color, rgb * brightness) on the vertex
+// and index data the GL wrappers keep when GLState is headless, and
+// hands the triangles to a SoftwareRasterizer. Deterministic, so it
+// doubles as a reference renderer, and needs no graphics hardware.
+//
+// Where a program would get its inputs:
+//   position / texcoord  attributes 0 / 1
+//   model                u_Model if set, else attribute 2 (per instance)
+//   color                u_Color if set, else attribute 6 (per instance)
+//   texture              the packet's, or Texture::boundAt(u_Texture)
+// Immediate draws blend like the GL state App sets up; packets follow
+// their BlendMode like Renderer::Flush.
+class SoftwareRenderer : public Renderer
+{
+public:
+    SoftwareRenderer(int width, int height, unsigned int threads = 0);
+    ~SoftwareRenderer() override;
+
+    void Draw(const VertexArray& va, IndexBuffer& ib, const Shader& shader) const override;
+    void DrawInstanced(const VertexArray& va, IndexBuffer& ib, const Shader& shader, unsigned int instanceCount) const override;
+    void DrawMesh(const VertexArray& va, IndexBuffer& ib, const Shader& shader, const MeshRange& mesh) const override;
+    void Clear(const glm::vec4& color) const override;
+
+    void Flush() override;
+
+    // resolves and writes the color buffer as a PNG
+    bool writeImage(const std::string& path) const;
+    SoftwareRasterizer& getRasterizer() const { return *m_Raster; }
+    // triangles and megapixels per second, vertex stage included
+    void printSummary() const;
+
+private:
+    // pointer, so the const Draw* calls can still draw
+    SoftwareRasterizer* m_Raster = nullptr;
+    mutable double m_GeometrySeconds = 0.0;
+
+    struct Range
+    {
+        unsigned int firstIndex;
+        unsigned int indexCount;
+        int baseVertex;
+        unsigned int firstInstance;
+        unsigned int instanceCount;
+    };
+    void drawRange(const VertexArray& va, const IndexBuffer& ib, const Shader& shader,
+                   const Texture* texture, const Range& range, bool blend, bool depthWrite) const;
+};
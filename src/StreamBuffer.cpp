@@ -0,0 +1,211 @@
+#define GL_SUBSYSTEM GLSubsystemBuffers
+#include "StreamBuffer.hpp"
+#include "Renderer.hpp"
+#include "GLState.hpp"
+#include "GLExtensions.hpp"
+#include <cstring>
+
+StreamBuffer::StreamBuffer(unsigned int target, unsigned int elementSize, unsigned int elementsPerFrame,
+                           Mode mode)
+    : m_Target(target), m_ElementSize(elementSize), m_ElementsPerFrame(elementsPerFrame), m_Mode(mode)
+{
+    if (GLState::headless())
+        m_Mode = Mode::Cpu;
+    if (m_Mode == Mode::Auto)
+        m_Mode = GLExtensions::ARB_buffer_storage ? Mode::Persistent : Mode::Unsynchronized;
+    if (m_Mode == Mode::Persistent && !GLExtensions::ARB_buffer_storage)
+        m_Mode = Mode::Unsynchronized;
+
+    allocate();
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    release();
+}
+
+void StreamBuffer::allocate()
+{
+    GLsizeiptr bytes = (GLsizeiptr)m_ElementSize * m_ElementsPerFrame * Frames;
+
+    m_Region = Frames - 1;
+    m_Cursor = m_RegionEnd = 0;
+
+    if (m_Mode == Mode::Cpu)
+    {
+        m_RendererId = GLState::headlessName();
+        m_Cpu.resize(bytes);
+        m_Persistent = m_Cpu.data();
+        return;
+    }
+
+    GLCall(glGenBuffers(1, &m_RendererId));
+    Bind();
+
+    if (m_Mode == Mode::Persistent)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLCall(GLExtensions::BufferStorage(m_Target, bytes, nullptr, flags));
+        GLCall(m_Persistent = (unsigned char *)glMapBufferRange(m_Target, 0, bytes, flags));
+    }
+    else
+    {
+        GLCall(glBufferData(m_Target, bytes, nullptr, GL_STREAM_DRAW));
+    }
+}
+
+void StreamBuffer::release()
+{
+    if (m_Mode == Mode::Cpu)
+    {
+        GLState::forgetBuffer(m_RendererId);
+        m_Persistent = nullptr;
+        m_RendererId = 0;
+        return;
+    }
+
+    for (GLsync &fence : m_Fences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    if (m_Persistent)
+    {
+        Bind();
+        GLCall(glUnmapBuffer(m_Target));
+        m_Persistent = nullptr;
+    }
+
+    GLState::forgetBuffer(m_RendererId);
+    GLCall(glDeleteBuffers(1, &m_RendererId));
+    m_RendererId = 0;
+}
+
+void StreamBuffer::resize(unsigned int elementsPerFrame)
+{
+    // the regions may still be in flight
+    for (unsigned int region = 0; region < Frames; ++region)
+        waitFence(region);
+
+    release();
+    m_ElementsPerFrame = elementsPerFrame;
+    allocate();
+}
+
+void StreamBuffer::waitFence(unsigned int region)
+{
+    GLsync &fence = m_Fences[region];
+    if (!fence)
+        return;
+
+    // usually signalled already, two frames have passed since it was set
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+    {
+        m_Stalls++;
+        do
+        {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void StreamBuffer::beginFrame()
+{
+    m_Region = (m_Region + 1) % Frames;
+
+    if (m_Mode == Mode::Orphan)
+    {
+        // new storage on wrapping round to region 0, the driver keeps the
+        // old one alive; regions 1 and 2 of it haven't been drawn from yet
+        if (m_Region == 0)
+        {
+            Bind();
+            GLCall(glBufferData(m_Target, (GLsizeiptr)m_ElementSize * m_ElementsPerFrame * Frames,
+                                nullptr, GL_STREAM_DRAW));
+        }
+    }
+    else
+    {
+        waitFence(m_Region);
+    }
+
+    m_Cursor = m_Region * m_ElementsPerFrame;
+    m_RegionEnd = m_Cursor + m_ElementsPerFrame;
+}
+
+void StreamBuffer::endFrame()
+{
+    if (m_Mode != Mode::Orphan && m_Mode != Mode::Cpu && m_Cursor != m_Region * m_ElementsPerFrame)
+        m_Fences[m_Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void *StreamBuffer::map(unsigned int count, unsigned int &first)
+{
+    ASSERT(count <= available());
+
+    first = m_Cursor;
+    m_Cursor += count;
+    m_MappedFirst = first;
+    m_MappedCount = count;
+
+    GLintptr offset = (GLintptr)first * m_ElementSize;
+    GLsizeiptr size = (GLsizeiptr)count * m_ElementSize;
+
+    switch (m_Mode)
+    {
+    case Mode::Persistent:
+    case Mode::Cpu:
+        return m_Persistent + offset;
+
+    case Mode::Unsynchronized:
+    {
+        // the fence already guarantees the GPU is done with this range
+        Bind();
+        GLCall(void *ptr = glMapBufferRange(m_Target, offset, size,
+                                            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                                                GL_MAP_INVALIDATE_RANGE_BIT));
+        return ptr;
+    }
+
+    default:
+        if (m_Staging.size() < (size_t)size)
+            m_Staging.resize(size);
+        return m_Staging.data();
+    }
+}
+
+void StreamBuffer::unmap()
+{
+    if (m_Mode == Mode::Unsynchronized)
+    {
+        Bind();
+        GLCall(glUnmapBuffer(m_Target));
+    }
+    else if (m_Mode == Mode::Orphan)
+    {
+        Bind();
+        GLCall(glBufferSubData(m_Target, (GLintptr)m_MappedFirst * m_ElementSize,
+                               (GLsizeiptr)m_MappedCount * m_ElementSize, m_Staging.data()));
+    }
+    m_MappedCount = 0;
+}
+
+unsigned int StreamBuffer::write(const void *data, unsigned int count)
+{
+    unsigned int first;
+    void *dst = map(count, first);
+    std::memcpy(dst, data, (size_t)count * m_ElementSize);
+    unmap();
+    return first;
+}
+
+void StreamBuffer::Bind() const
+{
+    GLState::bindBuffer(m_Target, m_RendererId);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <glad/glad.h>
+#include <vector>
+
+// Ring buffer for data rewritten every frame (instance transforms, debug
+// lines, sprites). Storage is split into `Frames` regions; the CPU fills
+// one while the GPU may still read the other two, and a glFenceSync per
+// region tells us when it is safe to write into it again.
+//
+// Allocation is counted in elements, not bytes, so two streams with the
+// same elementsPerFrame fed in lockstep hand out the same element index
+// (used as the base instance for both).
+//
+// Backends, best first:
+//   Persistent     - ARB_buffer_storage, mapped once, persistent + coherent
+//   Unsynchronized - glMapBufferRange(UNSYNCHRONIZED) per write, GL 3.3
+//   Orphan         - glBufferData(null) once every Frames frames, on
+//                    wrapping round, + glBufferSubData
+//   Cpu            - plain memory, no GL buffer; picked by Auto when
+//                    GLState is headless
+class StreamBuffer
+{
+public:
+    enum class Mode { Auto, Persistent, Unsynchronized, Orphan, Cpu };
+
+    static const unsigned int Frames = 3;
+
+    StreamBuffer(unsigned int target, unsigned int elementSize, unsigned int elementsPerFrame,
+                 Mode mode = Mode::Auto);
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer &) = delete;
+    StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+    // waits (if needed) until the GPU is done with the next region
+    void beginFrame();
+    // fences the region written this frame
+    void endFrame();
+
+    // room left in this frame's region, in elements
+    unsigned int available() const { return m_RegionEnd - m_Cursor; }
+    // reallocates with a bigger region; waits for the GPU, drops this
+    // frame's data, and must be followed by beginFrame()
+    void resize(unsigned int elementsPerFrame);
+
+    // returns a CPU pointer for `count` elements and their index in the
+    // buffer; the pointer is valid until unmap()
+    void *map(unsigned int count, unsigned int &first);
+    void unmap();
+    // map + memcpy + unmap, returns the first element index
+    unsigned int write(const void *data, unsigned int count);
+
+    void Bind() const;
+    unsigned int GetRendererID() const { return m_RendererId; }
+    unsigned int getElementSize() const { return m_ElementSize; }
+    unsigned int getElementsPerFrame() const { return m_ElementsPerFrame; }
+    Mode getMode() const { return m_Mode; }
+    // how many beginFrame() calls actually had to block on a fence
+    unsigned int getStallCount() const { return m_Stalls; }
+    // Cpu mode only (null otherwise), for CPU backends
+    const unsigned char *getCpuData() const { return m_Mode == Mode::Cpu ? m_Cpu.data() : nullptr; }
+
+private:
+    unsigned int m_RendererId = 0;
+    unsigned int m_Target;
+    unsigned int m_ElementSize;
+    unsigned int m_ElementsPerFrame;
+    Mode m_Mode;
+
+    unsigned char *m_Persistent = nullptr; // Persistent / Cpu: whole buffer
+    std::vector<unsigned char> m_Cpu;      // Cpu: the storage itself
+    std::vector<unsigned char> m_Staging;  // Orphan: one pending write
+    unsigned int m_MappedFirst = 0;
+    unsigned int m_MappedCount = 0;
+
+    GLsync m_Fences[Frames] = {};
+    unsigned int m_Region = Frames - 1;
+    unsigned int m_Cursor = 0;
+    unsigned int m_RegionEnd = 0;
+    unsigned int m_Stalls = 0;
+
+    void allocate();
+    void release();
+    void waitFence(unsigned int region);
+};
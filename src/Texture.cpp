@@ -1,51 +1,329 @@
+#define GL_SUBSYSTEM GLSubsystemTextures
 #define STB_IMAGE_IMPLEMENTATION
 #include "Texture.hpp"
 #include "vendor/stb_image/stb_image.h"
+#include "GLState.hpp"
+#include "TextureLoader.hpp"
+#include "ImageIngest.hpp"
+#include "TextureResidency.hpp"
+#include "GLExtensions.hpp"
+#include <algorithm>
 
+const float Texture::BorderColor[4] = {0.744f, 0.907f, 0.702f, 1.0f};
 
+namespace
+{
+    const unsigned int MaxBoundSlots = 32;
+    const Texture *s_Bound[MaxBoundSlots] = {};
+}
 
-Texture::Texture(const std::string &path)
-    : m_rendererId(0), m_filePath(path), m_LocalBuffer(nullptr), m_Width(0), m_Height(0), m_BPP(0)
+Texture::Texture(const std::string &path, const TextureSampling &sampling)
+    : m_rendererId(0), m_filePath(path), m_LocalBuffer(nullptr), m_Width(0), m_Height(0), m_BPP(0),
+      m_Sampling(sampling)
 {
-    stbi_set_flip_vertically_on_load(1);
-    m_LocalBuffer = stbi_load(path.c_str(), &m_Width, &m_Height, &m_BPP, 4);
+    TextureResidency::add(this);
+    if (!GLState::headless())
+    {
+        std::unique_ptr<TextureContainer> container = TextureContainer::openFor(path);
+        if (container)
+        {
+            upload(*container);
+            return;
+        }
+    }
+    TextureImage image = ImageIngest::load(path);
+    m_LocalBuffer = image.pixels;
+    m_Width = image.width;
+    m_Height = image.height;
+    m_BPP = 4;
+    upload();
+}
 
-    GLCall(glGenTextures(1, &m_rendererId));
+Texture::Texture(const std::string &path, TextureImage image, const TextureSampling &sampling)
+    : m_rendererId(0), m_filePath(path), m_LocalBuffer(image.pixels), m_Width(image.width),
+      m_Height(image.height), m_BPP(4), m_Sampling(sampling)
+{
+    TextureResidency::add(this);
+    upload();
+}
 
-    
-    GLCall(glBindTexture(GL_TEXTURE_2D, m_rendererId));
-    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
-    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
-    GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height,
-            0, GL_RGBA, GL_UNSIGNED_BYTE, m_LocalBuffer));
-    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+Texture::Texture(const std::string &path, const unsigned char *placeholder, int width, int height,
+                 const TextureSampling &sampling)
+    : m_rendererId(0), m_filePath(path), m_LocalBuffer(nullptr), m_Width(width), m_Height(height), m_BPP(4),
+      m_Sampling(sampling), m_Resident(false)
+{
+    TextureResidency::add(this);
+    m_rendererId = create(width, height, 1, placeholder, sampling);
+}
 
-    GLCall(glBindTexture(GL_TEXTURE_2D, m_rendererId));
+Texture::Texture(const std::string &name, unsigned char *layers, int width, int height, int layerCount, bool array,
+                 int levels, const std::vector<MipChain> &chains, const TextureSampling &sampling)
+    : m_rendererId(0), m_filePath(name), m_LocalBuffer(layers), m_Width(width), m_Height(height), m_BPP(4),
+      m_Levels(levels), m_Layers(layerCount), m_Target(array || layerCount > 1 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D),
+      m_Sampling(sampling), m_Pinned(true)
+{
+    TextureResidency::add(this);
+    if (GLState::headless())
+    {
+        m_rendererId = GLState::headlessName();
+        return;
+    }
 
-    float borderColor[] = { 0.744f, 0.907f, 0.702f, 1.0f};
+    size_t layerBytes = (size_t)width * height * 4;
+    if (m_Target == GL_TEXTURE_2D)
+        m_rendererId = create(width, height, levels, layers, sampling);
+    else
+        m_rendererId = createArray(width, height, layerCount, levels, sampling);
+    for (int layer = 0; layer < layerCount; ++layer)
+    {
+        const MipChain *chain = layer < (int)chains.size() ? &chains[layer] : nullptr;
+        for (int level = 0; level < levels; ++level)
+        {
+            const unsigned char *pixels;
+            int w = width, h = height;
+            if (level == 0)
+            {
+                pixels = layers + layerBytes * layer;
+            }
+            else if (chain && level - 1 < (int)chain->levels.size())
+            {
+                pixels = chain->levelPixels(level - 1);
+                w = chain->levels[level - 1].width;
+                h = chain->levels[level - 1].height;
+            }
+            else
+            {
+                break;
+            }
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+            if (m_Target == GL_TEXTURE_2D_ARRAY)
+            {
+                GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, w, h, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                                       pixels));
+            }
+            else if (level > 0)
+            {
+                GLCall(glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+            }
+        }
+    }
+    if (levels > 1 && sampling.mipFilter == MipFilter::Driver)
+    {
+        GLCall(glGenerateMipmap(m_Target));
+    }
+
+    stbi_image_free(m_LocalBuffer);
+    m_LocalBuffer = nullptr;
+}
+
+void Texture::adopt(unsigned int texture, int width, int height, int levels, TextureFormat format, int baseLevel)
+{
+    GLState::forgetTexture(m_rendererId);
+    GLCall(glDeleteTextures(1, &m_rendererId));
+    m_rendererId = texture;
+    m_Width = width;
+    m_Height = height;
+    m_Levels = levels;
+    m_Format = format;
+    m_BaseLevel = baseLevel;
+    m_StreamLevel = -1;
+    m_Resident = true;
+}
+
+void Texture::upload()
+{
+    if (GLState::headless())
+    {
+        // kept for CPU backends, freed in the destructor
+        m_rendererId = GLState::headlessName();
+        return;
+    }
+
+    m_Levels = m_Sampling.mipmaps && m_LocalBuffer ? MipGenerator::levelCount(m_Width, m_Height) : 1;
+    m_rendererId = create(m_Width, m_Height, m_Levels, m_LocalBuffer, m_Sampling);
+    if (m_Levels > 1 && m_Sampling.mipFilter == MipFilter::Driver)
+    {
+        GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+    }
+    else if (m_Levels > 1)
+    {
+        TextureImage image;
+        image.pixels = m_LocalBuffer;
+        image.width = m_Width;
+        image.height = m_Height;
+        MipChain chain;
+        MipGenerator::buildCached(m_filePath, image, m_Sampling.mipFilter, chain);
+        for (size_t i = 0; i < chain.levels.size(); ++i)
+        {
+            const MipChain::Level &level = chain.levels[i];
+            GLCall(glTexSubImage2D(GL_TEXTURE_2D, (int)i + 1, 0, 0, level.width, level.height, GL_RGBA,
+                                   GL_UNSIGNED_BYTE, chain.levelPixels(i)));
+        }
+    }
 
     if (m_LocalBuffer)
         stbi_image_free(m_LocalBuffer);
+    m_LocalBuffer = nullptr;
+    }
+
+void Texture::upload(const TextureContainer &container)
+{
+    m_Width = container.getWidth();
+    m_Height = container.getHeight();
+    m_Format = container.getFormat();
+    m_Levels = m_Sampling.mipmaps ? container.getLevelCount() : 1;
+    m_rendererId = create(m_Width, m_Height, m_Levels, nullptr, m_Sampling, m_Format);
+
+    unsigned int format = TextureContainer::glFormat(m_Format);
+    for (int level = 0; level < m_Levels; ++level)
+    {
+        int width = std::max(1, m_Width >> level), height = std::max(1, m_Height >> level);
+        if (m_Format == TextureFormat::RGBA8)
+        {
+            GLCall(glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+                                   container.getLevelData(level)));
+        }
+        else
+        {
+            GLCall(glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, format,
+                                             (GLsizei)container.getLevelSize(level), container.getLevelData(level)));
+        }
+    }
+}
+
+unsigned int Texture::create(int width, int height, int levels, const unsigned char *pixels,
+                             const TextureSampling &sampling, TextureFormat format)
+{
+    unsigned int texture = 0;
+    GLCall(glGenTextures(1, &texture));
+    GLState::bindTexture(0, texture);
+
+    if (GLExtensions::ARB_texture_storage && width > 0 && height > 0)
+    {
+        GLCall(GLExtensions::TexStorage2D(GL_TEXTURE_2D, levels, TextureContainer::glFormat(format), width, height));
+        if (pixels)
+        {
+            GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+        }
+    }
+    else
+    {
+        for (int level = 0; level < levels; ++level)
+        {
+            int w = std::max(1, width >> level), h = std::max(1, height >> level);
+            if (format == TextureFormat::RGBA8)
+            {
+                GLCall(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                                    level == 0 ? pixels : nullptr));
+            }
+            else
+            {
+                GLCall(glCompressedTexImage2D(GL_TEXTURE_2D, level, TextureContainer::glFormat(format), w, h, 0,
+                                              (GLsizei)TextureContainer::levelSize(format, w, h), nullptr));
+            }
+        }
+        // complete with fewer levels than a full chain would have
+        GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1));
     }
-    
+
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER));
+    GLCall(glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, BorderColor));
+    applySampling(sampling, levels);
+    return texture;
+}
+
+unsigned int Texture::createArray(int width, int height, int layers, int levels, const TextureSampling &sampling)
+{
+    unsigned int texture = 0;
+    GLCall(glGenTextures(1, &texture));
+    GLState::bindTexture(0, texture, GL_TEXTURE_2D_ARRAY);
+
+    if (GLExtensions::TexStorage3D)
+    {
+        GLCall(GLExtensions::TexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, width, height, layers));
+    }
+    else
+    {
+        for (int level = 0; level < levels; ++level)
+        {
+            GLCall(glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, std::max(1, width >> level),
+                                std::max(1, height >> level), layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+        }
+        GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1));
+    }
+
+    // layers are atlas pages; their gutters, not a border, surround each image
+    GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+    applySampling(sampling, levels, GL_TEXTURE_2D_ARRAY);
+    return texture;
+}
+
+void Texture::applySampling(const TextureSampling &sampling, int levels, unsigned int target)
+{
+    int minFilter = GL_LINEAR;
+    if (levels > 1)
+        minFilter = sampling.trilinear ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR_MIPMAP_NEAREST;
+    GLCall(glTexParameteri(target, GL_TEXTURE_MIN_FILTER, minFilter));
+    GLCall(glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    if (GLExtensions::ARB_texture_filter_anisotropic)
+    {
+        float anisotropy = std::min(std::max(sampling.anisotropy, 1.0f), GLExtensions::MaxAnisotropy);
+        GLCall(glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY, anisotropy));
+    }
+}
+
+size_t Texture::getBytes() const
+{
+    size_t bytes = 0;
+    for (int level = 0; level < m_Levels; ++level)
+    {
+        int shift = m_BaseLevel + level;
+        bytes += TextureContainer::levelSize(m_Format, std::max(1, m_Width >> shift), std::max(1, m_Height >> shift));
+    }
+    return bytes * m_Layers;
+}
+
+void Texture::setSampling(const TextureSampling &sampling)
+{
+    m_Sampling.trilinear = sampling.trilinear;
+    m_Sampling.anisotropy = sampling.anisotropy;
+    if (GLState::headless())
+        return;
+    GLState::bindTexture(0, m_rendererId, m_Target);
+    applySampling(m_Sampling, m_Levels, m_Target);
+}
 
 void Texture::Bind(unsigned int slot) const {
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D, m_rendererId);
+    GLState::bindTexture(slot, m_rendererId, m_Target);
+    m_LastUsed = TextureResidency::frame();
+    if (slot < MaxBoundSlots)
+        s_Bound[slot] = this;
 }
 
 
 
 void Texture::UnBind() const {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::bindTexture(0, 0, m_Target);
+    s_Bound[0] = nullptr;
+}
+
+const Texture *Texture::boundAt(unsigned int slot)
+{
+    return slot < MaxBoundSlots ? s_Bound[slot] : nullptr;
 }
 
 Texture::~Texture() {
-    glDeleteTextures(1, &m_rendererId);
+    if (!m_Resident || m_StreamLevel >= 0)
+        TextureLoader::cancel(this);
+    TextureResidency::remove(this);
+    GLState::forgetTexture(m_rendererId);
+    for (const Texture *&bound : s_Bound)
+        if (bound == this)
+            bound = nullptr;
+    if (m_LocalBuffer)
+        stbi_image_free(m_LocalBuffer);
+    if (!GLState::headless())
+        glDeleteTextures(1, &m_rendererId);
 }
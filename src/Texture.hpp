@@ -1,5 +1,27 @@
 #pragma once
+#include <cstdint>
 #include "Renderer.hpp"
+#include "MipGenerator.hpp"
+#include "TextureContainer.hpp"
+
+// Decoded RGBA8 pixels, top row first as in the file (see ImageIngest,
+// which can run on any thread); the Texture built from it frees them.
+struct TextureImage
+{
+    unsigned char *pixels = nullptr;
+    int width = 0;
+    int height = 0;
+};
+
+// How a texture is sampled. Whether it has mip levels, and how they are
+// made, is settled when it is created; setSampling() changes the rest.
+struct TextureSampling
+{
+    bool mipmaps = true;
+    MipFilter mipFilter = MipFilter::Kaiser;
+    bool trilinear = true;   // blends the two nearest levels, otherwise picks one
+    float anisotropy = 8.0f; // clamped to GLExtensions::MaxAnisotropy; 1 is off
+};
 
 class Texture
 {
@@ -8,14 +30,95 @@ private:
     std::string m_filePath;
     unsigned char *m_LocalBuffer;
     int m_Width, m_Height, m_BPP;
+    int m_Levels = 1;
+    int m_Layers = 1;
+    unsigned int m_Target = GL_TEXTURE_2D;
+    TextureFormat m_Format = TextureFormat::RGBA8;
+    TextureSampling m_Sampling;
 
 public:
-    Texture(const std::string &path);
+    // A current TextureContainer next to `path` the driver can sample is
+    // uploaded instead of the image; otherwise CPU mip filters go through
+    // MipGenerator::buildCached, also next to `path`.
+    Texture(const std::string &path, const TextureSampling &sampling = TextureSampling());
+    // uploads an image decoded elsewhere and takes ownership of its pixels
+    Texture(const std::string &path, TextureImage image, const TextureSampling &sampling = TextureSampling());
     ~Texture();
 
     void Bind(unsigned int sloat = 0) const;
     void UnBind()const;
 
+    unsigned int GetRendererID() const { return m_rendererId; }
+    // false while a TextureLoader placeholder stands in for the file
+    bool isResident() const { return m_Resident; }
+    // TextureLoader couldn't read the file; the placeholder stays
+    bool hasFailed() const { return m_Failed; }
     inline int getWidth() const { return m_Width; }
     inline int getHeight() const { return m_Height; }
+    // mip levels in the GL texture, 1 without a chain (and when headless)
+    int getLevels() const { return m_Levels; }
+    // levels of the full chain TextureResidency has dropped from the top;
+    // the GL texture is getWidth() >> getBaseLevel() wide
+    int getBaseLevel() const { return m_BaseLevel; }
+    // GPU memory of the texture as it is now
+    size_t getBytes() const;
+    TextureFormat getFormat() const { return m_Format; }
+    // GL_TEXTURE_2D, or GL_TEXTURE_2D_ARRAY with getLayers() layers
+    unsigned int getTarget() const { return m_Target; }
+    int getLayers() const { return m_Layers; }
+
+    const TextureSampling& getSampling() const { return m_Sampling; }
+    // filters and anisotropy only; mipmaps and mipFilter stay as created
+    void setSampling(const TextureSampling &sampling);
+
+    // GL_CLAMP_TO_BORDER color, CPU samplers use it too
+    static const float BorderColor[4];
+    // headless only (null otherwise): RGBA8, top row first;
+    // an array's layers follow each other
+    const unsigned char* getPixels() const { return m_LocalBuffer; }
+    // last texture Bind() put on `slot`, for CPU backends
+    static const Texture* boundAt(unsigned int slot);
+
+private:
+    friend class TextureLoader;
+    friend class TextureAtlas;
+    friend class TextureResidency;
+    bool m_Resident = true;
+    bool m_Failed = false;
+
+    // TextureResidency bookkeeping; Bind() and requestScreenSize() touch
+    // it through const pointers
+    int m_BaseLevel = 0;
+    int m_StreamLevel = -1; // base level of a TextureLoader::restream() in flight
+    bool m_Pinned = false;  // no file to restream from (TextureAtlas pages)
+    mutable uint32_t m_LastUsed = 0;
+    mutable uint32_t m_ScreenSizeFrame = 0;
+    mutable float m_ScreenSize = 0.0f;
+
+    // TextureLoader: RGBA8 `placeholder` pixels until adopt() hands over
+    // the texture the file was uploaded to
+    Texture(const std::string &path, const unsigned char *placeholder, int width, int height,
+            const TextureSampling &sampling);
+    // width and height are level 0's, the GL texture starts at baseLevel
+    void adopt(unsigned int texture, int width, int height, int levels, TextureFormat format, int baseLevel = 0);
+
+    // TextureAtlas: `layerCount` RGBA8 pages of width x height back to back
+    // in `layers` (malloc'd, owned from here on), chains[i] being page i's
+    // levels below 0 (empty without mipmaps, or with MipFilter::Driver).
+    // `levels` may stop short of a full chain. One page and !array makes a
+    // GL_TEXTURE_2D, anything else a GL_TEXTURE_2D_ARRAY.
+    Texture(const std::string &name, unsigned char *layers, int width, int height, int layerCount, bool array,
+            int levels, const std::vector<MipChain> &chains, const TextureSampling &sampling);
+
+    void upload();
+    void upload(const TextureContainer &container);
+    // a GL_TEXTURE_2D with `levels` levels (immutable storage when the
+    // driver has it) and `sampling` applied, left bound on slot 0; level 0
+    // is filled from `pixels` (RGBA8 only) unless they are null
+    static unsigned int create(int width, int height, int levels, const unsigned char *pixels,
+                               const TextureSampling &sampling, TextureFormat format = TextureFormat::RGBA8);
+    // the same for a GL_TEXTURE_2D_ARRAY, edges clamped rather than bordered
+    static unsigned int createArray(int width, int height, int layers, int levels, const TextureSampling &sampling);
+    // filter state of the texture bound to `target` on slot 0
+    static void applySampling(const TextureSampling &sampling, int levels, unsigned int target = GL_TEXTURE_2D);
 };
@@ -0,0 +1,182 @@
+#include "TextureAtlas.hpp"
+#include "Console.hpp"
+#include "ImageIngest.hpp"
+#include "vendor/stb_image/stb_image.h"
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// imgui_draw.cpp compiles its own static copy; this one is ours
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "vendor/imgui/imstb_rectpack.h"
+
+TextureAtlas::TextureAtlas(const AtlasSettings &settings)
+    : m_Settings(settings)
+{
+    m_Settings.mipLevels = std::max(1, m_Settings.mipLevels);
+    m_Settings.padding = std::max(0, m_Settings.padding);
+    if (m_Settings.sampling.mipFilter == MipFilter::Kaiser)
+        m_Settings.sampling.mipFilter = MipFilter::Box;
+}
+
+TextureAtlas::~TextureAtlas()
+{
+    delete m_Texture;
+    for (Image &image : m_Images)
+        stbi_image_free(image.image.pixels);
+}
+
+TextureAtlas::ImageId TextureAtlas::add(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    TextureImage image = ImageIngest::decode(data.data(), data.size());
+    if (!image.pixels)
+    {
+        Console::LOGN("TextureAtlas: can't read " + path, Color::RED);
+        image.pixels = (unsigned char *)std::malloc(4);
+        std::memset(image.pixels, 255, 4);
+        image.width = image.height = 1;
+    }
+    return add(path, image);
+}
+
+TextureAtlas::ImageId TextureAtlas::add(const std::string &name, TextureImage image)
+{
+    m_Images.push_back({name, image, AtlasRegion()});
+    return (ImageId)(m_Images.size() - 1);
+}
+
+TextureAtlas::ImageId TextureAtlas::find(const std::string &name) const
+{
+    for (size_t i = 0; i < m_Images.size(); ++i)
+    {
+        if (m_Images[i].name == name)
+            return (ImageId)i;
+    }
+    return (ImageId)m_Images.size();
+}
+
+bool TextureAtlas::build()
+{
+    const int pageSize = m_Settings.pageSize;
+    // packed in grid cells, which also keeps every image on the grid
+    const int cell = 1 << (m_Settings.mipLevels - 1);
+    const int gutter = m_Settings.padding * cell;
+    const int pageCells = pageSize / cell;
+
+    std::vector<stbrp_rect> rects(m_Images.size());
+    for (size_t i = 0; i < m_Images.size(); ++i)
+    {
+        const TextureImage &image = m_Images[i].image;
+        rects[i].id = (int)i;
+        rects[i].w = (image.width + 2 * gutter + cell - 1) / cell;
+        rects[i].h = (image.height + 2 * gutter + cell - 1) / cell;
+        if (rects[i].w > pageCells || rects[i].h > pageCells)
+        {
+            Console::LOGN("TextureAtlas: " + m_Images[i].name + " doesn't fit a " + std::to_string(pageSize) +
+                              " page with its gutter",
+                          Color::RED);
+            return false;
+        }
+    }
+
+    // fill a page with what fits, start another with the rest
+    std::vector<int> pageOf(m_Images.size());
+    std::vector<stbrp_node> nodes(pageCells);
+    std::vector<stbrp_rect> pending = rects;
+    int pageCount = 0;
+    while (!pending.empty())
+    {
+        stbrp_context context;
+        stbrp_init_target(&context, pageCells, pageCells, nodes.data(), (int)nodes.size());
+        stbrp_pack_rects(&context, pending.data(), (int)pending.size());
+
+        std::vector<stbrp_rect> left;
+        for (const stbrp_rect &rect : pending)
+        {
+            if (rect.was_packed)
+            {
+                rects[rect.id] = rect;
+                pageOf[rect.id] = pageCount;
+            }
+            else
+            {
+                left.push_back(rect);
+            }
+        }
+        pageCount++;
+        pending.swap(left);
+    }
+    pageCount = std::max(1, pageCount);
+
+    // zeroed, so the space between images is transparent black
+    size_t pageBytes = (size_t)pageSize * pageSize * 4;
+    unsigned char *pages = (unsigned char *)std::calloc(pageBytes * pageCount, 1);
+    size_t covered = 0;
+    for (size_t i = 0; i < m_Images.size(); ++i)
+    {
+        const TextureImage &image = m_Images[i].image;
+        int x0 = rects[i].x * cell + gutter, y0 = rects[i].y * cell + gutter;
+        unsigned char *page = pages + pageBytes * pageOf[i];
+
+        // the gutter repeats the image's edge texels outwards
+        for (int y = -gutter; y < image.height + gutter; ++y)
+        {
+            const unsigned char *row = image.pixels + (size_t)std::min(std::max(y, 0), image.height - 1) * image.width * 4;
+            unsigned char *dst = page + ((size_t)(y0 + y) * pageSize + x0 - gutter) * 4;
+            for (int x = -gutter; x < 0; ++x, dst += 4)
+                std::memcpy(dst, row, 4);
+            std::memcpy(dst, row, (size_t)image.width * 4);
+            dst += (size_t)image.width * 4;
+            for (int x = 0; x < gutter; ++x, dst += 4)
+                std::memcpy(dst, row + (size_t)(image.width - 1) * 4, 4);
+        }
+
+        AtlasRegion &region = m_Images[i].region;
+        region.rect = glm::vec4((float)x0, (float)y0, (float)image.width, (float)image.height) / (float)pageSize;
+        region.layer = (float)pageOf[i];
+        covered += (size_t)image.width * image.height;
+    }
+
+    const TextureSampling &sampling = m_Settings.sampling;
+    int levels = 1;
+    if (sampling.mipmaps)
+        levels = std::min(m_Settings.mipLevels, MipGenerator::levelCount(pageSize, pageSize));
+    std::vector<MipChain> chains;
+    if (levels > 1 && sampling.mipFilter != MipFilter::Driver)
+    {
+        chains.resize(pageCount);
+        for (int p = 0; p < pageCount; ++p)
+        {
+            TextureImage page;
+            page.pixels = pages + pageBytes * p;
+            page.width = page.height = pageSize;
+            MipGenerator::build(page, MipFilter::Box, chains[p]);
+        }
+    }
+
+    delete m_Texture;
+    m_Texture = new Texture("atlas", pages, pageSize, pageSize, pageCount, m_Settings.array, levels, chains, sampling);
+    m_PageCount = pageCount;
+    m_Occupancy = (float)covered / ((float)pageSize * pageSize * pageCount);
+    Console::LOGN("TextureAtlas: " + std::to_string(m_Images.size()) + " images on " + std::to_string(pageCount) +
+                      " pages of " + std::to_string(pageSize) + ", " + std::to_string((int)(m_Occupancy * 100.0f)) +
+                      "% used",
+                  Color::GREEN);
+    return true;
+}
+
+void TextureAtlas::remapTexCoords(float *vertices, unsigned int vertexCount, unsigned int stride, unsigned int offset,
+                                  const AtlasRegion &region)
+{
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        float *uv = vertices + (size_t)i * stride + offset;
+        uv[0] = region.rect.x + std::min(std::max(uv[0], 0.0f), 1.0f) * region.rect.z;
+        uv[1] = region.rect.y + std::min(std::max(uv[1], 0.0f), 1.0f) * region.rect.w;
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Texture.hpp"
+#include "vendor/glm/glm.hpp"
+
+// Where one image ended up: texcoords in [0, 1] over the image map to
+// rect.xy + uv * rect.zw on page `layer`. Tightly packed, so it can go
+// straight into an instance stream (Mesh.shader's ATLAS attributes).
+struct AtlasRegion
+{
+    glm::vec4 rect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f); // offset xy, scale zw
+    float layer = 0.0f;
+};
+static_assert(sizeof(AtlasRegion) == 5 * sizeof(float), "AtlasRegion is read as vec4 + float");
+
+struct AtlasSettings
+{
+    int pageSize = 2048;
+    // texels of edge color kept around each image at the smallest level
+    int padding = 1;
+    // levels that stay free of neighbours; each image gets a gutter of
+    // padding << (mipLevels - 1) texels and sits on a 1 << (mipLevels - 1)
+    // grid, so no level down to mipLevels - 1 averages two images
+    int mipLevels = 4;
+    // a GL_TEXTURE_2D_ARRAY even when everything fits on one page, so the
+    // ATLAS shader variant can sample it
+    bool array = true;
+    // mipFilter Kaiser is built as Box: its wider taps would cross the gutters
+    TextureSampling sampling;
+};
+
+// Packs many small images into a few big pages (stb_rect_pack), so
+// objects with different images share one texture bind and can go out in
+// one batch. Images are added first, build() packs and uploads them, and
+// each image's AtlasRegion then remaps its texcoords: per instance on the
+// GPU (Graphicsengine::draw with a region), or on the CPU for meshes
+// baked once (remapTexCoords).
+//
+// Pages become the layers of one GL_TEXTURE_2D_ARRAY. With one page and
+// AtlasSettings::array off it's a plain GL_TEXTURE_2D instead, for shaders
+// that only take a sampler2D; then the layer is always 0.
+class TextureAtlas
+{
+public:
+    using ImageId = uint32_t;
+
+    explicit TextureAtlas(const AtlasSettings &settings = AtlasSettings());
+    ~TextureAtlas();
+
+    TextureAtlas(const TextureAtlas&) = delete;
+    TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+    // decodes `path` now; an unreadable file gets a 1x1 white image
+    ImageId add(const std::string &path);
+    // takes ownership of image.pixels (stb_image or malloc memory)
+    ImageId add(const std::string &name, TextureImage image);
+
+    // packs every image into pages and (re)creates the texture; false if
+    // an image is bigger than a page. Regions are valid from here on.
+    bool build();
+
+    const AtlasRegion &getRegion(ImageId id) const { return m_Images[id].region; }
+    ImageId find(const std::string &name) const;
+    // null before build()
+    Texture *getTexture() const { return m_Texture; }
+    int getPageCount() const { return m_PageCount; }
+    // share of the page area covered by images, gutters excluded
+    float getOccupancy() const { return m_Occupancy; }
+
+    // rewrites texcoords in place: `stride` floats per vertex, the uv pair
+    // `offset` floats in; uvs outside [0, 1] are clamped to the image
+    static void remapTexCoords(float *vertices, unsigned int vertexCount, unsigned int stride, unsigned int offset,
+                               const AtlasRegion &region);
+
+private:
+    struct Image
+    {
+        std::string name;
+        TextureImage image;
+        AtlasRegion region;
+    };
+
+    AtlasSettings m_Settings;
+    std::vector<Image> m_Images;
+    Texture *m_Texture = nullptr;
+    int m_PageCount = 0;
+    float m_Occupancy = 0.0f;
+};
@@ -0,0 +1,250 @@
+#include "TextureContainer.hpp"
+#include "GLExtensions.hpp"
+#include "Console.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define TEXTURE_CONTAINER_MMAP 1
+#endif
+
+namespace
+{
+    // 2: rows top first (ImageIngest); version 1 files are ignored
+    const char Identifier[8] = {'B', 'T', 'E', 'X', '2', '\r', '\n', '\x1A'};
+    const uint64_t LevelAlignment = 16;
+
+    struct FileHeader
+    {
+        char identifier[8];
+        uint32_t format; // TextureFormat
+        uint32_t width, height;
+        uint32_t levelCount;
+    };
+}
+
+TextureContainer::~TextureContainer()
+{
+    close();
+}
+
+void TextureContainer::close()
+{
+#if TEXTURE_CONTAINER_MMAP
+    if (m_Mapped)
+        munmap((void *)m_Data, m_Size);
+#endif
+    m_Mapped = false;
+    m_Data = nullptr;
+    m_Size = 0;
+    m_Copy.clear();
+    m_Levels.clear();
+}
+
+bool TextureContainer::open(const std::string &path)
+{
+    close();
+#if TEXTURE_CONTAINER_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+    {
+        void *data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            m_Data = (const unsigned char *)data;
+            m_Size = (size_t)info.st_size;
+            m_Mapped = true;
+            // read ahead now, on whichever thread opened it, rather than
+            // fault page by page during the upload
+            madvise(data, m_Size, MADV_WILLNEED);
+        }
+    }
+    ::close(fd);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (file)
+    {
+        m_Copy.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        m_Data = m_Copy.data();
+        m_Size = m_Copy.size();
+    }
+#endif
+    if (!m_Data)
+        return false;
+
+    FileHeader header;
+    if (m_Size < sizeof(header))
+    {
+        close();
+        return false;
+    }
+    std::memcpy(&header, m_Data, sizeof(header));
+    if (!std::equal(Identifier, Identifier + 8, header.identifier) || header.format > (uint32_t)TextureFormat::BC7 ||
+        header.levelCount == 0 || header.levelCount > 32)
+    {
+        close();
+        return false;
+    }
+
+    m_Format = (TextureFormat)header.format;
+    m_Width = (int)header.width;
+    m_Height = (int)header.height;
+    size_t indexEnd = sizeof(header) + header.levelCount * sizeof(Level);
+    if (m_Size < indexEnd)
+    {
+        close();
+        return false;
+    }
+    m_Levels.resize(header.levelCount);
+    std::memcpy(m_Levels.data(), m_Data + sizeof(header), header.levelCount * sizeof(Level));
+
+    // a truncated or foreign file must not send GL past the end
+    for (int i = 0; i < (int)m_Levels.size(); ++i)
+    {
+        const Level &level = m_Levels[i];
+        size_t expected = levelSize(m_Format, std::max(1, m_Width >> i), std::max(1, m_Height >> i));
+        if (level.size != expected || level.offset > m_Size || level.size > m_Size - level.offset)
+        {
+            Console::LOGN("TextureContainer: " + path + " is damaged", Color::YELLOW);
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+std::unique_ptr<TextureContainer> TextureContainer::openFor(const std::string &imagePath)
+{
+    std::string path = pathFor(imagePath);
+    std::error_code error;
+    auto packed = std::filesystem::last_write_time(path, error);
+    if (error)
+        return nullptr;
+    // an image edited since it was encoded wins
+    auto image = std::filesystem::last_write_time(imagePath, error);
+    if (!error && image > packed)
+        return nullptr;
+
+    std::unique_ptr<TextureContainer> container(new TextureContainer());
+    if (!container->open(path) || !supported(container->getFormat()))
+        return nullptr;
+    return container;
+}
+
+bool TextureContainer::write(const std::string &path, TextureFormat format, int width, int height,
+                             const std::vector<std::vector<unsigned char>> &levels)
+{
+    FileHeader header = {{}, (uint32_t)format, (uint32_t)width, (uint32_t)height, (uint32_t)levels.size()};
+    std::memcpy(header.identifier, Identifier, sizeof(Identifier));
+
+    std::vector<Level> index(levels.size());
+    uint64_t offset = sizeof(header) + levels.size() * sizeof(Level);
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        offset = (offset + LevelAlignment - 1) / LevelAlignment * LevelAlignment;
+        index[i] = {offset, (uint64_t)levels[i].size()};
+        offset += levels[i].size();
+    }
+
+    // renamed over the old one, so a mapped reader never sees half a file
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            Console::LOGN("TextureContainer: can't write " + temporary, Color::RED);
+            return false;
+        }
+        file.write((const char *)&header, sizeof(header));
+        file.write((const char *)index.data(), (std::streamsize)(index.size() * sizeof(Level)));
+        for (size_t i = 0; i < levels.size(); ++i)
+        {
+            static const char padding[LevelAlignment] = {};
+            file.write(padding, (std::streamsize)(index[i].offset - (uint64_t)file.tellp()));
+            file.write((const char *)levels[i].data(), (std::streamsize)levels[i].size());
+        }
+        if (!file)
+            return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    return !error;
+}
+
+std::string TextureContainer::pathFor(const std::string &imagePath)
+{
+    return std::filesystem::path(imagePath).replace_extension(".btex").generic_string();
+}
+
+size_t TextureContainer::levelSize(TextureFormat format, int width, int height)
+{
+    size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+    switch (format)
+    {
+    case TextureFormat::BC1:
+        return blocks * 8;
+    case TextureFormat::BC3:
+    case TextureFormat::BC7:
+        return blocks * 16;
+    case TextureFormat::RGBA8:
+        break;
+    }
+    return (size_t)width * height * 4;
+}
+
+unsigned int TextureContainer::glFormat(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::BC1:
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case TextureFormat::BC3:
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case TextureFormat::BC7:
+        return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    case TextureFormat::RGBA8:
+        break;
+    }
+    return GL_RGBA8;
+}
+
+bool TextureContainer::supported(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::BC1:
+    case TextureFormat::BC3:
+        return GLExtensions::EXT_texture_compression_s3tc;
+    case TextureFormat::BC7:
+        return GLExtensions::ARB_texture_compression_bptc;
+    case TextureFormat::RGBA8:
+        break;
+    }
+    return true;
+}
+
+const char *TextureContainer::formatName(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::BC1:
+        return "BC1";
+    case TextureFormat::BC3:
+        return "BC3";
+    case TextureFormat::BC7:
+        return "BC7";
+    case TextureFormat::RGBA8:
+        break;
+    }
+    return "RGBA8";
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// What a texture's levels are stored as, on disk and on the GPU.
+enum class TextureFormat : uint32_t
+{
+    RGBA8,
+    BC1, // DXT1: RGB, 4 bits per texel
+    BC3, // DXT5: RGB + smooth alpha, 8 bits per texel
+    BC7  // BPTC: RGBA at higher quality than BC3, 8 bits per texel
+};
+
+// A texture with all its mip levels, ready to upload: TextureEncoder
+// writes them offline next to the source image ("crate.png" ->
+// "crate.btex") and Texture / TextureLoader pick them up instead of the
+// image when they are at least as new and the driver has the format.
+//
+// Laid out like KTX2, minus what this engine has no use for: an
+// identifier, a header, a level index (offset and size per level, level 0
+// first), then the levels, each 16-byte aligned. The file is mapped, not
+// read, so the levels go to GL straight from the page cache.
+class TextureContainer
+{
+public:
+    TextureContainer() = default;
+    ~TextureContainer();
+
+    TextureContainer(const TextureContainer&) = delete;
+    TextureContainer& operator=(const TextureContainer&) = delete;
+
+    // maps `path` and checks its header and level index
+    bool open(const std::string &path);
+
+    // the container for `imagePath` if there is a current one the driver
+    // can sample, otherwise null
+    static std::unique_ptr<TextureContainer> openFor(const std::string &imagePath);
+
+    // levels[0] is the full-size image, each already in `format`
+    static bool write(const std::string &path, TextureFormat format, int width, int height,
+                      const std::vector<std::vector<unsigned char>> &levels);
+
+    TextureFormat getFormat() const { return m_Format; }
+    int getWidth() const { return m_Width; }
+    int getHeight() const { return m_Height; }
+    int getLevelCount() const { return (int)m_Levels.size(); }
+    const unsigned char *getLevelData(int level) const { return m_Data + m_Levels[level].offset; }
+    size_t getLevelSize(int level) const { return (size_t)m_Levels[level].size; }
+
+    // "crate.png" -> "crate.btex"
+    static std::string pathFor(const std::string &imagePath);
+    // bytes of one level; block formats round up to whole 4x4 blocks
+    static size_t levelSize(TextureFormat format, int width, int height);
+    // the GL internal format, and whether GLExtensions says it's there
+    static unsigned int glFormat(TextureFormat format);
+    static bool supported(TextureFormat format);
+    static const char *formatName(TextureFormat format);
+
+private:
+    struct Level
+    {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    TextureFormat m_Format = TextureFormat::RGBA8;
+    int m_Width = 0, m_Height = 0;
+    std::vector<Level> m_Levels;
+
+    const unsigned char *m_Data = nullptr;
+    size_t m_Size = 0;
+    // platforms without mmap read the file in here instead
+    std::vector<unsigned char> m_Copy;
+    bool m_Mapped = false;
+
+    void close();
+};
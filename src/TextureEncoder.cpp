@@ -0,0 +1,495 @@
+#include "TextureEncoder.hpp"
+#include "Texture.hpp"
+#include "MipGenerator.hpp"
+#include "Console.hpp"
+#include "ImageIngest.hpp"
+#include "vendor/stb_image/stb_image.h"
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+
+namespace
+{
+    struct Block
+    {
+        float texel[16][4];
+    };
+
+    // edge blocks repeat the last row / column
+    void fetchBlock(const unsigned char *rgba, int width, int height, int bx, int by, Block &block)
+    {
+        for (int y = 0; y < 4; ++y)
+        {
+            int row = std::min(by * 4 + y, height - 1);
+            for (int x = 0; x < 4; ++x)
+            {
+                int column = std::min(bx * 4 + x, width - 1);
+                const unsigned char *p = rgba + ((size_t)row * width + column) * 4;
+                for (int c = 0; c < 4; ++c)
+                    block.texel[y * 4 + x][c] = p[c];
+            }
+        }
+    }
+
+    float distance(const float *a, const float *b, int channels)
+    {
+        float d = 0.0f;
+        for (int c = 0; c < channels; ++c)
+            d += (a[c] - b[c]) * (a[c] - b[c]);
+        return d;
+    }
+
+    // the two ends of the block's spread along its principal axis (power
+    // iteration on the covariance), pulled in by 1/16 of the range: the
+    // extremes are rarely worth a palette entry of their own
+    void endpoints(const Block &block, int channels, float e0[4], float e1[4])
+    {
+        float mean[4] = {}, low[4], high[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            low[c] = 255.0f;
+            high[c] = 0.0f;
+        }
+        for (const float *p : block.texel)
+        {
+            for (int c = 0; c < channels; ++c)
+            {
+                mean[c] += p[c] / 16.0f;
+                low[c] = std::min(low[c], p[c]);
+                high[c] = std::max(high[c], p[c]);
+            }
+        }
+
+        float cov[4][4] = {};
+        for (const float *p : block.texel)
+            for (int i = 0; i < channels; ++i)
+                for (int j = 0; j < channels; ++j)
+                    cov[i][j] += (p[i] - mean[i]) * (p[j] - mean[j]);
+
+        float axis[4] = {};
+        for (int c = 0; c < channels; ++c)
+            axis[c] = high[c] - low[c];
+        for (int iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[4] = {}, length = 0.0f;
+            for (int i = 0; i < channels; ++i)
+            {
+                for (int j = 0; j < channels; ++j)
+                    next[i] += cov[i][j] * axis[j];
+                length = std::max(length, std::fabs(next[i]));
+            }
+            if (length == 0.0f)
+                break;
+            for (int c = 0; c < channels; ++c)
+                axis[c] = next[c] / length;
+        }
+
+        float tMin = 0.0f, tMax = 0.0f;
+        float norm = 0.0f;
+        for (int c = 0; c < channels; ++c)
+            norm += axis[c] * axis[c];
+        if (norm > 0.0f)
+        {
+            tMin = 1e30f;
+            tMax = -1e30f;
+            for (const float *p : block.texel)
+            {
+                float t = 0.0f;
+                for (int c = 0; c < channels; ++c)
+                    t += (p[c] - mean[c]) * axis[c];
+                t /= norm;
+                tMin = std::min(tMin, t);
+                tMax = std::max(tMax, t);
+            }
+            float inset = (tMax - tMin) / 16.0f;
+            tMin += inset;
+            tMax -= inset;
+        }
+        for (int c = 0; c < 4; ++c)
+        {
+            e0[c] = c < channels ? std::min(std::max(mean[c] + axis[c] * tMax, 0.0f), 255.0f) : 255.0f;
+            e1[c] = c < channels ? std::min(std::max(mean[c] + axis[c] * tMin, 0.0f), 255.0f) : 255.0f;
+        }
+    }
+
+    // nearest palette entry per texel, returns the summed error
+    float pickIndices(const Block &block, const float (*palette)[4], int entries, int channels, int *indices)
+    {
+        float total = 0.0f;
+        for (int i = 0; i < 16; ++i)
+        {
+            float best = 1e30f;
+            for (int e = 0; e < entries; ++e)
+            {
+                float d = distance(block.texel[i], palette[e], channels);
+                if (d < best)
+                {
+                    best = d;
+                    indices[i] = e;
+                }
+            }
+            total += best;
+        }
+        return total;
+    }
+
+    // endpoints that best reproduce the texels for fixed indices, where
+    // index i stands for weight[i] * e1 + (1 - weight[i]) * e0
+    bool refit(const Block &block, const int *indices, const float *weight, int channels, float e0[4], float e1[4])
+    {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f, ap[4] = {}, bp[4] = {};
+        for (int i = 0; i < 16; ++i)
+        {
+            float b = weight[indices[i]], a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (int c = 0; c < channels; ++c)
+            {
+                ap[c] += a * block.texel[i][c];
+                bp[c] += b * block.texel[i][c];
+            }
+        }
+        float det = aa * bb - ab * ab;
+        if (std::fabs(det) < 1e-6f)
+            return false;
+        for (int c = 0; c < channels; ++c)
+        {
+            e0[c] = std::min(std::max((bb * ap[c] - ab * bp[c]) / det, 0.0f), 255.0f);
+            e1[c] = std::min(std::max((aa * bp[c] - ab * ap[c]) / det, 0.0f), 255.0f);
+        }
+        return true;
+    }
+
+    // ---- BC1 ----
+
+    uint16_t pack565(const float *c)
+    {
+        int r = (int)(c[0] * 31.0f / 255.0f + 0.5f);
+        int g = (int)(c[1] * 63.0f / 255.0f + 0.5f);
+        int b = (int)(c[2] * 31.0f / 255.0f + 0.5f);
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    void unpack565(uint16_t v, float *c)
+    {
+        int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+        c[0] = (float)((r << 3) | (r >> 2));
+        c[1] = (float)((g << 2) | (g >> 4));
+        c[2] = (float)((b << 3) | (b >> 2));
+        c[3] = 255.0f;
+    }
+
+    // four-color mode only (c0 > c1), which BC3 requires anyway
+    float colorBlock(const Block &block, const float e0[4], const float e1[4], unsigned char *out)
+    {
+        uint16_t c0 = pack565(e0), c1 = pack565(e1);
+        if (c0 < c1)
+            std::swap(c0, c1);
+
+        float palette[4][4];
+        unpack565(c0, palette[0]);
+        unpack565(c1, palette[1]);
+        for (int c = 0; c < 4; ++c)
+        {
+            palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+            palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+        }
+        int indices[16] = {};
+        float error = c0 == c1 ? pickIndices(block, palette, 1, 3, indices) : pickIndices(block, palette, 4, 3, indices);
+
+        uint32_t bits = 0;
+        for (int i = 0; i < 16; ++i)
+            bits |= (uint32_t)indices[i] << (2 * i);
+        std::memcpy(out, &c0, 2);
+        std::memcpy(out + 2, &c1, 2);
+        std::memcpy(out + 4, &bits, 4);
+        return error;
+    }
+
+    void encodeBC1(const Block &block, unsigned char *out)
+    {
+        float e0[4], e1[4];
+        endpoints(block, 3, e0, e1);
+        float error = colorBlock(block, e0, e1, out);
+
+        // refit to what the indices ended up meaning; keep it if it helps
+        uint16_t c0, c1;
+        uint32_t bits;
+        std::memcpy(&c0, out, 2);
+        std::memcpy(&c1, out + 2, 2);
+        std::memcpy(&bits, out + 4, 4);
+        if (c0 == c1)
+            return;
+        int indices[16];
+        for (int i = 0; i < 16; ++i)
+            indices[i] = (bits >> (2 * i)) & 3;
+        static const float weight[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+        unpack565(c0, e0);
+        unpack565(c1, e1);
+        unsigned char candidate[8];
+        if (refit(block, indices, weight, 3, e0, e1) && colorBlock(block, e0, e1, candidate) < error)
+            std::memcpy(out, candidate, 8);
+    }
+
+    // ---- BC3 ----
+
+    void encodeAlpha(const Block &block, unsigned char *out)
+    {
+        int high = 0, low = 255;
+        for (const float *p : block.texel)
+        {
+            high = std::max(high, (int)p[3]);
+            low = std::min(low, (int)p[3]);
+        }
+        // a0 > a1 selects the eight-step ramp
+        float palette[8] = {(float)high, (float)low};
+        for (int i = 2; i < 8; ++i)
+            palette[i] = ((8 - i) * palette[0] + (i - 1) * palette[1]) / 7.0f;
+
+        uint64_t bits = 0;
+        for (int i = 0; i < 16 && high != low; ++i)
+        {
+            int bestIndex = 0;
+            float best = 1e30f;
+            for (int e = 0; e < 8; ++e)
+            {
+                float d = std::fabs(block.texel[i][3] - palette[e]);
+                if (d < best)
+                {
+                    best = d;
+                    bestIndex = e;
+                }
+            }
+            bits |= (uint64_t)bestIndex << (3 * i);
+        }
+        out[0] = (unsigned char)high;
+        out[1] = (unsigned char)low;
+        for (int i = 0; i < 6; ++i)
+            out[2 + i] = (unsigned char)(bits >> (8 * i));
+    }
+
+    void encodeBC3(const Block &block, unsigned char *out)
+    {
+        encodeAlpha(block, out);
+        encodeBC1(block, out + 8);
+    }
+
+    // ---- BC7 mode 6 ----
+
+    const int Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    // seven bits per channel plus a bit shared by all four
+    void quantize7(const float *e, int q[4], int &p)
+    {
+        float bestError = 1e30f;
+        for (int bit = 0; bit < 2; ++bit)
+        {
+            int candidate[4];
+            float error = 0.0f;
+            for (int c = 0; c < 4; ++c)
+            {
+                candidate[c] = std::min(std::max((int)((e[c] - bit) / 2.0f + 0.5f), 0), 127);
+                float v = (float)((candidate[c] << 1) | bit);
+                error += (v - e[c]) * (v - e[c]);
+            }
+            if (error < bestError)
+            {
+                bestError = error;
+                p = bit;
+                std::copy(candidate, candidate + 4, q);
+            }
+        }
+    }
+
+    struct BitWriter
+    {
+        unsigned char *out;
+        int position = 0;
+
+        void write(uint32_t value, int bits)
+        {
+            for (int i = 0; i < bits; ++i, ++position)
+            {
+                if (value & (1u << i))
+                    out[position >> 3] |= (unsigned char)(1u << (position & 7));
+            }
+        }
+    };
+
+    float mode6(const Block &block, const float e0[4], const float e1[4], unsigned char *out)
+    {
+        int q0[4], q1[4], p0 = 0, p1 = 0;
+        quantize7(e0, q0, p0);
+        quantize7(e1, q1, p1);
+
+        float palette[16][4];
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                int a = (q0[c] << 1) | p0, b = (q1[c] << 1) | p1;
+                palette[i][c] = (float)(((64 - Weights4[i]) * a + Weights4[i] * b + 32) >> 6);
+            }
+        }
+        int indices[16];
+        float error = pickIndices(block, palette, 16, 4, indices);
+
+        // the first texel's index has its top bit implied zero
+        if (indices[0] >= 8)
+        {
+            std::swap(q0, q1);
+            std::swap(p0, p1);
+            for (int &index : indices)
+                index = 15 - index;
+        }
+
+        std::memset(out, 0, 16);
+        BitWriter writer = {out};
+        writer.write(1u << 6, 7);
+        for (int c = 0; c < 4; ++c)
+        {
+            writer.write((uint32_t)q0[c], 7);
+            writer.write((uint32_t)q1[c], 7);
+        }
+        writer.write((uint32_t)p0, 1);
+        writer.write((uint32_t)p1, 1);
+        for (int i = 0; i < 16; ++i)
+            writer.write((uint32_t)indices[i], i == 0 ? 3 : 4);
+        return error;
+    }
+
+    void encodeBC7(const Block &block, unsigned char *out)
+    {
+        float e0[4], e1[4];
+        endpoints(block, 4, e0, e1);
+        float error = mode6(block, e0, e1, out);
+
+        // refit against the unquantized ramp, as for BC1
+        float palette[16][4];
+        for (int i = 0; i < 16; ++i)
+            for (int c = 0; c < 4; ++c)
+                palette[i][c] = e0[c] + (e1[c] - e0[c]) * Weights4[i] / 64.0f;
+        int indices[16];
+        pickIndices(block, palette, 16, 4, indices);
+        float weight[16];
+        for (int i = 0; i < 16; ++i)
+            weight[i] = Weights4[i] / 64.0f;
+        unsigned char candidate[16];
+        if (refit(block, indices, weight, 4, e0, e1) && mode6(block, e0, e1, candidate) < error)
+            std::memcpy(out, candidate, 16);
+    }
+}
+
+std::vector<unsigned char> TextureEncoder::encode(const unsigned char *rgba, int width, int height,
+                                                  TextureFormat format)
+{
+    if (format == TextureFormat::RGBA8)
+        return std::vector<unsigned char>(rgba, rgba + (size_t)width * height * 4);
+
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    size_t blockBytes = format == TextureFormat::BC1 ? 8 : 16;
+    std::vector<unsigned char> out((size_t)blocksX * blocksY * blockBytes);
+
+    std::atomic<int> nextRow{0};
+    auto work = [&] {
+        Block block;
+        for (int by = nextRow++; by < blocksY; by = nextRow++)
+        {
+            for (int bx = 0; bx < blocksX; ++bx)
+            {
+                fetchBlock(rgba, width, height, bx, by, block);
+                unsigned char *dst = out.data() + ((size_t)by * blocksX + bx) * blockBytes;
+                if (format == TextureFormat::BC1)
+                    encodeBC1(block, dst);
+                else if (format == TextureFormat::BC3)
+                    encodeBC3(block, dst);
+                else
+                    encodeBC7(block, dst);
+            }
+        }
+    };
+
+    // small levels aren't worth a thread
+    unsigned int threads = blocksY < 16 ? 1 : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> pool;
+    for (unsigned int i = 1; i < threads; ++i)
+        pool.emplace_back(work);
+    work();
+    for (std::thread &thread : pool)
+        thread.join();
+    return out;
+}
+
+TextureFormat TextureEncoder::chooseFormat(const TextureImage &image)
+{
+    // decode() always expands to four channels; an image without alpha
+    // comes back with all of it at 255
+    size_t texels = (size_t)image.width * image.height;
+    for (size_t i = 0; i < texels; ++i)
+    {
+        if (image.pixels[i * 4 + 3] != 255)
+            return TextureFormat::BC3;
+    }
+    return TextureFormat::BC1;
+}
+
+bool TextureEncoder::encodeFile(const std::string &imagePath, Choice choice)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::ifstream file(imagePath, std::ios::binary);
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    TextureImage image = ImageIngest::decode(data.data(), data.size());
+    if (!image.pixels)
+    {
+        Console::LOGN("TextureEncoder: can't read " + imagePath, Color::RED);
+        return false;
+    }
+
+    TextureFormat format = TextureFormat::BC1;
+    switch (choice)
+    {
+    case Choice::Auto:
+        format = chooseFormat(image);
+        break;
+    case Choice::BC1:
+        format = TextureFormat::BC1;
+        break;
+    case Choice::BC3:
+        format = TextureFormat::BC3;
+        break;
+    case Choice::BC7:
+        format = TextureFormat::BC7;
+        break;
+    }
+
+    MipChain mips;
+    MipGenerator::build(image, MipFilter::Kaiser, mips);
+    std::vector<std::vector<unsigned char>> levels;
+    levels.push_back(encode(image.pixels, image.width, image.height, format));
+    for (size_t i = 0; i < mips.levels.size(); ++i)
+        levels.push_back(encode(mips.levelPixels(i), mips.levels[i].width, mips.levels[i].height, format));
+
+    size_t packed = 0;
+    for (const std::vector<unsigned char> &level : levels)
+        packed += level.size();
+    size_t raw = (size_t)image.width * image.height * 4 + mips.pixels.size();
+    std::string path = TextureContainer::pathFor(imagePath);
+    bool written = TextureContainer::write(path, format, image.width, image.height, levels);
+    stbi_image_free(image.pixels);
+    if (!written)
+        return false;
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    Console::LOGN("TextureEncoder: " + path + " " + TextureContainer::formatName(format) + ", " +
+                      std::to_string(levels.size()) + " levels, " + std::to_string(packed / 1024) + " KB (RGBA8 " +
+                      std::to_string(raw / 1024) + " KB), " + std::to_string((int)ms) + " ms",
+                  Color::GREEN);
+    return true;
+}
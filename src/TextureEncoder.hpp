@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "TextureContainer.hpp"
+
+struct TextureImage;
+
+// Offline block compression into TextureContainer files. Not meant for
+// load time: run it over res/ (app --encode-texture) and ship the .btex
+// files next to the images.
+//
+//   BC1  endpoints from the block's principal axis, inset a little, then
+//        one least-squares refit to the chosen indices
+//   BC3  BC1 color plus an 8-step alpha block between the alpha extremes
+//   BC7  mode 6 only (one subset, RGBA endpoints with a shared bit, 4-bit
+//        indices), which covers photographic and alpha content well
+//
+// Every block is encoded from the same Kaiser mip chain the runtime
+// builds, level 0 first. Block rows are split across threads.
+class TextureEncoder
+{
+public:
+    TextureEncoder() = delete;
+    ~TextureEncoder() = delete;
+
+    enum class Choice
+    {
+        Auto, // the smallest that keeps the image: BC1 if it's opaque, else BC3
+        BC1,
+        BC3,
+        BC7
+    };
+
+    // one level, rows top first like TextureImage
+    static std::vector<unsigned char> encode(const unsigned char *rgba, int width, int height,
+                                             TextureFormat format);
+
+    // reads `imagePath`, writes TextureContainer::pathFor(imagePath)
+    static bool encodeFile(const std::string &imagePath, Choice choice = Choice::Auto);
+
+    // the format Choice::Auto picks for these pixels
+    static TextureFormat chooseFormat(const TextureImage &image);
+};
@@ -0,0 +1,432 @@
+#define GL_SUBSYSTEM GLSubsystemTextures
+#include "TextureLoader.hpp"
+#include "Texture.hpp"
+#include "GLState.hpp"
+#include "Console.hpp"
+#include "ImageIngest.hpp"
+#include "vendor/stb_image/stb_image.h"
+#include <list>
+#include <deque>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+    struct Job
+    {
+        enum State
+        {
+            Queued,
+            Decoding,
+            Decoded
+        };
+
+        Texture *texture; // null once cancelled
+        std::string path;
+        TextureSampling sampling;
+        // restream(): the texture is already showing, and the new one
+        // starts at this level of the file's chain
+        bool restream = false;
+        int baseLevel = 0;
+        State state = Queued;
+        // a TextureContainer if there is one, otherwise the decoded image
+        // and its chain (empty for MipFilter::Driver)
+        std::unique_ptr<TextureContainer> packed;
+        TextureImage image;
+        MipChain mips;
+        // main thread only: the texture being filled, the level of it being
+        // uploaded (baseLevel higher in the file) and the rows already in
+        unsigned int target = 0;
+        int levels = 1;
+        int level = 0;
+        int uploadedRows = 0;
+    };
+
+    // 2x2 grey checker, like an unloaded texture in most tools
+    const unsigned char Placeholder[2 * 2 * 4] = {
+        96, 96, 96, 255,  160, 160, 160, 255,
+        160, 160, 160, 255,  96, 96, 96, 255,
+    };
+
+    // a strip is one map, copy and glTexSubImage2D; small enough to keep
+    // the budget meaningful, big enough not to be all call overhead
+    const size_t StripBytes = 1u << 20;
+    // orphaned on every use, the ring just spreads the driver's renaming
+    const int PboCount = 3;
+
+    bool s_Running = false;
+    std::vector<std::thread> s_Workers;
+    std::mutex s_Mutex;
+    std::condition_variable s_Wake;
+    bool s_Quit = false;
+    // s_Jobs is only resized on the main thread; workers find theirs
+    // through s_Queue and touch nothing but `packed`, `image`, `mips` and `state`
+    std::list<Job> s_Jobs;
+    std::deque<Job *> s_Queue;
+
+    unsigned int s_Pbos[PboCount] = {};
+    int s_NextPbo = 0;
+    float s_BudgetMs = 2.0f;
+    TextureLoadStats s_Stats;
+
+    bool readFile(const std::string &path, std::vector<unsigned char> &data)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    void discard(Job &job)
+    {
+        if (job.image.pixels)
+            stbi_image_free(job.image.pixels);
+        job.image.pixels = nullptr;
+        job.packed.reset();
+        if (job.target)
+        {
+            GLState::forgetTexture(job.target);
+            GLCall(glDeleteTextures(1, &job.target));
+        }
+        job.target = 0;
+    }
+
+    // level 0 comes from the image, the rest from the chain
+    void levelOf(const Job &job, int level, const unsigned char *&pixels, int &width, int &height)
+    {
+        if (job.packed)
+        {
+            pixels = job.packed->getLevelData(level);
+            width = std::max(1, job.packed->getWidth() >> level);
+            height = std::max(1, job.packed->getHeight() >> level);
+            return;
+        }
+        if (level == 0)
+        {
+            pixels = job.image.pixels;
+            width = job.image.width;
+            height = job.image.height;
+            return;
+        }
+        const MipChain::Level &mip = job.mips.levels[level - 1];
+        pixels = job.mips.levelPixels(level - 1);
+        width = mip.width;
+        height = mip.height;
+    }
+
+    // the next `rows` rows of the level `job` is at, through a PBO;
+    // compressed levels go whole
+    void uploadStrip(Job &job, int rows)
+    {
+        const unsigned char *levelPixels;
+        int width, height;
+        levelOf(job, job.baseLevel + job.level, levelPixels, width, height);
+        TextureFormat format = job.packed ? job.packed->getFormat() : TextureFormat::RGBA8;
+        bool compressed = format != TextureFormat::RGBA8;
+        if (compressed)
+            rows = height;
+        size_t rowBytes = (size_t)width * 4;
+        size_t size = compressed ? job.packed->getLevelSize(job.baseLevel + job.level) : rowBytes * rows;
+        const unsigned char *src = levelPixels + rowBytes * job.uploadedRows;
+
+        GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, s_Pbos[s_NextPbo]);
+        s_NextPbo = (s_NextPbo + 1) % PboCount;
+        GLCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW));
+        void *dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        const void *pixels = nullptr; // offset into the PBO
+        if (dst)
+        {
+            std::memcpy(dst, src, size);
+            GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+        }
+        else
+        {
+            // can't map: straight from client memory, just slower
+            GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            pixels = src;
+        }
+
+        GLState::bindTexture(0, job.target);
+        if (compressed)
+        {
+            GLCall(glCompressedTexSubImage2D(GL_TEXTURE_2D, job.level, 0, 0, width, height,
+                                             TextureContainer::glFormat(format), (GLsizei)size, pixels));
+        }
+        else
+        {
+            GLCall(glTexSubImage2D(GL_TEXTURE_2D, job.level, 0, job.uploadedRows, width, rows, GL_RGBA,
+                                   GL_UNSIGNED_BYTE, pixels));
+        }
+        // every other glTex*Image call expects client memory
+        GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        job.uploadedRows += rows;
+        s_Stats.uploadedBytes += size;
+        if (job.uploadedRows == height)
+        {
+            job.level++;
+            job.uploadedRows = 0;
+        }
+    }
+
+    // levels the CPU filled in; with MipFilter::Driver that is just 0
+    int uploadLevels(const Job &job)
+    {
+        if (job.packed)
+            return job.levels;
+        return 1 + (int)job.mips.levels.size() - job.baseLevel;
+    }
+}
+
+void TextureLoader::init(unsigned int threads)
+{
+    if (GLState::headless() || s_Running)
+        return;
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency() - 1);
+    GLCall(glGenBuffers(PboCount, s_Pbos));
+
+    s_Quit = false;
+    for (unsigned int i = 0; i < threads; ++i)
+        s_Workers.emplace_back(workerLoop);
+    s_Running = true;
+    Console::LOGN("TextureLoader: " + std::to_string(threads) + " decode threads", Color::GREEN);
+}
+
+void TextureLoader::shutdown()
+{
+    if (!s_Running)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        s_Quit = true;
+        s_Queue.clear();
+    }
+    s_Wake.notify_all();
+    for (std::thread &worker : s_Workers)
+        worker.join();
+    s_Workers.clear();
+
+    for (Job &job : s_Jobs)
+    {
+        if (job.texture)
+            Console::LOGN("TextureLoader: " + job.path + " never arrived", Color::YELLOW);
+        discard(job);
+    }
+    s_Jobs.clear();
+    for (unsigned int pbo : s_Pbos)
+        GLState::forgetBuffer(pbo);
+    GLCall(glDeleteBuffers(PboCount, s_Pbos));
+    s_Running = false;
+}
+
+Texture *TextureLoader::load(const std::string &path, const TextureSampling &sampling)
+{
+    if (!s_Running)
+        return new Texture(path, sampling);
+
+    Texture *texture = new Texture(path, Placeholder, 2, 2, sampling);
+    s_Jobs.push_back(Job());
+    Job &job = s_Jobs.back();
+    job.texture = texture;
+    job.path = path;
+    job.sampling = sampling;
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        s_Queue.push_back(&job);
+    }
+    s_Wake.notify_one();
+    return texture;
+}
+
+bool TextureLoader::restream(Texture *texture, int baseLevel)
+{
+    if (!s_Running || !texture->isResident() || texture->m_StreamLevel >= 0)
+        return false;
+    // MipFilter::Driver has no levels below 0 to start from
+    if (baseLevel > 0 && texture->getSampling().mipFilter == MipFilter::Driver)
+        return false;
+
+    s_Jobs.push_back(Job());
+    Job &job = s_Jobs.back();
+    job.texture = texture;
+    job.path = texture->m_filePath;
+    job.sampling = texture->getSampling();
+    job.restream = true;
+    job.baseLevel = baseLevel;
+    texture->m_StreamLevel = baseLevel;
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        s_Queue.push_back(&job);
+    }
+    s_Wake.notify_one();
+    return true;
+}
+
+bool TextureLoader::running()
+{
+    return s_Running;
+}
+
+void TextureLoader::cancel(const Texture *texture)
+{
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    for (auto it = s_Jobs.begin(); it != s_Jobs.end(); ++it)
+    {
+        if (it->texture != texture)
+            continue;
+        if (it->state == Job::Queued)
+        {
+            s_Queue.erase(std::find(s_Queue.begin(), s_Queue.end(), &*it));
+            s_Jobs.erase(it);
+        }
+        else
+        {
+            // a worker may have it; update() cleans up once it's decoded
+            it->texture = nullptr;
+        }
+        return;
+    }
+}
+
+void TextureLoader::update()
+{
+    if (!s_Running)
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+    auto elapsedMs = [start] {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    s_Stats.uploadedBytes = 0;
+    bool progressed = false;
+
+    for (auto it = s_Jobs.begin(); it != s_Jobs.end();)
+    {
+        Job &job = *it;
+        {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            if (job.state != Job::Decoded)
+            {
+                ++it;
+                continue;
+            }
+        }
+
+        bool loaded = job.packed || job.image.pixels;
+        if (job.texture && !loaded)
+        {
+            s_Stats.failed++;
+            if (job.restream)
+                job.texture->m_StreamLevel = -1;
+            else
+                job.texture->m_Failed = true;
+            Console::LOGN("TextureLoader: can't load " + job.path + ", keeping " +
+                              (job.restream ? "the levels it has" : "the placeholder"),
+                          Color::RED);
+        }
+        if (job.texture && loaded)
+        {
+            const unsigned char *pixels;
+            int width, height;
+            levelOf(job, 0, pixels, width, height);
+            TextureFormat format = job.packed ? job.packed->getFormat() : TextureFormat::RGBA8;
+            if (!job.target)
+            {
+                int levels = 1;
+                if (job.sampling.mipmaps)
+                    levels = job.packed ? job.packed->getLevelCount() : MipGenerator::levelCount(width, height);
+                job.baseLevel = std::min(job.baseLevel, levels - 1);
+                job.levels = levels - job.baseLevel;
+                int baseWidth, baseHeight;
+                levelOf(job, job.baseLevel, pixels, baseWidth, baseHeight);
+                job.target = Texture::create(baseWidth, baseHeight, job.levels, nullptr, job.sampling, format);
+            }
+
+            while (job.level < uploadLevels(job) && (!progressed || elapsedMs() < s_BudgetMs))
+            {
+                int levelWidth, levelHeight;
+                levelOf(job, job.baseLevel + job.level, pixels, levelWidth, levelHeight);
+                int rows = (int)std::max<size_t>(1, StripBytes / ((size_t)levelWidth * 4));
+                uploadStrip(job, std::min(rows, levelHeight - job.uploadedRows));
+                progressed = true;
+            }
+            if (job.level < uploadLevels(job))
+                break; // out of budget, the rest next frame
+
+            if (job.levels > uploadLevels(job))
+            {
+                GLState::bindTexture(0, job.target);
+                GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+            }
+            job.texture->adopt(job.target, width, height, job.levels, format, job.baseLevel);
+            job.target = 0;
+            if (!job.restream)
+                s_Stats.loaded++;
+        }
+
+        discard(job);
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        it = s_Jobs.erase(it);
+    }
+
+    s_Stats.pending = (unsigned int)s_Jobs.size();
+    s_Stats.uploadMs = elapsedMs();
+}
+
+void TextureLoader::workerLoop()
+{
+    std::vector<unsigned char> data;
+    for (;;)
+    {
+        Job *job;
+        {
+            std::unique_lock<std::mutex> lock(s_Mutex);
+            s_Wake.wait(lock, [] { return s_Quit || !s_Queue.empty(); });
+            if (s_Quit)
+                break;
+            job = s_Queue.front();
+            s_Queue.pop_front();
+            job->state = Job::Decoding;
+        }
+
+        // the job's path and sampling don't change once queued
+        std::unique_ptr<TextureContainer> packed = TextureContainer::openFor(job->path);
+        TextureImage image;
+        MipChain mips;
+        if (!packed && readFile(job->path, data))
+            image = ImageIngest::decode(data.data(), data.size());
+        if (image.pixels && job->sampling.mipmaps)
+            MipGenerator::buildCached(job->path, image, job->sampling.mipFilter, mips);
+
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        job->packed = std::move(packed);
+        job->image = image;
+        job->mips = std::move(mips);
+        job->state = Job::Decoded;
+    }
+}
+
+void TextureLoader::setBudget(float milliseconds)
+{
+    s_BudgetMs = milliseconds;
+}
+
+float TextureLoader::getBudget()
+{
+    return s_BudgetMs;
+}
+
+const TextureLoadStats &TextureLoader::getStats()
+{
+    return s_Stats;
+}
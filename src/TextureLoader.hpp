@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include "Texture.hpp"
+
+struct TextureLoadStats
+{
+    unsigned int pending = 0;    // decoding or waiting for upload
+    unsigned int loaded = 0;     // uploaded and swapped in, total
+    unsigned int failed = 0;     // couldn't be read, the placeholder stays
+    size_t uploadedBytes = 0;    // last update()
+    float uploadMs = 0.0f;       // last update()
+};
+
+// Loads image files without stalling a frame. load() hands back a Texture
+// right away, showing a small placeholder; a pool of threads reads and
+// decodes the file and builds its mip chain (MipGenerator), or maps its
+// TextureContainer when there is a current one, and update()
+// on the main thread copies every level through a ring of pixel buffer
+// objects into a texture of their own, a strip of rows at a time,
+// stopping once the frame's budget is spent. The
+// finished texture then replaces the placeholder inside the same Texture,
+// so whoever holds it never notices.
+//
+// Before init(), and when headless, load() just loads the file.
+class TextureLoader
+{
+public:
+    TextureLoader() = delete;
+    ~TextureLoader() = delete;
+
+    // main thread with the context current; threads: 0 = one fewer than
+    // the hardware threads, at least one
+    static void init(unsigned int threads = 0);
+    // after every Texture it loaded is gone or resident, before the
+    // context is destroyed
+    static void shutdown();
+
+    static Texture *load(const std::string &path, const TextureSampling &sampling = TextureSampling());
+    // reads a resident texture's file again and swaps in a texture that
+    // starts `baseLevel` levels down its chain (TextureResidency); the old
+    // one keeps drawing meanwhile. False if one is in flight already, or
+    // the loader isn't running.
+    static bool restream(Texture *texture, int baseLevel);
+    static bool running();
+
+    // main thread, at the frame boundary
+    static void update();
+
+    // upload time per update(); at least one strip goes through regardless
+    static void setBudget(float milliseconds);
+    static float getBudget();
+
+    static const TextureLoadStats &getStats();
+
+private:
+    friend class Texture;
+    // a Texture deleted before its file arrived, or while restreaming
+    static void cancel(const Texture *texture);
+    static void workerLoop();
+};
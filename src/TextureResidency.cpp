@@ -0,0 +1,186 @@
+#include "TextureResidency.hpp"
+#include "Texture.hpp"
+#include "TextureLoader.hpp"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // the tail an evicted texture keeps: its levels at most this wide
+    const int MinResidentSize = 64;
+    // a screen size older than this no longer says anything
+    const uint32_t ScreenSizeFrames = 30;
+    // restreams started per update(), so a budget change doesn't queue
+    // every texture at once
+    const unsigned int MaxStreamsPerUpdate = 4;
+
+    std::vector<Texture *> s_Textures;
+    size_t s_Budget = 0;
+    uint32_t s_Frame = 1;
+    TextureResidencyStats s_Stats;
+
+    struct Plan
+    {
+        Texture *texture;
+        int fullLevels;
+        int maxBase; // deepest start that keeps MinResidentSize
+        int wanted;  // what its screen size calls for
+        int target;
+    };
+    std::vector<Plan> s_Plans;
+
+    size_t bytesAt(const Texture &texture, int fullLevels, int base)
+    {
+        size_t bytes = 0;
+        for (int level = base; level < fullLevels; ++level)
+        {
+            bytes += TextureContainer::levelSize(texture.getFormat(), std::max(1, texture.getWidth() >> level),
+                                                 std::max(1, texture.getHeight() >> level));
+        }
+        return bytes;
+    }
+}
+
+void TextureResidency::add(Texture *texture)
+{
+    s_Textures.push_back(texture);
+}
+
+void TextureResidency::remove(Texture *texture)
+{
+    auto it = std::find(s_Textures.begin(), s_Textures.end(), texture);
+    if (it == s_Textures.end())
+        return;
+    *it = s_Textures.back();
+    s_Textures.pop_back();
+}
+
+void TextureResidency::setBudget(size_t bytes)
+{
+    s_Budget = bytes;
+}
+
+size_t TextureResidency::getBudget()
+{
+    return s_Budget;
+}
+
+void TextureResidency::requestScreenSize(const Texture *texture, float pixels)
+{
+    if (texture->m_ScreenSizeFrame != s_Frame)
+    {
+        texture->m_ScreenSizeFrame = s_Frame;
+        texture->m_ScreenSize = 0.0f;
+    }
+    texture->m_ScreenSize = std::max(texture->m_ScreenSize, pixels);
+    texture->m_LastUsed = s_Frame;
+}
+
+uint32_t TextureResidency::frame()
+{
+    return s_Frame;
+}
+
+const TextureResidencyStats &TextureResidency::getStats()
+{
+    return s_Stats;
+}
+
+void TextureResidency::update()
+{
+    s_Stats.textures = (unsigned int)s_Textures.size();
+    s_Stats.budgetBytes = s_Budget;
+    s_Stats.residentBytes = 0;
+    s_Stats.reduced = 0;
+    s_Stats.streaming = 0;
+
+    // what everything would take at the level it wants
+    size_t planned = 0;
+    s_Plans.clear();
+    for (Texture *texture : s_Textures)
+    {
+        size_t bytes = texture->getBytes();
+        s_Stats.residentBytes += bytes;
+        s_Stats.reduced += texture->m_BaseLevel > 0;
+        s_Stats.streaming += texture->m_StreamLevel >= 0;
+
+        int fullLevels = texture->m_BaseLevel + texture->m_Levels;
+        bool streamable = TextureLoader::running() && !texture->m_Pinned && texture->isResident() &&
+                          texture->m_StreamLevel < 0 &&
+                          texture->getTarget() == GL_TEXTURE_2D && texture->getSampling().mipmaps &&
+                          texture->getSampling().mipFilter != MipFilter::Driver;
+        if (!streamable || fullLevels <= 1)
+        {
+            planned += texture->m_StreamLevel >= 0 ? bytesAt(*texture, fullLevels, texture->m_StreamLevel) : bytes;
+            continue;
+        }
+
+        int maxBase = 0;
+        while (maxBase + 1 < fullLevels && std::max(texture->getWidth() >> (maxBase + 1),
+                                                    texture->getHeight() >> (maxBase + 1)) >= MinResidentSize)
+            maxBase++;
+
+        // the level whose texels are about one per pixel; no size means full
+        int wanted = 0;
+        if (s_Frame - texture->m_ScreenSizeFrame < ScreenSizeFrames && texture->m_ScreenSize > 0.0f)
+        {
+            float ratio = (float)texture->getWidth() / texture->m_ScreenSize;
+            wanted = std::min(maxBase, std::max(0, (int)std::floor(std::log2(ratio))));
+        }
+        // without pressure nothing gives up detail, it only gets it back
+        int target = std::min(wanted, texture->m_BaseLevel);
+        s_Plans.push_back({texture, fullLevels, maxBase, wanted, target});
+        planned += bytesAt(*texture, fullLevels, target);
+    }
+
+    if (s_Budget > 0 && planned > s_Budget)
+    {
+        // under pressure: start from what the screen needs, then strip the
+        // least recently bound textures down to their tails, one at a time.
+        // Stable, so ties go the same way every frame instead of trading
+        // levels back and forth.
+        std::stable_sort(s_Plans.begin(), s_Plans.end(),
+                         [](const Plan &a, const Plan &b) { return a.texture->m_LastUsed < b.texture->m_LastUsed; });
+        for (Plan &plan : s_Plans)
+        {
+            planned -= bytesAt(*plan.texture, plan.fullLevels, plan.target) -
+                       bytesAt(*plan.texture, plan.fullLevels, plan.wanted);
+            plan.target = plan.wanted;
+        }
+        for (Plan &plan : s_Plans)
+        {
+            while (planned > s_Budget && plan.target < plan.maxBase)
+            {
+                planned -= bytesAt(*plan.texture, plan.fullLevels, plan.target) -
+                           bytesAt(*plan.texture, plan.fullLevels, plan.target + 1);
+                plan.target++;
+            }
+        }
+    }
+
+    // drops free memory, so they go first; restores most recently bound first
+    std::stable_sort(s_Plans.begin(), s_Plans.end(), [](const Plan &a, const Plan &b) {
+        bool dropA = a.target > a.texture->m_BaseLevel, dropB = b.target > b.texture->m_BaseLevel;
+        if (dropA != dropB)
+            return dropA;
+        return a.texture->m_LastUsed > b.texture->m_LastUsed;
+    });
+    unsigned int started = 0;
+    for (const Plan &plan : s_Plans)
+    {
+        if (started == MaxStreamsPerUpdate)
+            break;
+        int base = plan.texture->m_BaseLevel;
+        if (plan.target == base || !TextureLoader::restream(plan.texture, plan.target))
+            continue;
+        started++;
+        s_Stats.streaming++;
+        if (plan.target > base)
+            s_Stats.dropped++;
+        else
+            s_Stats.restored++;
+    }
+
+    s_Frame++;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+class Texture;
+
+struct TextureResidencyStats
+{
+    unsigned int textures = 0;    // alive
+    size_t residentBytes = 0;     // what they take on the GPU now
+    size_t budgetBytes = 0;       // 0: no budget
+    unsigned int reduced = 0;     // textures missing top levels
+    unsigned int streaming = 0;   // restreams in flight
+    unsigned int dropped = 0;     // restreams to fewer levels, total
+    unsigned int restored = 0;    // restreams to more levels, total
+};
+
+// Keeps the textures' GPU memory under a budget. Every Texture is counted
+// from construction to destruction; Bind() stamps it with the frame, and
+// whoever draws with it can say how big it appears on screen.
+//
+// Once per frame update() works out the level each texture should start
+// at: the one its screen size calls for, or the full image when nobody
+// said. While that doesn't fit the budget, the least recently bound
+// textures give up their top levels first, down to a small tail that
+// always stays (a draw never finds nothing). Changes go through
+// TextureLoader::restream, so the old texture draws until the new one is
+// in, and memory is only actually freed at that point.
+//
+// Only 2D textures loaded from a file, with a CPU-built chain or a
+// TextureContainer, stream; atlas pages, placeholders and
+// MipFilter::Driver ones are counted but pinned. Without a running
+// TextureLoader (headless) nothing streams either.
+class TextureResidency
+{
+public:
+    TextureResidency() = delete;
+    ~TextureResidency() = delete;
+
+    // bytes, 0 for no budget (the default): nothing is dropped, and screen
+    // sizes are only used to bring back what was
+    static void setBudget(size_t bytes);
+    static size_t getBudget();
+
+    // this frame, `texture`'s full image spans about `pixels` on screen
+    // (the largest of several calls counts). Also counts as a use, for
+    // textures drawn without a Bind() (bindless handles).
+    static void requestScreenSize(const Texture *texture, float pixels);
+
+    // main thread, at the frame boundary after TextureLoader::update()
+    static void update();
+
+    static uint32_t frame();
+    static const TextureResidencyStats &getStats();
+
+private:
+    friend class Texture;
+    static void add(Texture *texture);
+    static void remove(Texture *texture);
+};
@@ -0,0 +1,122 @@
+#define GL_SUBSYSTEM GLSubsystemTextures
+#include "TextureTable.hpp"
+#include "TextureResidency.hpp"
+#include "ShaderVariants.hpp"
+#include "GLExtensions.hpp"
+#include "GLState.hpp"
+#include "Console.hpp"
+
+TextureTable::TextureTable(const AtlasSettings &fallback)
+    : m_Bindless(GLExtensions::ARB_bindless_texture && !GLState::headless())
+{
+    if (m_Bindless)
+    {
+        m_HandleBuffer = new UniformBuffer(MaxTextures * sizeof(uint64_t));
+        m_Handles.assign(MaxTextures, 0);
+    }
+    else
+    {
+        AtlasSettings settings = fallback;
+        settings.array = true;
+        m_Atlas = new TextureAtlas(settings);
+    }
+}
+
+TextureTable::~TextureTable()
+{
+    // a handle has to stop being resident before its texture goes
+    for (size_t i = 0; i < m_Textures.size(); ++i)
+    {
+        const Texture *texture = ResourceCache::get(m_Textures[i]);
+        if (m_HandleNames[i] && m_HandleNames[i] == texture->GetRendererID())
+        {
+            GLCall(GLExtensions::MakeTextureHandleNonResident(m_Handles[i]));
+        }
+        ResourceCache::release(m_Textures[i]);
+    }
+    delete m_HandleBuffer;
+    delete m_Atlas;
+}
+
+TextureTable::TextureId TextureTable::add(const std::string &path)
+{
+    std::string key = ResourceCache::canonicalPath(path);
+    auto known = m_Ids.find(key);
+    if (known != m_Ids.end())
+        return known->second;
+    if (m_Regions.size() == MaxTextures)
+    {
+        Console::LOGN("TextureTable: full, " + path + " shares the last slot", Color::RED);
+        return MaxTextures - 1;
+    }
+
+    TextureId id = (TextureId)m_Regions.size();
+    AtlasRegion region;
+    if (m_Bindless)
+    {
+        region.layer = (float)id;
+        m_Textures.push_back(ResourceCache::loadTexture(path));
+        m_HandleNames.push_back(0);
+    }
+    else
+    {
+        m_Atlas->add(path);
+        m_AtlasDirty = true;
+    }
+    m_Regions.push_back(region);
+    m_Ids.emplace(key, id);
+    return id;
+}
+
+void TextureTable::update()
+{
+    if (!m_Bindless)
+    {
+        if (!m_AtlasDirty)
+            return;
+        m_Atlas->build();
+        for (size_t i = 0; i < m_Regions.size(); ++i)
+            m_Regions[i] = m_Atlas->getRegion((TextureAtlas::ImageId)i);
+        m_AtlasDirty = false;
+        return;
+    }
+
+    // the placeholder's handle went with the placeholder, likewise a
+    // texture TextureResidency replaced; the new one needs its own
+    bool changed = false;
+    for (size_t i = 0; i < m_Textures.size(); ++i)
+    {
+        unsigned int name = ResourceCache::get(m_Textures[i])->GetRendererID();
+        if (name == m_HandleNames[i])
+            continue;
+        GLuint64 handle = GLExtensions::GetTextureHandle(name);
+        GLCall(GLExtensions::MakeTextureHandleResident(handle));
+        m_Handles[i] = handle;
+        m_HandleNames[i] = name;
+        changed = true;
+    }
+    if (changed)
+        m_HandleBuffer->setData(m_Handles.data(), (unsigned int)(m_Handles.size() * sizeof(uint64_t)));
+}
+
+void TextureTable::bind() const
+{
+    if (m_HandleBuffer)
+        m_HandleBuffer->bindBase(TextureHandlesBinding);
+}
+
+void TextureTable::requestScreenSize(TextureId id, float pixels) const
+{
+    if (m_Bindless)
+        TextureResidency::requestScreenSize(ResourceCache::get(m_Textures[id]), pixels);
+}
+
+uint32_t TextureTable::getShaderFeatures() const
+{
+    return m_Bindless ? ShaderAtlas | ShaderBindless : ShaderAtlas;
+}
+
+const Texture *TextureTable::getTexture() const
+{
+    return m_Atlas ? m_Atlas->getTexture() : nullptr;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "TextureAtlas.hpp"
+#include "UniformBuffer.hpp"
+#include "ResourceCache.hpp"
+
+// A set of images that instances pick from by index, so objects with
+// different images go out in one draw with no bind between them.
+//
+// With ARB_bindless_texture every image is a texture of its own (from
+// ResourceCache, shared with anyone else drawing that file) whose handle
+// sits in the TextureHandles block;
+// the ATLAS instance attributes carry the slot, and the BINDLESS variant
+// of Mesh.shader turns it back into a sampler. Without it the images are
+// packed into a TextureAtlas array instead, and the attributes carry the
+// atlas region: one bind per frame for all of them.
+//
+// Either way draws read getRegion() per instance and use the features
+// from getShaderFeatures() and the texture from getTexture().
+class TextureTable
+{
+public:
+    using TextureId = uint32_t;
+
+    // handles in TextureHandles, two per uvec4 (4 KB)
+    static const unsigned int MaxTextures = 512;
+
+    // `fallback` shapes the atlas when there is no bindless
+    explicit TextureTable(const AtlasSettings &fallback = AtlasSettings());
+    ~TextureTable();
+
+    TextureTable(const TextureTable&) = delete;
+    TextureTable& operator=(const TextureTable&) = delete;
+
+    // the same file again is the same id; MaxTextures at most, past that
+    // the last one is handed back
+    TextureId add(const std::string &path);
+
+    // frame boundary, before drawing: picks up textures TextureLoader or
+    // TextureResidency swapped, or repacks the atlas after add()
+    void update();
+    // puts the handle block on TextureHandlesBinding (bindless only)
+    void bind() const;
+
+    bool isBindless() const { return m_Bindless; }
+    uint32_t getShaderFeatures() const;
+    const AtlasRegion &getRegion(TextureId id) const { return m_Regions[id]; }
+    // TextureResidency::requestScreenSize for the image's own texture;
+    // atlas pages are pinned, so nothing to do without bindless
+    void requestScreenSize(TextureId id, float pixels) const;
+    // what packets bind: the atlas, or null with bindless
+    const Texture *getTexture() const;
+    size_t size() const { return m_Regions.size(); }
+
+private:
+    bool m_Bindless;
+    std::vector<AtlasRegion> m_Regions;
+    std::unordered_map<std::string, TextureId> m_Ids; // by canonical path
+
+    // bindless: one texture, and the GL name its handle was taken from
+    std::vector<TextureHandle> m_Textures;
+    std::vector<unsigned int> m_HandleNames;
+    std::vector<uint64_t> m_Handles;
+    UniformBuffer *m_HandleBuffer = nullptr;
+
+    // fallback
+    TextureAtlas *m_Atlas = nullptr;
+    bool m_AtlasDirty = false;
+};
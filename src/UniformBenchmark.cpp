@@ -0,0 +1,98 @@
+#include "UniformBenchmark.hpp"
+#include "Shader.hpp"
+#include "ShaderVariants.hpp"
+#include "GLState.hpp"
+#include "Console.hpp"
+#include <unordered_map>
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+    // the lookup Shader used to do, value cache and counters included
+    class LegacyUniforms
+    {
+    public:
+        void set(const std::string &name, const void *data, size_t size)
+        {
+            int location = getLocation(name);
+            if (location == -1)
+                return;
+            auto it = m_Values.find(location);
+            if (it != m_Values.end() && std::memcmp(it->second.data(), data, size) == 0)
+            {
+                GLState::countUniform(false);
+                return;
+            }
+            std::memcpy(m_Values[location].data(), data, size);
+            GLState::countUniform(true);
+        }
+
+    private:
+        std::unordered_map<std::string, int> m_Locations;
+        std::unordered_map<int, std::array<unsigned char, 64>> m_Values;
+
+        int getLocation(const std::string &name)
+        {
+            if (m_Locations.find(name) != m_Locations.end())
+                return m_Locations[name];
+            int location = (int)m_Locations.size();
+            m_Locations[name] = location;
+            return location;
+        }
+    };
+
+    template <typename F>
+    double nanosecondsPerCall(unsigned int iterations, F &&body)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < iterations; ++i)
+            body(i);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        // three uniforms per iteration
+        return seconds * 1e9 / ((double)iterations * 3.0);
+    }
+}
+
+void UniformBenchmark::run(unsigned int iterations)
+{
+    if (!GLState::headless())
+    {
+        Console::LOGN("UniformBenchmark: needs GLState headless", Color::RED);
+        return;
+    }
+    if (iterations == 0)
+        iterations = 1;
+
+    Shader shader("res/shaders/Mesh.shader", ShaderVariants::defines(ShaderTextured));
+    LegacyUniforms legacy;
+    glm::mat4 model(1.0f);
+    glm::vec4 color(1.0f, 0.5f, 0.25f, 1.0f);
+    int slot = 0;
+
+    double legacyNs = nanosecondsPerCall(iterations, [&](unsigned int i) {
+        model[3][0] = (float)i;
+        legacy.set("u_Model", &model[0][0], sizeof(model));
+        legacy.set("u_Color", &color[0], sizeof(color));
+        legacy.set("u_Texture", &slot, sizeof(slot));
+    });
+    double nameNs = nanosecondsPerCall(iterations, [&](unsigned int i) {
+        model[3][0] = (float)i;
+        shader.setUniformMat4f("u_Model", model);
+        shader.setUniform4f("u_Color", color.r, color.g, color.b, color.a);
+        shader.setUniform1i("u_Texture", slot);
+    });
+    double handleNs = nanosecondsPerCall(iterations, [&](unsigned int i) {
+        model[3][0] = (float)i;
+        shader.setUniformMat4f(Uniforms::Model, model);
+        shader.setUniform4f(Uniforms::Color, color.r, color.g, color.b, color.a);
+        shader.setUniform1i(Uniforms::Texture, slot);
+    });
+
+    Console::LOGN("[UniformBenchmark] " + std::to_string(iterations) + " x 3 uniforms, " +
+                      std::to_string(shader.getUniformCount()) + " in the table",
+                  Color::GREEN);
+    Console::LOGN("  legacy   " + std::to_string(legacyNs) + " ns / call");
+    Console::LOGN("  by name  " + std::to_string(nameNs) + " ns / call (" + std::to_string(legacyNs / nameNs) + "x)");
+    Console::LOGN("  handle   " + std::to_string(handleNs) + " ns / call (" + std::to_string(legacyNs / handleNs) + "x)");
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// Times what drawTriangle() does per object (u_Model, u_Color,
+// u_Texture, with the matrix changing every time) three ways and prints
+// nanoseconds per call:
+//   legacy    std::string per call, then find + operator[] on an
+//             unordered_map<string, int> and an unordered_map<int, value>
+//             (what Shader did before the uniform table)
+//   by name   Shader's std::string overloads: hashed per call
+//   handle    Shader's UniformHandle overloads: hashed at compile time
+// Needs GLState headless (no GL work, only the CPU side is measured).
+class UniformBenchmark
+{
+public:
+    UniformBenchmark() = delete;
+    ~UniformBenchmark() = delete;
+
+    static void run(unsigned int iterations);
+};
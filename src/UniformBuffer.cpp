@@ -0,0 +1,63 @@
+#define GL_SUBSYSTEM GLSubsystemBuffers
+#include "UniformBuffer.hpp"
+#include "Renderer.hpp"
+#include "GLState.hpp"
+#include <cstring>
+
+namespace
+{
+    const unsigned int MaxBindings = 16;
+    const UniformBuffer *s_Bound[MaxBindings] = {};
+}
+
+UniformBuffer::UniformBuffer(unsigned int size) : m_Size(size)
+{
+    if (GLState::headless())
+    {
+        m_RendererId = GLState::headlessName();
+        m_Cpu.assign(size, 0);
+        return;
+    }
+    GLCall(glGenBuffers(1, &m_RendererId));
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, m_RendererId);
+    GLCall(glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW));
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    GLState::forgetBuffer(m_RendererId);
+    for (const UniformBuffer *&bound : s_Bound)
+        if (bound == this)
+            bound = nullptr;
+    if (!GLState::headless())
+    {
+        GLCall(glDeleteBuffers(1, &m_RendererId));
+    }
+}
+
+void UniformBuffer::setData(const void *data, unsigned int size)
+{
+    ASSERT(size <= m_Size);
+    if (GLState::headless())
+    {
+        std::memcpy(m_Cpu.data(), data, size);
+        return;
+    }
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, m_RendererId);
+    GLCall(glBufferData(GL_UNIFORM_BUFFER, m_Size, nullptr, GL_DYNAMIC_DRAW));
+    GLCall(glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data));
+}
+
+void UniformBuffer::bindBase(unsigned int binding) const
+{
+    if (binding < MaxBindings)
+        s_Bound[binding] = this;
+    if (GLState::headless())
+        return;
+    GLCall(glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_RendererId));
+}
+
+const UniformBuffer *UniformBuffer::boundAt(unsigned int binding)
+{
+    return binding < MaxBindings ? s_Bound[binding] : nullptr;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include "vendor/glm/glm.hpp"
+
+// Binding points shared by every program. Shader wires up blocks with
+// these names after linking, so .shader files only declare the block.
+enum UniformBlockBinding : unsigned int
+{
+    FrameBlockBinding = 0,    // "FrameData"
+    TextureHandlesBinding = 1 // "TextureHandles", see TextureTable
+};
+
+// Mirrors the FrameData block in the shaders, std140 layout:
+// mat4 = 4 x vec4 columns (16-byte aligned), scalars pack at 4 bytes,
+// and the block size rounds up to a multiple of 16.
+struct FrameUniforms
+{
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::mat4 viewProj;
+    float time;
+    float brightness;
+    float pad[2];
+};
+static_assert(offsetof(FrameUniforms, view) == 0, "std140: view");
+static_assert(offsetof(FrameUniforms, proj) == 64, "std140: proj");
+static_assert(offsetof(FrameUniforms, viewProj) == 128, "std140: viewProj");
+static_assert(offsetof(FrameUniforms, time) == 192, "std140: time");
+static_assert(offsetof(FrameUniforms, brightness) == 196, "std140: brightness");
+static_assert(sizeof(FrameUniforms) % 16 == 0, "std140: block size must round to vec4");
+static_assert(sizeof(glm::mat4) == 64, "std140: mat4 must be 16 tightly packed floats");
+
+class UniformBuffer
+{
+private:
+    unsigned int m_RendererId;
+    unsigned int m_Size;
+    std::vector<unsigned char> m_Cpu; // headless: the contents
+public:
+    UniformBuffer(unsigned int size);
+    ~UniformBuffer();
+
+    // orphans and re-uploads the whole block
+    void setData(const void* data, unsigned int size);
+    // glBindBufferBase(GL_UNIFORM_BUFFER, binding)
+    void bindBase(unsigned int binding) const;
+
+    unsigned int GetRendererID() const { return m_RendererId; }
+    // headless only (null otherwise), for CPU backends
+    const unsigned char* getCpuData() const { return m_Cpu.empty() ? nullptr : m_Cpu.data(); }
+    // last buffer bindBase() put on `binding`
+    static const UniformBuffer* boundAt(unsigned int binding);
+};
@@ -1,46 +1,158 @@
+#define GL_SUBSYSTEM GLSubsystemBuffers
 #include "VertexArray.hpp"
 #include <glad/glad.h>
 #include "Renderer.hpp"
+#include "GLState.hpp"
 VertexArray::VertexArray()
 {
-   GLCall(glGenVertexArrays(1, &m_RendererID));
+   if (GLState::headless())
+      m_RendererID = GLState::headlessName();
+   else
+   {
+      GLCall(glGenVertexArrays(1, &m_RendererID));
+   }
 }
 
 VertexArray::~VertexArray()
 {
-   GLCall(glDeleteVertexArrays(1, &m_RendererID));
+   GLState::forgetVertexArray(m_RendererID);
+   if (!GLState::headless())
+   {
+      GLCall(glDeleteVertexArrays(1, &m_RendererID));
+   }
 }
 
 void VertexArray::Bind() const
 {
-   GLCall(glBindVertexArray(m_RendererID));
+   GLState::bindVertexArray(m_RendererID);
 }
 
 void VertexArray::UnBind() const
 {
-   GLCall(glBindVertexArray(0));
+   GLState::bindVertexArray(0);
+}
+
+void VertexArray::addBuffer(const VertexBuffer &vb, const VertexBufferLayout &layout,
+                            unsigned int firstIndex, unsigned int divisor)
+{
+   Bind();
+   vb.Bind();
+
+   setAttribPointers(layout, firstIndex, 0);
+   enableAttribs(layout, firstIndex, divisor);
+
+   addBinding({&vb, nullptr, layout, firstIndex, divisor, vb.GetRendererID()});
 }
 
-void VertexArray::addBuffer(const VertexBuffer &vb, const VertexBufferLayout &layout)
+void VertexArray::addBuffer(const StreamBuffer &sb, const VertexBufferLayout &layout,
+                            unsigned int firstIndex, unsigned int divisor)
 {
-   GLCall(Bind());
-   GLCall(vb.Bind());
+   Bind();
+   sb.Bind();
+
+   setAttribPointers(layout, firstIndex, m_BaseInstance * layout.getStride());
+   enableAttribs(layout, firstIndex, divisor);
 
-   const auto &elements = layout.getElements();
-   unsigned int offset = 0;
-   unsigned int index = 0;
-   for (const auto &element : elements)
+   addBinding({nullptr, &sb, layout, firstIndex, divisor, sb.GetRendererID()});
+}
+
+void VertexArray::addBinding(const Binding &binding)
+{
+   ASSERT(m_BindingCount < VertexBufferLayout::MaxElements);
+   m_Bindings[m_BindingCount++] = binding;
+}
+
+void VertexArray::enableAttribs(const VertexBufferLayout &layout, unsigned int firstIndex,
+                                unsigned int divisor)
+{
+   if (GLState::headless())
+      return;
+   for (unsigned int i = 0; i < layout.getCount(); ++i)
    {
+      GLCall(glEnableVertexAttribArray(firstIndex + i));
+      if (divisor)
+      {
+         GLCall(glVertexAttribDivisor(firstIndex + i, divisor));
+      }
+   }
+}
 
-      GLCall(glEnableVertexAttribArray(index));
+void VertexArray::setAttribPointers(const VertexBufferLayout &layout, unsigned int firstIndex,
+                                    unsigned int baseOffset) const
+{
+   if (GLState::headless())
+      return;
+   unsigned int index = firstIndex;
+   for (const VertexBufferElement &element : layout)
+   {
       GLCall(glVertexAttribPointer(
                  index,
                  element.count,
                  element.type,
                  element.normalized,
                  layout.getStride(),
-                 (const void *)(uintptr_t)offset);
-             offset += element.count * VertexBufferElement::getSizeOfType(element.type));
+                 (const void *)(uintptr_t)(baseOffset + element.offset)));
       index++;
    }
 }
+
+void VertexArray::setBaseInstance(unsigned int base) const
+{
+   bool stale = base != m_BaseInstance;
+   for (unsigned int b = 0; b < m_BindingCount; ++b)
+   {
+      const Binding &binding = m_Bindings[b];
+      if (!binding.divisor)
+         continue;
+      unsigned int id = binding.vb ? binding.vb->GetRendererID() : binding.sb->GetRendererID();
+      stale |= id != binding.boundId;
+   }
+   if (!stale)
+      return;
+
+   for (unsigned int b = 0; b < m_BindingCount; ++b)
+   {
+      const Binding &binding = m_Bindings[b];
+      if (!binding.divisor)
+         continue;
+      if (binding.vb)
+         binding.vb->Bind();
+      else
+         binding.sb->Bind();
+      binding.boundId = binding.vb ? binding.vb->GetRendererID() : binding.sb->GetRendererID();
+      setAttribPointers(binding.layout, binding.firstIndex, base * binding.layout.getStride());
+   }
+   m_BaseInstance = base;
+}
+
+unsigned int VertexArray::getInstanceStride() const
+{
+   unsigned int stride = 0;
+   for (unsigned int b = 0; b < m_BindingCount; ++b)
+      if (m_Bindings[b].divisor)
+         stride += m_Bindings[b].layout.getStride();
+   return stride;
+}
+
+bool VertexArray::getAttribute(unsigned int location, AttributeSource &out) const
+{
+   for (unsigned int b = 0; b < m_BindingCount; ++b)
+   {
+      const Binding &binding = m_Bindings[b];
+      const VertexBufferLayout &layout = binding.layout;
+      if (location < binding.firstIndex || location >= binding.firstIndex + layout.getCount())
+         continue;
+
+      const unsigned char *data = binding.vb ? binding.vb->getCpuData() : binding.sb->getCpuData();
+      if (!data)
+         return false;
+
+      const VertexBufferElement &element = layout[location - binding.firstIndex];
+      out.data = data + element.offset;
+      out.stride = layout.getStride();
+      out.count = element.count;
+      out.divisor = binding.divisor;
+      return true;
+   }
+   return false;
+}
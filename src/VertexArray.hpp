@@ -2,18 +2,65 @@
 
 #include "VertexBuffer.hpp"
 #include "VertexBufferLayout.hpp"
+#include "StreamBuffer.hpp"
 
 class VertexArray
 {
 private:
     unsigned int m_RendererID;
 
+    // every addBuffer(), kept so the base instance of the per-instance
+    // streams can be moved without GL 4.2 base-instance draws, and so CPU
+    // backends can find the attributes. Each takes at least one of the
+    // MaxElements locations, so a fixed array holds them all.
+    struct Binding
+    {
+        const VertexBuffer* vb;
+        const StreamBuffer* sb;  // one of vb / sb is set
+        VertexBufferLayout layout; // a copy, fixed size
+        unsigned int firstIndex;
+        unsigned int divisor;
+        mutable unsigned int boundId; // a resized StreamBuffer gets a new id
+    };
+    Binding m_Bindings[VertexBufferLayout::MaxElements];
+    unsigned int m_BindingCount = 0;
+    mutable unsigned int m_BaseInstance = 0;
+
+    void setAttribPointers(const VertexBufferLayout& layout, unsigned int firstIndex,
+                           unsigned int baseOffset) const;
+    void enableAttribs(const VertexBufferLayout& layout, unsigned int firstIndex,
+                       unsigned int divisor);
+    void addBinding(const Binding& binding);
+
 public:
     VertexArray();
     ~VertexArray();
 
-    void addBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
+    // firstIndex: attribute location of the first element
+    // divisor: 0 = per vertex, 1 = per instance (glVertexAttribDivisor)
+    void addBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout,
+                   unsigned int firstIndex = 0, unsigned int divisor = 0);
+    void addBuffer(const StreamBuffer& sb, const VertexBufferLayout& layout,
+                   unsigned int firstIndex = 0, unsigned int divisor = 0);
+
+    // re-points instance attributes so instance 0 reads element `base`
+    // (VAO must be bound)
+    void setBaseInstance(unsigned int base) const;
+    // bytes of instance attributes each instance reads, over all streams
+    unsigned int getInstanceStride() const;
+
+    // where attribute `location` is read from, for CPU backends; false if
+    // nothing feeds it or its buffer has no CPU copy (not headless)
+    struct AttributeSource
+    {
+        const unsigned char* data; // the attribute in element 0
+        unsigned int stride;
+        unsigned int count;        // components, all GL_FLOAT here
+        unsigned int divisor;
+    };
+    bool getAttribute(unsigned int location, AttributeSource& out) const;
 
     void Bind() const;
     void UnBind() const;
+    unsigned int GetRendererID() const { return m_RendererID; }
 };
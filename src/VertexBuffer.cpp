@@ -1,26 +1,105 @@
+#define GL_SUBSYSTEM GLSubsystemBuffers
 #include "VertexBuffer.hpp"
 #include "Renderer.hpp"
+#include "GLState.hpp"
+#include <cstring>
 
-VertexBuffer::VertexBuffer(const void *data, unsigned int size)
+VertexBuffer::VertexBuffer(const void *data, unsigned int size, bool dynamic)
+    : m_Size(size), m_Dynamic(dynamic)
 {
-   
+    if (GLState::headless())
+    {
+        m_RendererId = GLState::headlessName();
+        m_Cpu.assign(size, 0);
+        if (data)
+            std::memcpy(m_Cpu.data(), data, size);
+        return;
+    }
+
     GLCall(glGenBuffers(1, &m_RendererId));
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererId));
-    GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
+    GLState::bindBuffer(GL_ARRAY_BUFFER, m_RendererId);
+    GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, dynamic ? GL_STREAM_DRAW : GL_STATIC_DRAW));
 }
 
 VertexBuffer::~VertexBuffer()
 {
-    GLCall(glDeleteBuffers(1, &m_RendererId));
+    GLState::forgetBuffer(m_RendererId);
+    if (!GLState::headless())
+    {
+        GLCall(glDeleteBuffers(1, &m_RendererId));
+    }
 }
 
 void VertexBuffer::Bind()const
 {
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererId));
+    GLState::bindBuffer(GL_ARRAY_BUFFER, m_RendererId);
 
 }
 
 void VertexBuffer::UnBind()const
 {
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    GLState::bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void VertexBuffer::setData(const void *data, unsigned int size)
+{
+    GLenum usage = m_Dynamic ? GL_STREAM_DRAW : GL_STATIC_DRAW;
+
+    // grow, or orphan the old storage so the driver doesn't wait on
+    // draws that are still reading last frame's contents
+    if (size > m_Size)
+        m_Size = size;
+    if (GLState::headless())
+    {
+        m_Cpu.resize(m_Size);
+        if (data)
+            std::memcpy(m_Cpu.data(), data, size);
+        return;
+    }
+
+    Bind();
+    GLCall(glBufferData(GL_ARRAY_BUFFER, m_Size, nullptr, usage));
+    if (data)
+    {
+        GLCall(glBufferSubData(GL_ARRAY_BUFFER, 0, size, data));
+    }
+}
+
+void VertexBuffer::setSubData(const void *data, unsigned int offset, unsigned int size)
+{
+    if (GLState::headless())
+    {
+        std::memcpy(m_Cpu.data() + offset, data, size);
+        return;
+    }
+    Bind();
+    GLCall(glBufferSubData(GL_ARRAY_BUFFER, offset, size, data));
+}
+
+void VertexBuffer::reserve(unsigned int size)
+{
+    if (size <= m_Size)
+        return;
+
+    if (GLState::headless())
+        m_Cpu.resize(size);
+    else
+        growStorage(m_RendererId, m_Size, size, m_Dynamic ? GL_STREAM_DRAW : GL_STATIC_DRAW);
+    m_Size = size;
+}
+
+void VertexBuffer::growStorage(unsigned int buffer, unsigned int oldSize, unsigned int newSize, unsigned int usage)
+{
+    // park the old contents in a scratch buffer while this one is reallocated;
+    // reallocating in place keeps VAO attribute bindings valid
+    unsigned int scratch;
+    GLCall(glGenBuffers(1, &scratch));
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, scratch));
+    GLCall(glBufferData(GL_COPY_WRITE_BUFFER, oldSize, nullptr, GL_STREAM_COPY));
+    GLCall(glBindBuffer(GL_COPY_READ_BUFFER, buffer));
+    GLCall(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize));
+
+    GLCall(glBufferData(GL_COPY_READ_BUFFER, newSize, nullptr, usage));
+    GLCall(glCopyBufferSubData(GL_COPY_WRITE_BUFFER, GL_COPY_READ_BUFFER, 0, 0, oldSize));
+    GLCall(glDeleteBuffers(1, &scratch));
 }
@@ -1,14 +1,33 @@
 #pragma once
+#include <vector>
+
 class VertexBuffer
 {
 private:
     unsigned int m_RendererId;
+    unsigned int m_Size;
+    bool m_Dynamic;
+    std::vector<unsigned char> m_Cpu; // headless: the contents
 public:
-    VertexBuffer(const void* data, unsigned int size);
+    VertexBuffer(const void* data, unsigned int size, bool dynamic = false);
     ~VertexBuffer();
 
     void Bind()const;
     void UnBind()const;
+    // re-uploads the whole buffer, orphaning the old storage (dynamic buffers);
+    // data may be null to orphan only
+    void setData(const void* data, unsigned int size);
+    // writes into the existing storage at `offset`, no orphaning
+    void setSubData(const void* data, unsigned int offset, unsigned int size);
+    // grows the storage, keeping the current contents and the buffer id
+    void reserve(unsigned int size);
     unsigned int GetRendererID() const { return m_RendererId; }
 
-};
\ No newline at end of file
+    // reallocates `buffer` to newSize bytes keeping the first oldSize and
+    // the buffer id (so VAO bindings stay valid); shared with IndexBuffer
+    static void growStorage(unsigned int buffer, unsigned int oldSize, unsigned int newSize, unsigned int usage);
+    inline unsigned int getSize() const { return m_Size; }
+    // headless only (null otherwise), for CPU backends
+    const unsigned char* getCpuData() const { return m_Cpu.empty() ? nullptr : m_Cpu.data(); }
+
+};
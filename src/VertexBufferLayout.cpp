@@ -1,37 +0,0 @@
-#include "VertexBufferLayout.hpp"
-
-unsigned int VertexBufferElement::getSizeOfType(unsigned int type)
-{
-    switch (type)
-    {
-    case GL_FLOAT:         return 4;
-    case GL_UNSIGNED_INT:  return 4;
-    case GL_UNSIGNED_BYTE: return 1;
-    }
-    assert(false);
-    return 0;
-}
-
-VertexBufferLayout::VertexBufferLayout()
-    : m_Stride(0) {}
-
-template<>
-void VertexBufferLayout::Push<float>(unsigned int count)
-{
-    m_Elements.push_back({ GL_FLOAT, count, GL_FALSE });
-    m_Stride += count * VertexBufferElement::getSizeOfType(GL_FLOAT);
-}
-
-template<>
-void VertexBufferLayout::Push<unsigned int>(unsigned int count)
-{
-    m_Elements.push_back({ GL_UNSIGNED_INT, count, GL_FALSE });
-    m_Stride += count * VertexBufferElement::getSizeOfType(GL_UNSIGNED_INT);
-}
-
-template<>
-void VertexBufferLayout::Push<unsigned char>(unsigned int count)
-{
-    m_Elements.push_back({ GL_UNSIGNED_BYTE, count, GL_TRUE });
-    m_Stride += count * VertexBufferElement::getSizeOfType(GL_UNSIGNED_BYTE);
-}
@@ -1,42 +1,144 @@
 #pragma once
 
-#include <vector>
 #include <glad/glad.h>
-#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include "vendor/glm/glm.hpp"
+#include "vendor/glm/ext/vector_uint4_sized.hpp"
 
+// One attribute location: `count` components of `type` at `offset` bytes
+// into the element.
 struct VertexBufferElement
 {
     unsigned int type;
     unsigned int count;
     unsigned char normalized;
+    unsigned int offset;
+};
+
+// What a member of a vertex struct is to GL. Only the types below have
+// one; anything else doesn't compile. A matrix takes one location per
+// column.
+template <typename T>
+struct VertexAttributeType;
 
-    static unsigned int getSizeOfType(unsigned int type);
+template <unsigned int Type, unsigned int Components, unsigned int ComponentSize, unsigned int Locations = 1,
+          unsigned char Normalized = GL_FALSE>
+struct VertexAttributeTypeOf
+{
+    static constexpr unsigned int type = Type;
+    static constexpr unsigned int components = Components;
+    static constexpr unsigned int locations = Locations;
+    static constexpr unsigned char normalized = Normalized;
+    static constexpr unsigned int size = Components * ComponentSize * Locations;
 };
 
+template <> struct VertexAttributeType<float> : VertexAttributeTypeOf<GL_FLOAT, 1, 4> {};
+template <> struct VertexAttributeType<glm::vec2> : VertexAttributeTypeOf<GL_FLOAT, 2, 4> {};
+template <> struct VertexAttributeType<glm::vec3> : VertexAttributeTypeOf<GL_FLOAT, 3, 4> {};
+template <> struct VertexAttributeType<glm::vec4> : VertexAttributeTypeOf<GL_FLOAT, 4, 4> {};
+template <> struct VertexAttributeType<glm::mat4> : VertexAttributeTypeOf<GL_FLOAT, 4, 4, 4> {};
+template <> struct VertexAttributeType<unsigned int> : VertexAttributeTypeOf<GL_UNSIGNED_INT, 1, 4> {};
+// read as 0..1 floats
+template <> struct VertexAttributeType<glm::u8vec4> : VertexAttributeTypeOf<GL_UNSIGNED_BYTE, 4, 1, 1, GL_TRUE> {};
+
+// A member of type T at byte `Offset` of its vertex struct; written with
+// VERTEX_ATTRIBUTE, which takes both from the struct itself.
+template <typename T, size_t Offset>
+struct VertexAttribute
+{
+    using Type = VertexAttributeType<T>;
+    static_assert(Type::size == sizeof(T), "a padded or aligned glm type doesn't match its GL attribute");
+    static constexpr size_t offset = Offset;
+};
+
+#define VERTEX_ATTRIBUTE(Vertex, member) VertexAttribute<decltype(Vertex::member), offsetof(Vertex, member)>
+
+// Where each attribute of a buffer's elements is, and the stride between
+// them. A fixed array, built at compile time by VertexLayout; VertexArray
+// copies it and reads the offsets as they are.
 class VertexBufferLayout
 {
+public:
+    // GL guarantees at least 16 attribute locations
+    static const unsigned int MaxElements = 16;
+
+    constexpr VertexBufferLayout() = default;
+
+    constexpr unsigned int getStride() const { return m_Stride; }
+    constexpr unsigned int getCount() const { return m_Count; }
+    constexpr const VertexBufferElement &operator[](unsigned int i) const { return m_Elements[i]; }
+    constexpr const VertexBufferElement *begin() const { return m_Elements; }
+    constexpr const VertexBufferElement *end() const { return m_Elements + m_Count; }
+
 private:
-    std::vector<VertexBufferElement> m_Elements;
-    unsigned int m_Stride;
+    template <typename Type>
+    friend constexpr void appendVertexAttribute(VertexBufferLayout &layout, unsigned int offset);
+    template <typename Vertex, typename... Attributes>
+    friend constexpr VertexBufferLayout buildVertexLayout();
 
-public:
-    VertexBufferLayout();
+    VertexBufferElement m_Elements[MaxElements] = {};
+    unsigned int m_Count = 0;
+    unsigned int m_Stride = 0;
+};
 
-    template<typename T>
-    void Push(unsigned int count)
+template <typename Type>
+constexpr void appendVertexAttribute(VertexBufferLayout &layout, unsigned int offset)
+{
+    for (unsigned int i = 0; i < Type::locations; ++i)
     {
-        static_assert(sizeof(T) == 0, "Unsupported type in VertexBufferLayout!");
+        layout.m_Elements[layout.m_Count++] = {Type::type, Type::components, Type::normalized,
+                                               offset + i * Type::size / Type::locations};
     }
+}
 
-    template<>
-    void Push<float>(unsigned int count);
+template <typename Vertex, typename... Attributes>
+constexpr VertexBufferLayout buildVertexLayout()
+{
+    VertexBufferLayout layout;
+    layout.m_Stride = (unsigned int)sizeof(Vertex);
+    (appendVertexAttribute<typename Attributes::Type>(layout, (unsigned int)Attributes::offset), ...);
+    return layout;
+}
 
-    template<>
-    void Push<unsigned int>(unsigned int count);
+// whether the attributes cover the vertex exactly, in order
+template <typename Vertex, typename... Attributes>
+constexpr bool vertexAttributesTile()
+{
+    size_t offsets[] = {Attributes::offset...};
+    size_t sizes[] = {Attributes::Type::size...};
+    size_t end = 0;
+    for (size_t i = 0; i < sizeof...(Attributes); ++i)
+    {
+        if (offsets[i] != end)
+            return false;
+        end += sizes[i];
+    }
+    return end == sizeof(Vertex);
+}
 
-    template<>
-    void Push<unsigned char>(unsigned int count);
+// The layout of a vertex struct, from its members in declaration order:
+//
+//   struct MeshVertex { glm::vec3 position; glm::vec2 texCoord; };
+//   using MeshVertexLayout = VertexLayout<MeshVertex, VERTEX_ATTRIBUTE(MeshVertex, position),
+//                                         VERTEX_ATTRIBUTE(MeshVertex, texCoord)>;
+//   va.addBuffer(vb, MeshVertexLayout::value);
+//
+// Every member has to be listed, in order: the attributes have to tile
+// the struct exactly, so a member added, reordered or padded without the
+// layout following fails to compile here instead of reading garbage.
+template <typename Vertex, typename... Attributes>
+struct VertexLayout
+{
+    static_assert(std::is_standard_layout<Vertex>::value, "offsetof needs a standard-layout vertex struct");
+    static_assert(sizeof...(Attributes) > 0, "a vertex has at least one attribute");
+    static_assert((Attributes::Type::locations + ...) <= VertexBufferLayout::MaxElements, "too many attributes");
+    static_assert(vertexAttributesTile<Vertex, Attributes...>(),
+                  "attributes must list every member of the vertex, in order, with no padding between");
 
-    inline const std::vector<VertexBufferElement>& getElements() const { return m_Elements; }
-    inline unsigned int getStride() const { return m_Stride; }
+    static constexpr VertexBufferLayout value = buildVertexLayout<Vertex, Attributes...>();
 };
+
+// a stream of bare T (a glm type), one attribute per element
+template <typename T>
+using VertexLayoutOf = VertexLayout<T, VertexAttribute<T, 0>>;
@@ -1,8 +1,144 @@
 #include"App.hpp"
+#include "NullRenderer.hpp"
+#include "RecordingRenderer.hpp"
+#include "SoftwareRenderer.hpp"
+#include "ShaderCompiler.hpp"
+#include "TextureLoader.hpp"
+#include "TextureEncoder.hpp"
+#include "TextureResidency.hpp"
+#include "UniformBenchmark.hpp"
+#include "ImageIngest.hpp"
+#include "GLState.hpp"
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <filesystem>
 
-int main()
+// usage: app [--headless [null|record|soft]] [--frames N] [--instances N] [--no-warmup]
+//            [--upload-budget MS] [--texture-budget MB] [--output PNG]
+//        app --bench-uniforms [N]
+//        app --encode-texture IMAGE [auto|bc1|bc3|bc7]
+//        app --bench-decode DIR [N]
+// --headless runs the frame loop without a GPU and prints CPU timings;
+// soft renders on the CPU and writes the last frame to --output (default
+// cache/output.png);
+// --no-warmup skips drawing every shader once while loading;
+// --upload-budget caps texture uploads per frame (TextureLoader, default 2);
+// --texture-budget caps texture memory, streaming mips out least recently
+// used first (TextureResidency, default none);
+// --bench-uniforms times the uniform paths (UniformBenchmark) and exits;
+// --encode-texture writes IMAGE's .btex next to it (TextureEncoder) and exits;
+// --bench-decode decodes DIR's images N times (default 5) each way
+// (ImageIngest) and prints the best times
+int main(int argc, char** argv)
 {
+    bool headless = false;
+    std::string backendName = "null";
+    int frames = 600;
+    int instances = 10000;
+    std::string outputPath = "cache/output.png";
+    int benchUniforms = 0;
+    std::string encodeImage;
+    std::string benchDecode;
+    int benchDecodeRepeats = 5;
+    TextureEncoder::Choice encodeChoice = TextureEncoder::Choice::Auto;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--headless") == 0)
+        {
+            headless = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                backendName = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frames = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--instances") == 0 && i + 1 < argc)
+            instances = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+            outputPath = argv[++i];
+        else if (std::strcmp(argv[i], "--no-warmup") == 0)
+            ShaderCompiler::setWarmUpEnabled(false);
+        else if (std::strcmp(argv[i], "--upload-budget") == 0 && i + 1 < argc)
+            TextureLoader::setBudget((float)std::atof(argv[++i]));
+        else if (std::strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc)
+            TextureResidency::setBudget((size_t)(std::atof(argv[++i]) * 1024.0 * 1024.0));
+        else if (std::strcmp(argv[i], "--bench-uniforms") == 0)
+        {
+            benchUniforms = 1000000;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                benchUniforms = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--bench-decode") == 0 && i + 1 < argc)
+        {
+            benchDecode = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                benchDecodeRepeats = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--encode-texture") == 0 && i + 1 < argc)
+        {
+            encodeImage = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+            {
+                std::string format = argv[++i];
+                if (format == "bc1")
+                    encodeChoice = TextureEncoder::Choice::BC1;
+                else if (format == "bc3")
+                    encodeChoice = TextureEncoder::Choice::BC3;
+                else if (format == "bc7")
+                    encodeChoice = TextureEncoder::Choice::BC7;
+            }
+        }
+    }
+
+    if (!encodeImage.empty())
+    {
+        GLState::setHeadless(true);
+        return TextureEncoder::encodeFile(encodeImage, encodeChoice) ? 0 : 1;
+    }
+
+    if (!benchDecode.empty())
+    {
+        ImageIngest::benchmark(benchDecode, benchDecodeRepeats);
+        return 0;
+    }
+
+    if (benchUniforms > 0)
+    {
+        GLState::setHeadless(true);
+        UniformBenchmark::run((unsigned int)benchUniforms);
+        return 0;
+    }
+
+    if (headless)
+    {
+        RecordingRenderer* recorder = nullptr;
+        SoftwareRenderer* software = nullptr;
+        Renderer* backend;
+        if (backendName == "record")
+            backend = recorder = new RecordingRenderer();
+        else if (backendName == "soft")
+            backend = software = new SoftwareRenderer(940, 680);
+        else
+            backend = new NullRenderer();
+
+        App app(backend);
+        app.runHeadless(frames, instances);
+        if (recorder)
+            recorder->printSummary();
+        if (software)
+        {
+            software->printSummary();
+            std::error_code error;
+            std::filesystem::path parent = std::filesystem::path(outputPath).parent_path();
+            if (!parent.empty())
+                std::filesystem::create_directories(parent, error);
+            software->writeImage(outputPath);
+        }
+        return 0;
+    }
+
     App app;
     app.run();
     return 0;
-}
\ No newline at end of file
+}
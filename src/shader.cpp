@@ -1,145 +1,798 @@
+#define GL_SUBSYSTEM GLSubsystemShaders
 #include "Shader.hpp"
 #include "Renderer.hpp"
 #include "Console.hpp"
+#include "GLState.hpp"
+#include "UniformBuffer.hpp"
+#include "ShaderCache.hpp"
+#include "GLExtensions.hpp"
+#include "ShaderCompiler.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include <filesystem>
+#include <vector>
 
-Shader::Shader(const std::string &filepath) : m_renderedId(0), m_filePath(filepath)
+namespace
+{
+    // indexed by ShaderStage bit
+    const char *const StageNames[ShaderStageCount] = {"vertex", "fragment", "geometry", "compute"};
+    const unsigned int StageTypes[ShaderStageCount] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER,
+                                                       GL_COMPUTE_SHADER};
+    const unsigned int StageBits[ShaderStageCount] = {GL_VERTEX_SHADER_BIT, GL_FRAGMENT_SHADER_BIT,
+                                                      GL_GEOMETRY_SHADER_BIT, GL_COMPUTE_SHADER_BIT};
+}
+
+Shader::Shader(const std::string &filepath, const std::string &defines, unsigned int stages, bool separable)
+    : m_renderedId(0), m_filePath(filepath), m_Defines(defines), m_Stages(stages), m_Separable(separable)
 {
     shaderProgrammingSources source = parseShader(filepath);
-    m_renderedId = createShader(source.vertexSource, source.fragmentSource);
+    if (GLState::headless())
+    {
+        m_renderedId = GLState::headlessName();
+        // no program to ask; any distinct location keeps the value cache working
+        parseUniforms(source);
+        m_State = (int)CompileState::Ready;
+        return;
+    }
+    m_Build.slot = cacheSlot();
+    m_Build.separable = m_Separable;
+    std::string *sources = m_Build.sources;
+    sources[0] = std::move(source.vertexSource);
+    sources[1] = std::move(source.fragmentSource);
+    sources[2] = std::move(source.geometrySource);
+    sources[3] = std::move(source.computeSource);
+
+    // what the driver can't take fails here rather than at link time
+    const char *unsupported = nullptr;
+    bool compute = !sources[3].empty();
+    bool graphics = !sources[0].empty() || !sources[1].empty() || !sources[2].empty();
+    if (!compute && !graphics)
+        unsupported = "no stages";
+    else if (compute && graphics)
+        unsupported = "compute mixed with other stages";
+    else if (compute && !GLExtensions::ARB_compute_shader)
+        unsupported = "compute (ARB_compute_shader)";
+    else if (m_Separable && !GLExtensions::ARB_separate_shader_objects)
+        unsupported = "separable (ARB_separate_shader_objects)";
+    if (unsupported)
+    {
+        Console::LOGN(m_Build.slot + ": " + unsupported, Color::RED);
+        m_State = (int)CompileState::Failed;
+        return;
+    }
+
+    switch (ShaderCompiler::getMode())
+    {
+    case ShaderCompiler::Mode::Worker:
+        ShaderCompiler::enqueue(this);
+        break;
+    case ShaderCompiler::Mode::Parallel:
+        // returns before the driver is done; isReady() polls for the rest
+        m_Program = beginProgram(m_Build);
+        break;
+    case ShaderCompiler::Mode::Sync:
+        compileNow();
+        isReady();
+        break;
+    }
+}
+
+Shader::Shader(const std::vector<Shader *const *> &stages)
+    : m_renderedId(0), m_PipelineStages(stages), m_AttachedPrograms(stages.size(), 0)
+{
+    m_filePath = "pipeline";
+    for (Shader *const *stage : stages)
+        m_filePath += " " + (*stage)->cacheSlot();
+    if (GLState::headless())
+    {
+        m_renderedId = GLState::headlessName();
+        m_State = (int)CompileState::Ready;
+        return;
+    }
+    if (!GLExtensions::ARB_separate_shader_objects)
+    {
+        Console::LOGN(m_filePath + ": needs ARB_separate_shader_objects", Color::RED);
+        m_State = (int)CompileState::Failed;
+        return;
+    }
+    // the pipeline object itself waits for the stages, see pollPipeline()
+    isReady();
 }
+
 Shader::~Shader()
 {
-    GLCall(glDeleteProgram(m_renderedId));
+    if (isPipeline())
+    {
+        GLState::forgetProgramPipeline(m_renderedId);
+        if (!GLState::headless() && m_renderedId)
+        {
+            GLCall(GLExtensions::DeleteProgramPipelines(1, &m_renderedId));
+        }
+        return;
+    }
+
+    ShaderCompiler::cancel(this);
+    GLState::forgetProgram(m_renderedId);
+    if (!GLState::headless())
+    {
+        // still attached if the program never finished linking
+        for (unsigned int &shader : m_Build.pendingShaders)
+        {
+            if (shader)
+                glDeleteShader(shader);
+        }
+        unsigned int program = m_Program;
+        if (program)
+        {
+            GLCall(glDeleteProgram(program));
+        }
+    }
 }
 
-Shader::shaderProgrammingSources Shader::parseShader(const std::string &filepath)
+namespace
 {
-    std::ifstream stream(filepath);
+    // `seen`: what this stage already pasted in; `files`: everything read
+    bool expandFile(const std::filesystem::path &path, std::string &text, std::vector<std::string> &files,
+                    std::vector<std::string> &seen)
+    {
+        std::ifstream stream(path);
+        if (!stream)
+            return false;
+        std::string name = path.lexically_normal().generic_string();
+        seen.push_back(name);
+        if (std::find(files.begin(), files.end(), name) == files.end())
+            files.push_back(name);
+
+        std::string line;
+        while (std::getline(stream, line))
+        {
+            size_t start = line.find_first_not_of(" \t");
+            // each stage is compiled on its own, so it gets its own includes
+            if (start != std::string::npos && line.compare(start, 7, "#shader") == 0)
+                seen.assign(1, files.front());
+            if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+            {
+                text += line;
+                text += '\n';
+                continue;
+            }
+
+            size_t open = line.find('"', start);
+            size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+            if (close == std::string::npos)
+            {
+                Console::LOGN("bad #include in " + path.generic_string() + ": " + line, Color::RED);
+                return false;
+            }
+            std::filesystem::path included =
+                (path.parent_path() / line.substr(open + 1, close - open - 1)).lexically_normal();
+            // once per stage, which also ends include cycles
+            if (std::find(seen.begin(), seen.end(), included.generic_string()) != seen.end())
+                continue;
+            if (!expandFile(included, text, files, seen))
+            {
+                Console::LOGN("can't open " + included.generic_string() + ", included from " +
+                                  path.generic_string(),
+                              Color::RED);
+                return false;
+            }
+        }
+        return true;
+    }
 
-    enum class shaderTypes
+    // defines go right after #version, which has to stay first
+    void injectDefines(std::string &source, const std::string &defines)
     {
-        NONE = -1,
-        VERTEX = 0,
-        FRAGMENT = 1
-    };
+        if (defines.empty())
+            return;
+        size_t at = 0;
+        size_t version = source.find("#version");
+        if (version != std::string::npos)
+        {
+            size_t end = source.find('\n', version);
+            at = end == std::string::npos ? source.size() : end + 1;
+        }
+        source.insert(at, defines);
+    }
+}
+
+bool Shader::expandIncludes(const std::string &filepath, std::string &text, std::vector<std::string> &files)
+{
+    text.clear();
+    files.clear();
+    std::vector<std::string> seen;
+    return expandFile(filepath, text, files, seen);
+}
+
+Shader::shaderProgrammingSources Shader::parseShader(const std::string &filepath)
+{
+    std::string text;
+    expandIncludes(filepath, text, m_Files);
+    std::istringstream stream(text);
 
     std::string line;
-    std::stringstream ss[2];
-    shaderTypes type = shaderTypes::NONE;
+    std::stringstream ss[ShaderStageCount];
+    // the ShaderStage index, -1 before the first section and in sections
+    // this program doesn't build
+    int type = -1;
 
     while (std::getline(stream, line))
     {
         if (line.find("#shader") != std::string::npos)
         {
-            if (line.find("vertex") != std::string::npos)
-                type = shaderTypes::VERTEX;
-            else if (line.find("fragment") != std::string::npos)
-                type = shaderTypes::FRAGMENT;
+            type = -1;
+            for (int stage = 0; stage < ShaderStageCount; ++stage)
+            {
+                if (line.find(StageNames[stage]) != std::string::npos && (m_Stages & (1u << stage)))
+                    type = stage;
+            }
         }
-        else if (type != shaderTypes::NONE)
+        else if (type != -1)
         {
-            ss[(int)type] << line << '\n';
+            ss[type] << line << '\n';
         }
 
     }
-    return {ss[0].str(), ss[1].str()};
+
+    shaderProgrammingSources sources = {ss[0].str(), ss[1].str(), ss[2].str(), ss[3].str()};
+    // a 330 core stage has to ask for separable linking, and for
+    // compute, before it can have either
+    std::string prologue = m_Defines;
+    if (m_Separable)
+        prologue = "#extension GL_ARB_separate_shader_objects : require\n" + prologue;
+    if (!sources.computeSource.empty())
+        injectDefines(sources.computeSource, "#extension GL_ARB_compute_shader : require\n");
+    for (std::string *source : {&sources.vertexSource, &sources.fragmentSource, &sources.geometrySource,
+                                &sources.computeSource})
+    {
+        if (!source->empty())
+            injectDefines(*source, prologue);
+    }
+    return sources;
+}
+
+std::string Shader::cacheSlot() const
+{
+    // variants and stage programs of one file need slots of their own
+    std::string slot = m_filePath;
+    if (m_Stages != StageAll || m_Separable)
+    {
+        slot += " (";
+        for (int stage = 0; stage < ShaderStageCount; ++stage)
+        {
+            if (m_Stages & (1u << stage))
+                slot += std::string(" ") + StageNames[stage];
+        }
+        slot += m_Separable ? " separable)" : " )";
+    }
+    if (!m_Defines.empty())
+        slot += " [" + m_Defines + "]";
+    return slot;
 }
 
+// no status query here, that would wait for the compiler; checkCompile()
+// reports once the program is done
 unsigned int Shader::compileShader(unsigned int type, const std::string &source)
 {
     unsigned int id = glCreateShader(type);
     const char *src = source.c_str();
     glShaderSource(id, 1, &src, nullptr);
     glCompileShader(id);
+    return id;
+}
 
+bool Shader::checkCompile(unsigned int id, unsigned int type, const std::string &slot)
+{
     int result;
     glGetShaderiv(id, GL_COMPILE_STATUS, &result);
     if (result == GL_FALSE)
     {
         int length;
         glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
-        char *message = (char *)alloca(length * sizeof(char));
-        glGetShaderInfoLog(id, length, &length, message);
-        Console::LOGN(
-            std::string("Failed to compile ") +
-                (type == GL_VERTEX_SHADER ? "vertex" : "fragment") +
-                " shader",
-            Color::RED);
+        std::string message(length > 0 ? length : 1, '\0');
+        glGetShaderInfoLog(id, (GLsizei)message.size(), nullptr, &message[0]);
+        const char *stage = "unknown";
+        for (int i = 0; i < ShaderStageCount; ++i)
+        {
+            if (StageTypes[i] == type)
+                stage = StageNames[i];
+        }
+        Console::LOGN(std::string("Failed to compile ") + stage + " shader of " + slot, Color::RED);
 
         Console::LOGN( message,Color::RED);
-
-        glDeleteShader(id);
-        return 0;
+        return false;
     }
-
-    return id;
+    return true;
 }
 
-unsigned int Shader::createShader(const std::string &vertexShader, const std::string &fragmentShader)
+unsigned int Shader::beginProgram(ProgramBuild &build)
 {
     unsigned int program = glCreateProgram();
-    unsigned int vs = compileShader(GL_VERTEX_SHADER, vertexShader);
-    unsigned int fs = compileShader(GL_FRAGMENT_SHADER, fragmentShader);
+    if (build.separable)
+    {
+        GLCall(GLExtensions::ProgramParameteri(program, GL_PROGRAM_SEPARABLE, GL_TRUE));
+    }
+
+    // same sources on the same driver: skip compile and link entirely
+    build.cacheKey = 0;
+    build.fromCache = false;
+    if (ShaderCache::available())
+    {
+        std::string sources;
+        for (int stage = 0; stage < ShaderStageCount; ++stage)
+            sources += std::string("#shader ") + StageNames[stage] + '\n' + build.sources[stage];
+        build.cacheKey = ShaderCache::makeKey(sources);
+        if (ShaderCache::load(program, build.slot, build.cacheKey))
+        {
+            build.fromCache = true;
+            return program;
+        }
+        GLCall(GLExtensions::ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    }
 
-    glAttachShader(program, vs);
-    glAttachShader(program, fs);
+    for (int stage = 0; stage < ShaderStageCount; ++stage)
+    {
+        if (build.sources[stage].empty())
+            continue;
+        build.pendingShaders[stage] = compileShader(StageTypes[stage], build.sources[stage]);
+        glAttachShader(program, build.pendingShaders[stage]);
+    }
     glLinkProgram(program);
+    return program;
+}
+
+bool Shader::endProgram(ProgramBuild &build, unsigned int program)
+{
+    if (build.fromCache)
+        return true;
+
+    bool compiled = true;
+    for (int stage = 0; stage < ShaderStageCount; ++stage)
+    {
+        unsigned int &shader = build.pendingShaders[stage];
+        if (!shader)
+            continue;
+        compiled = checkCompile(shader, StageTypes[stage], build.slot) && compiled;
+        glDeleteShader(shader);
+        shader = 0;
+    }
+
+    int linked;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (linked == GL_FALSE)
+    {
+        int length;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+        std::string message(length > 0 ? length : 1, '\0');
+        glGetProgramInfoLog(program, (GLsizei)message.size(), nullptr, &message[0]);
+        Console::LOGN("Failed to link " + build.slot, Color::RED);
+        if (compiled)
+            Console::LOGN(message, Color::RED);
+        return false;
+    }
+
+#if GL_ERROR_CHECKS
+    // checks against whatever state is bound right now, so it only
+    // means something as a debugging aid
     glValidateProgram(program);
+#endif
 
-    glDeleteShader(vs);
-    glDeleteShader(fs);
+    if (ShaderCache::available())
+        ShaderCache::store(program, build.slot, build.cacheKey);
+    return true;
+}
 
-    return program;
+// start to finish on the calling thread (Sync mode; the worker runs
+// beginProgram / endProgram itself, see ShaderCompiler::workerLoop)
+void Shader::compileNow()
+{
+    unsigned int program = beginProgram(m_Build);
+    bool linked = endProgram(m_Build, program);
+    m_Program = program;
+    m_State.store((int)(linked ? CompileState::Linked : CompileState::Failed), std::memory_order_release);
 }
+
+bool Shader::isReady() const
+{
+    int state = m_State.load(std::memory_order_acquire);
+    if (state == (int)CompileState::Ready)
+        return true;
+    // the object is never really const; finishing up only touches what
+    // the compile itself owns, plus m_renderedId
+    if (isPipeline())
+        return state != (int)CompileState::Failed && const_cast<Shader *>(this)->pollPipeline();
+    return const_cast<Shader *>(this)->pollCompile(state);
+}
+
+bool Shader::hasFailed() const
+{
+    if (m_State.load(std::memory_order_acquire) == (int)CompileState::Failed)
+        return true;
+    for (Shader *const *stage : m_PipelineStages)
+    {
+        if ((*stage)->hasFailed())
+            return true;
+    }
+    return false;
+}
+
+bool Shader::pollPipeline()
+{
+    for (Shader *const *stage : m_PipelineStages)
+    {
+        if (!(*stage)->isReady())
+            return false;
+    }
+
+    GLCall(GLExtensions::GenProgramPipelines(1, &m_renderedId));
+    attachStages();
+
+#if GL_ERROR_CHECKS
+    // like glValidateProgram, only meaningful as a debugging aid
+    GLExtensions::ValidateProgramPipeline(m_renderedId);
+    int valid = GL_TRUE;
+    GLExtensions::GetProgramPipelineiv(m_renderedId, GL_VALIDATE_STATUS, &valid);
+    if (valid == GL_FALSE)
+    {
+        int length = 0;
+        GLExtensions::GetProgramPipelineiv(m_renderedId, GL_INFO_LOG_LENGTH, &length);
+        std::string message(length > 0 ? length : 1, '\0');
+        GLExtensions::GetProgramPipelineInfoLog(m_renderedId, (GLsizei)message.size(), nullptr, &message[0]);
+        Console::LOGN("Pipeline doesn't validate: " + m_filePath, Color::YELLOW);
+        Console::LOGN(message, Color::YELLOW);
+    }
+#endif
+
+    m_State.store((int)CompileState::Ready, std::memory_order_release);
+    return true;
+}
+
+void Shader::attachStages() const
+{
+    for (size_t i = 0; i < m_PipelineStages.size(); ++i)
+    {
+        const Shader *stage = *m_PipelineStages[i];
+        if (m_AttachedPrograms[i] == stage->m_renderedId)
+            continue;
+        unsigned int bits = 0;
+        for (int s = 0; s < ShaderStageCount; ++s)
+        {
+            if (stage->m_Stages & (1u << s))
+                bits |= StageBits[s];
+        }
+        if (!GLState::headless())
+        {
+            GLCall(GLExtensions::UseProgramStages(m_renderedId, bits, stage->m_renderedId));
+        }
+        m_AttachedPrograms[i] = stage->m_renderedId;
+    }
+}
+
+bool Shader::pollCompile(int state)
+{
+    if (state == (int)CompileState::Compiling && ShaderCompiler::getMode() == ShaderCompiler::Mode::Parallel)
+    {
+        int done = GL_TRUE;
+        if (!m_Build.fromCache)
+            glGetProgramiv(m_Program, GL_COMPLETION_STATUS_KHR, &done);
+        if (done == GL_FALSE)
+            return false;
+        state = (int)(endProgram(m_Build, m_Program) ? CompileState::Linked : CompileState::Failed);
+        m_State.store(state, std::memory_order_release);
+    }
+    if (state != (int)CompileState::Linked)
+        return false;
+
+    // main thread from here on, whoever compiled it
+    m_renderedId = m_Program;
+    reflectUniforms();
+    bindUniformBlock(Uniforms::FrameData, FrameBlockBinding);
+    bindUniformBlock(Uniforms::TextureHandles, TextureHandlesBinding);
+    for (std::string &source : m_Build.sources)
+        std::string().swap(source);
+    m_State.store((int)CompileState::Ready, std::memory_order_release);
+    return true;
+}
+
 void Shader::Bind() const
 {
-    GLCall(glUseProgram(m_renderedId));
+    if (!isPipeline())
+    {
+        GLState::useProgram(m_renderedId);
+        return;
+    }
+    // a bound program would win over the pipeline
+    GLState::useProgram(0);
+    if (!isReady())
+        return;
+    // a hot-reloaded stage is a new program
+    attachStages();
+    GLState::bindProgramPipeline(m_renderedId);
 }
 void Shader::UnBind()
 {
-    GLCall(glUseProgram(0));
+    GLState::useProgram(0);
 }
 
-int Shader::getUniformLocation(const std::string &name)
+void Shader::addUniform(std::string name, int location)
 {
+    // arrays show up as "name[0]"; the handle for "name" means element 0
+    size_t bracket = name.find('[');
+    if (bracket != std::string::npos)
+        name.resize(bracket);
 
-    if (m_uniformLoactionCache.find(name) != m_uniformLoactionCache.end())
+    UniformSlot slot;
+    slot.hash = UniformHandle::fnv1a(name.c_str());
+    slot.location = location;
+    slot.hasValue = false;
+    for (const UniformSlot &other : m_Uniforms)
     {
-        return m_uniformLoactionCache[name];
+        if (other.hash == slot.hash)
+        {
+            // both stages declare it, or two names share a hash
+            if (other.location != location)
+                Console::LOGN("uniform '" + name + "' collides with another name in " + m_filePath, Color::RED);
+            return;
+        }
     }
-    GLCall(int location = glGetUniformLocation(m_renderedId, name.c_str()));
+    m_Uniforms.push_back(slot);
+}
 
-    if (location == -1)
-         Console::LOGN(
-            std::string("[ Warning: ] uniform '" )+ name+ "' doesn't exits", Color::YELLOW);
-    m_uniformLoactionCache[name] = location;
-    return location;
+void Shader::reflectUniforms()
+{
+    int count = 0, maxLength = 0;
+    GLCall(glGetProgramiv(m_renderedId, GL_ACTIVE_UNIFORMS, &count));
+    GLCall(glGetProgramiv(m_renderedId, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength));
+    std::string name(maxLength > 0 ? maxLength : 1, '\0');
+    for (int i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        GLint size;
+        GLenum type;
+        GLCall(glGetActiveUniform(m_renderedId, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, &name[0]));
+        std::string uniform(name.c_str(), length);
+        // block members have no location, they are set through the block
+        GLCall(int location = glGetUniformLocation(m_renderedId, uniform.c_str()));
+        if (location != -1)
+            addUniform(uniform, location);
+    }
+
+    GLCall(glGetProgramiv(m_renderedId, GL_ACTIVE_UNIFORM_BLOCKS, &count));
+    GLCall(glGetProgramiv(m_renderedId, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength));
+    name.assign(maxLength > 0 ? maxLength : 1, '\0');
+    for (int i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        GLCall(glGetActiveUniformBlockName(m_renderedId, (GLuint)i, (GLsizei)name.size(), &length, &name[0]));
+        m_Blocks.push_back({UniformHandle::fnv1a(std::string(name.c_str(), length).c_str()), (unsigned int)i});
+    }
+
+    buildUniformLookup();
 }
 
-void Shader::setUniform1i(const std::string &name, int value)
+// "uniform <type> <name>;" at the start of a statement; a block's
+// "uniform <Name>" line has no second identifier and is skipped
+void Shader::parseUniforms(const shaderProgrammingSources &source)
 {
-    GLCall(glUniform1i(getUniformLocation(name), value));
+    for (const std::string *stage : {&source.vertexSource, &source.fragmentSource})
+    {
+        std::istringstream lines(*stage);
+        std::string line;
+        while (std::getline(lines, line))
+        {
+            std::istringstream words(line);
+            std::string word, type, name;
+            while (words >> word && word != "uniform")
+                ;
+            if (word != "uniform" || !(words >> type >> name))
+                continue;
+            size_t end = name.find_first_of(";[");
+            if (end != std::string::npos)
+                name.resize(end);
+            // "uniform Block {" has no name; the same name twice is one
+            // declaration per #if branch, both read as the first
+            if (name.empty() || !(std::isalpha((unsigned char)name[0]) || name[0] == '_'))
+                continue;
+            uint32_t hash = UniformHandle::fnv1a(name.c_str());
+            if (std::none_of(m_Uniforms.begin(), m_Uniforms.end(),
+                             [hash](const UniformSlot &slot) { return slot.hash == hash; }))
+                addUniform(name, (int)m_Uniforms.size());
+        }
+    }
+    buildUniformLookup();
 }
-void Shader::setUniform1f(const std::string &name, float value)
+
+void Shader::buildUniformLookup()
 {
-    GLCall(glUniform1f(getUniformLocation(name), value));
+    size_t size = 1;
+    while (size < m_Uniforms.size() * 2)
+        size *= 2;
+    m_UniformLookup.assign(size, -1);
+    for (size_t i = 0; i < m_Uniforms.size(); ++i)
+    {
+        size_t mask = size - 1;
+        size_t bucket = m_Uniforms[i].hash & mask;
+        while (m_UniformLookup[bucket] != -1)
+            bucket = (bucket + 1) & mask;
+        m_UniformLookup[bucket] = (int)i;
+    }
 }
-void Shader::setUniform4f(const std::string &name, float v0, float v1, float v2, float v3)
+
+int Shader::lookupUniform(uint32_t hash) const
 {
-    GLCall(glUniform4f(getUniformLocation(name), v0, v1, v2, v3));
+    if (m_UniformLookup.empty())
+        return -1;
+    size_t mask = m_UniformLookup.size() - 1;
+    for (size_t bucket = hash & mask;; bucket = (bucket + 1) & mask)
+    {
+        int index = m_UniformLookup[bucket];
+        if (index == -1 || m_Uniforms[index].hash == hash)
+            return index;
+    }
 }
 
-void Shader::setUniformMat4f(const std::string &name, const glm::mat4 &matrix)
+Shader::UniformSlot *Shader::findUniform(UniformHandle uniform)
 {
-    GLint loc = getUniformLocation(name);
-    if (loc == -1)
-    {  
-        Console::LOGN(std::string("setUniformMat4f: uniform '") + name + std::string("' not found"), Color::RED);
+    int index = lookupUniform(uniform.hash);
+    if (index != -1)
+        return &m_Uniforms[index];
+
+    if (std::find(m_MissingUniforms.begin(), m_MissingUniforms.end(), uniform.hash) == m_MissingUniforms.end())
+    {
+        m_MissingUniforms.push_back(uniform.hash);
+        Console::LOGN(
+            std::string("[ Warning: ] uniform '" )+ uniform.name + "' doesn't exits", Color::YELLOW);
+    }
+    return nullptr;
+}
+
+bool Shader::uniformChanged(UniformSlot *slot, const void *data, size_t size)
+{
+    if (!slot)
+        return false;
+
+    if (slot->hasValue && std::memcmp(slot->value.data(), data, size) == 0)
+    {
+        GLState::countUniform(false);
+        return false;
+    }
+
+    std::memcpy(slot->value.data(), data, size);
+    slot->hasValue = true;
+    GLState::countUniform(true);
+    // headless: counted and cached, but there is nothing to upload to
+    return !GLState::headless();
+}
+
+template <typename Set>
+void Shader::setOnStages(UniformHandle uniform, Set set)
+{
+    bool found = false;
+    for (Shader *const *stage : m_PipelineStages)
+    {
+        if ((*stage)->lookupUniform(uniform.hash) != -1)
+        {
+            set(**stage);
+            found = true;
+        }
+    }
+    if (!found)
+        findUniform(uniform); // warns once
+}
+
+// separable stage programs aren't bound while they draw, so they take
+// ProgramUniform*; plain programs are bound (Bind() before setUniform*)
+void Shader::setUniform1i(UniformHandle uniform, int value)
+{
+    if (!isReady())
+        return;
+    if (isPipeline())
+        return setOnStages(uniform, [&](Shader &stage) { stage.setUniform1i(uniform, value); });
+    UniformSlot *slot = findUniform(uniform);
+    if (!uniformChanged(slot, &value, sizeof(value)))
+        return;
+    if (m_Separable)
+    {
+        GLCall(GLExtensions::ProgramUniform1i(m_renderedId, slot->location, value));
+    }
+    else
+    {
+        GLCall(glUniform1i(slot->location, value));
+    }
+}
+void Shader::setUniform1f(UniformHandle uniform, float value)
+{
+    if (!isReady())
+        return;
+    if (isPipeline())
+        return setOnStages(uniform, [&](Shader &stage) { stage.setUniform1f(uniform, value); });
+    UniformSlot *slot = findUniform(uniform);
+    if (!uniformChanged(slot, &value, sizeof(value)))
+        return;
+    if (m_Separable)
+    {
+        GLCall(GLExtensions::ProgramUniform1f(m_renderedId, slot->location, value));
+    }
+    else
+    {
+        GLCall(glUniform1f(slot->location, value));
+    }
+}
+void Shader::setUniform4f(UniformHandle uniform, float v0, float v1, float v2, float v3)
+{
+    if (!isReady())
+        return;
+    if (isPipeline())
+        return setOnStages(uniform, [&](Shader &stage) { stage.setUniform4f(uniform, v0, v1, v2, v3); });
+    UniformSlot *slot = findUniform(uniform);
+    float values[4] = {v0, v1, v2, v3};
+    if (!uniformChanged(slot, values, sizeof(values)))
+        return;
+    if (m_Separable)
+    {
+        GLCall(GLExtensions::ProgramUniform4f(m_renderedId, slot->location, v0, v1, v2, v3));
+    }
+    else
+    {
+        GLCall(glUniform4f(slot->location, v0, v1, v2, v3));
+    }
+}
+
+void Shader::bindUniformBlock(UniformHandle block, unsigned int binding)
+{
+    if (GLState::headless())
         return;
+    for (const BlockSlot &slot : m_Blocks)
+    {
+        if (slot.hash == block.hash)
+        {
+            GLCall(glUniformBlockBinding(m_renderedId, slot.index, binding));
+            return;
+        }
     }
+}
 
-    glUniformMatrix4fv(loc, 1, GL_FALSE, &matrix[0][0]);
+bool Shader::getUniform(UniformHandle uniform, void *out, size_t size) const
+{
+    for (Shader *const *stage : m_PipelineStages)
+    {
+        if ((*stage)->getUniform(uniform, out, size))
+            return true;
+    }
+    int index = lookupUniform(uniform.hash);
+    if (index == -1 || !m_Uniforms[index].hasValue)
+        return false;
+    std::memcpy(out, m_Uniforms[index].value.data(), size);
+    return true;
+}
+
+void Shader::setUniformMat4f(UniformHandle uniform, const glm::mat4 &matrix)
+{
+    if (!isReady())
+        return;
+    if (isPipeline())
+        return setOnStages(uniform, [&](Shader &stage) { stage.setUniformMat4f(uniform, matrix); });
+    UniformSlot *slot = findUniform(uniform);
+    if (!uniformChanged(slot, &matrix[0][0], sizeof(glm::mat4)))
+        return;
+    if (m_Separable)
+    {
+        GLCall(GLExtensions::ProgramUniformMatrix4fv(m_renderedId, slot->location, 1, GL_FALSE, &matrix[0][0]));
+    }
+    else
+    {
+        GLCall(glUniformMatrix4fv(slot->location, 1, GL_FALSE, &matrix[0][0]));
+    }
+}
+
+void Shader::Dispatch(unsigned int x, unsigned int y, unsigned int z) const
+{
+    if (!isReady() || GLState::headless())
+        return;
+    Bind();
+    GLCall(GLExtensions::DispatchCompute(x, y, z));
 }